@@ -0,0 +1,63 @@
+#include "BlocklistExporter.h"
+#include "BlocklistReader.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+static const std::uint32_t blocklistVersion = 1;
+
+std::string BlocklistExporter::encodeIndex(const std::vector<std::string>& domains) {
+    std::vector<std::uint64_t> hashes;
+    hashes.reserve(domains.size());
+    for(const std::string& domain : domains)
+        hashes.push_back(BlocklistIndexReader::hashDomain(domain));
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+    std::string index = "CCBLKIDX";
+    appendLittleEndian(&index, blocklistVersion, 4);
+    appendLittleEndian(&index, 0, 4);
+    appendLittleEndian(&index, hashes.size(), 8);
+    appendLittleEndian(&index, 0, 8);
+    index.reserve(index.size() + hashes.size() * sizeof(std::uint64_t));
+    for(std::uint64_t hash : hashes)
+        appendLittleEndian(&index, hash, 8);
+    return index;
+}
+
+std::string BlocklistExporter::encodeBloomFilter(const std::vector<std::string>& domains, double falsePositiveRate) {
+    const double ln2 = std::log(2.0);
+    const std::uint32_t maxHashCount = 30;
+
+    // The optimal size is -n ln(p) / ln(2)^2 bits, with ln(2) m / n hashes
+    const double elements = std::max<double>(domains.size(), 1);
+    const std::uint64_t wordCount = ((std::uint64_t)std::ceil(-elements * std::log(falsePositiveRate) / (ln2 * ln2)) + 63) / 64;
+    const std::uint64_t bitCount = wordCount * 64;
+    const std::uint32_t hashCount = std::min(std::max((std::uint32_t)std::round(bitCount / elements * ln2), (std::uint32_t)1), maxHashCount);
+
+    std::vector<std::uint64_t> words(wordCount, 0);
+    for(const std::string& domain : domains) {
+        const std::uint64_t hash = BlocklistIndexReader::hashDomain(domain);
+        for(std::uint32_t i = 0; i < hashCount; i++) {
+            const std::uint64_t bit = BlocklistBloomReader::bitIndex(hash, i, bitCount);
+            words[bit / 64] |= 1ULL << (bit % 64);
+        }
+    }
+
+    std::string filter = "CCBLOOMF";
+    appendLittleEndian(&filter, blocklistVersion, 4);
+    appendLittleEndian(&filter, hashCount, 4);
+    appendLittleEndian(&filter, bitCount, 8);
+    appendLittleEndian(&filter, 0, 8);
+    filter.reserve(filter.size() + wordCount * sizeof(std::uint64_t));
+    for(std::uint64_t word : words)
+        appendLittleEndian(&filter, word, 8);
+    return filter;
+}
+
+void BlocklistExporter::appendLittleEndian(std::string* buffer, std::uint64_t value, int size) {
+    for(int i = 0; i < size; i++)
+        buffer->push_back((char)(value >> (8 * i)));
+}
\ No newline at end of file
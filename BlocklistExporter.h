@@ -0,0 +1,44 @@
+#ifndef BLOCKLISTEXPORTER_H
+#define BLOCKLISTEXPORTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * BlocklistExporter encodes a list of domains as the binary blocklist files read by the blocklist reader library:
+ * a sorted index of domain hashes, and a Bloom filter. See BlocklistReader.h for the file formats.
+ */
+class BlocklistExporter {
+    public:
+
+        /**
+         * Encodes a blocklist index.
+         * 
+         * @param domains the domains to encode. Duplicates are allowed.
+         * @return the contents of the index file.
+         */
+        static std::string encodeIndex(const std::vector<std::string>& domains);
+
+        /**
+         * Encodes a blocklist Bloom filter, sized for the domains at a false positive rate.
+         * 
+         * @param domains the domains to encode.
+         * @param falsePositiveRate the rate at which domains not in the list are reported as present.
+         * @return the contents of the Bloom filter file.
+         */
+        static std::string encodeBloomFilter(const std::vector<std::string>& domains, double falsePositiveRate);
+
+    private:
+
+        /**
+         * Appends a little-endian integer to a buffer.
+         * 
+         * @param[out] buffer a pointer to the buffer.
+         * @param value the integer.
+         * @param size the size of the integer in bytes.
+         */
+        static void appendLittleEndian(std::string* buffer, std::uint64_t value, int size);
+};
+
+#endif
\ No newline at end of file
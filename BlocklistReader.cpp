@@ -0,0 +1,245 @@
+#include "BlocklistReader.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// The size of both files' headers
+static const std::uint64_t headerSize = 32;
+static const std::uint32_t blocklistVersion = 1;
+
+/**
+ * Mixes the bits of a 64-bit value with the finalizer of MurmurHash3.
+ * 
+ * @param value the value to mix.
+ * @return the mixed value.
+ */
+static std::uint64_t mix(std::uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+/**
+ * Reads a little-endian integer from a mapped header.
+ * 
+ * @param bytes a pointer to the integer's first byte.
+ * @param size the size of the integer in bytes.
+ * @return the integer.
+ */
+static std::uint64_t readLittleEndian(const unsigned char* bytes, int size) {
+    std::uint64_t value = 0;
+    for(int i = 0; i < size; i++)
+        value |= (std::uint64_t)bytes[i] << (8 * i);
+    return value;
+}
+
+/**
+ * Checks a mapped file's magic string and version.
+ * 
+ * @param file the mapped file.
+ * @param magic the expected 8-byte magic string.
+ * @return true if the file is large enough for a header, and the header matches, false otherwise.
+ */
+static bool checkHeader(const MappedFile& file, const char* magic) {
+    return file.size() >= headerSize && std::memcmp(file.data(), magic, 8) == 0 && readLittleEndian(file.data() + 8, 4) == blocklistVersion;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(handle == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(handle);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mapping == NULL) {
+        CloseHandle(handle);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(view == NULL) {
+        CloseHandle(mapping);
+        CloseHandle(handle);
+        return false;
+    }
+    fileHandle = handle;
+    mappingHandle = mapping;
+    bytes = (const unsigned char*)view;
+    byteCount = fileSize.QuadPart;
+#else
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if(descriptor < 0)
+        return false;
+    struct stat status;
+    if(fstat(descriptor, &status) != 0 || status.st_size == 0) {
+        ::close(descriptor);
+        return false;
+    }
+    void* view = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+    // The mapping keeps the file alive, so the descriptor is not needed once it exists
+    ::close(descriptor);
+    if(view == MAP_FAILED)
+        return false;
+    bytes = (const unsigned char*)view;
+    byteCount = status.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if(!bytes)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(bytes);
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    munmap((void*)bytes, byteCount);
+#endif
+    bytes = nullptr;
+    byteCount = 0;
+}
+
+const unsigned char* MappedFile::data() const {
+    return bytes;
+}
+
+std::uint64_t MappedFile::size() const {
+    return byteCount;
+}
+
+bool BlocklistIndexReader::open(const std::string& path) {
+    hashes = nullptr;
+    hashCount = 0;
+    if(!file.open(path))
+        return false;
+    if(!checkHeader(file, "CCBLKIDX")) {
+        file.close();
+        return false;
+    }
+    const std::uint64_t count = readLittleEndian(file.data() + 16, 8);
+    if((file.size() - headerSize) / sizeof(std::uint64_t) < count) {
+        file.close();
+        return false;
+    }
+    // The header is 32 bytes and mappings are page aligned, so the hashes are aligned for direct reads
+    hashes = (const std::uint64_t*)(file.data() + headerSize);
+    hashCount = count;
+    return true;
+}
+
+bool BlocklistIndexReader::contains(std::string_view domain) const {
+    return containsHash(hashDomain(domain));
+}
+
+bool BlocklistIndexReader::matchesSuffix(std::string_view domain) const {
+    if(!domain.empty() && domain.back() == '.')
+        domain.remove_suffix(1);
+    while(!domain.empty()) {
+        if(containsHash(hashDomain(domain)))
+            return true;
+        const std::size_t dot = domain.find('.');
+        if(dot == std::string_view::npos)
+            break;
+        domain.remove_prefix(dot + 1);
+    }
+    return false;
+}
+
+std::uint64_t BlocklistIndexReader::size() const {
+    return hashCount;
+}
+
+std::uint64_t BlocklistIndexReader::hashDomain(std::string_view domain) {
+    const std::uint64_t fnvOffsetBasis = 14695981039346656037ULL;
+    const std::uint64_t fnvPrime = 1099511628211ULL;
+
+    if(!domain.empty() && domain.back() == '.')
+        domain.remove_suffix(1);
+    std::uint64_t result = fnvOffsetBasis;
+    for(char c : domain) {
+        if(c >= 'A' && c <= 'Z')
+            c = c - 'A' + 'a';
+        result ^= (unsigned char)c;
+        result *= fnvPrime;
+    }
+    return mix(result);
+}
+
+bool BlocklistIndexReader::containsHash(std::uint64_t hash) const {
+    std::uint64_t low = 0;
+    std::uint64_t high = hashCount;
+    while(low < high) {
+        const std::uint64_t middle = low + (high - low) / 2;
+        if(hashes[middle] < hash)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low < hashCount && hashes[low] == hash;
+}
+
+bool BlocklistBloomReader::open(const std::string& path) {
+    // Guards against a corrupt header asking for an absurd number of probes
+    const std::uint64_t maxHashCount = 64;
+
+    words = nullptr;
+    bitCount = 0;
+    hashCount = 0;
+    if(!file.open(path))
+        return false;
+    if(!checkHeader(file, "CCBLOOMF")) {
+        file.close();
+        return false;
+    }
+    const std::uint64_t savedHashCount = readLittleEndian(file.data() + 12, 4);
+    const std::uint64_t savedBitCount = readLittleEndian(file.data() + 16, 8);
+    if(savedHashCount == 0 || savedHashCount > maxHashCount || savedBitCount == 0 || (file.size() - headerSize) / sizeof(std::uint64_t) < (savedBitCount + 63) / 64) {
+        file.close();
+        return false;
+    }
+    words = (const std::uint64_t*)(file.data() + headerSize);
+    bitCount = savedBitCount;
+    hashCount = savedHashCount;
+    return true;
+}
+
+bool BlocklistBloomReader::mayContain(std::string_view domain) const {
+    if(bitCount == 0)
+        return false;
+    const std::uint64_t hash = BlocklistIndexReader::hashDomain(domain);
+    for(std::uint32_t i = 0; i < hashCount; i++) {
+        const std::uint64_t bit = bitIndex(hash, i, bitCount);
+        if((words[bit / 64] & (1ULL << (bit % 64))) == 0)
+            return false;
+    }
+    return true;
+}
+
+std::uint64_t BlocklistBloomReader::bitIndex(std::uint64_t hash, std::uint32_t i, std::uint64_t bitCount) {
+    // Double hashing. The second hash is odd, so the bit positions don't repeat early
+    const std::uint64_t secondHash = mix(hash ^ 0x9e3779b97f4a7c15ULL) | 1;
+    return (hash + i * secondHash) % bitCount;
+}
\ No newline at end of file
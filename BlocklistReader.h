@@ -0,0 +1,182 @@
+#ifndef BLOCKLISTREADER_H
+#define BLOCKLISTREADER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * The blocklist reader library: memory-mapped readers for the binary blocklist files written by BlocklistExporter.
+ * 
+ * This header and BlocklistReader.cpp depend only on the standard library and the operating system, so lookup
+ * services can build them on their own.
+ * 
+ * Both files start with a 32-byte header: an 8-byte magic string, a 32-bit version, then fields specific to the
+ * file. Every value is stored little-endian, and read in place, so the readers assume a little-endian host.
+ * 
+ * Domains are hashed with 64-bit FNV-1a over their lowercased bytes, without a trailing dot, followed by the
+ * MurmurHash3 finalizer.
+ */
+
+/**
+ * MappedFile maps a whole file into memory, read-only.
+ */
+class MappedFile {
+    public:
+
+        // Default constructor
+        MappedFile() = default;
+
+        // Unmaps the file.
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /**
+         * Maps a file, unmapping any file mapped before.
+         * 
+         * @param path the file to map.
+         * @return true if the file was mapped, false otherwise.
+         */
+        bool open(const std::string& path);
+
+        // Unmaps the file.
+        void close();
+
+        /**
+         * Gets the mapped bytes.
+         * 
+         * @return a pointer to the first byte of the file, or nullptr if no file is mapped.
+         */
+        const unsigned char* data() const;
+
+        /**
+         * Gets the size of the mapped file.
+         * 
+         * @return the size in bytes.
+         */
+        std::uint64_t size() const;
+
+    private:
+        const unsigned char* bytes = nullptr;
+        std::uint64_t byteCount = 0;
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+};
+
+/**
+ * BlocklistIndexReader answers membership queries against a blocklist index: a sorted array of unique domain
+ * hashes, searched in place.
+ * 
+ * The header holds the magic "CCBLKIDX", the version, 4 reserved bytes, the number of hashes, and 8 reserved bytes.
+ * The hashes follow, in ascending order.
+ */
+class BlocklistIndexReader {
+    public:
+
+        // Default constructor
+        BlocklistIndexReader() = default;
+
+        /**
+         * Maps an index file, and checks its header.
+         * 
+         * @param path the index file.
+         * @return true if the index is ready for queries, false if it could not be mapped or is malformed.
+         */
+        bool open(const std::string& path);
+
+        /**
+         * Checks whether a domain is in the index.
+         * 
+         * @param domain the domain. Case and a trailing dot are ignored.
+         * @return true if the domain is in the index, false otherwise. Hash collisions give rare false positives.
+         */
+        bool contains(std::string_view domain) const;
+
+        /**
+         * Checks whether a domain, or any domain it is a subdomain of, is in the index. For "a.pool.example.com",
+         * "a.pool.example.com", "pool.example.com", "example.com" and "com" are checked.
+         * 
+         * @param domain the domain. Case and a trailing dot are ignored.
+         * @return true if the domain or one of its parents is in the index, false otherwise.
+         */
+        bool matchesSuffix(std::string_view domain) const;
+
+        /**
+         * Gets the number of domains in the index.
+         * 
+         * @return the number of hashes.
+         */
+        std::uint64_t size() const;
+
+        /**
+         * Hashes a domain the way the blocklist files do.
+         * 
+         * @param domain the domain. Case and a trailing dot are ignored.
+         * @return the hash.
+         */
+        static std::uint64_t hashDomain(std::string_view domain);
+
+    private:
+        MappedFile file;
+        const std::uint64_t* hashes = nullptr;
+        std::uint64_t hashCount = 0;
+
+        /**
+         * Searches the index for a hash.
+         * 
+         * @param hash the hash to search for.
+         * @return true if the hash is in the index, false otherwise.
+         */
+        bool containsHash(std::uint64_t hash) const;
+};
+
+/**
+ * BlocklistBloomReader answers approximate membership queries against a serialized blocklist Bloom filter.
+ * 
+ * The header holds the magic "CCBLOOMF", the version, the number of hashes per domain, the number of bits, and
+ * 8 reserved bytes. The bits follow as 64-bit words, bit i being bit i % 64 of word i / 64.
+ */
+class BlocklistBloomReader {
+    public:
+
+        // Default constructor
+        BlocklistBloomReader() = default;
+
+        /**
+         * Maps a Bloom filter file, and checks its header.
+         * 
+         * @param path the Bloom filter file.
+         * @return true if the filter is ready for queries, false if it could not be mapped or is malformed.
+         */
+        bool open(const std::string& path);
+
+        /**
+         * Checks whether the filter may hold a domain.
+         * 
+         * @param domain the domain. Case and a trailing dot are ignored.
+         * @return false if the domain is definitely not in the blocklist, true if it may be.
+         */
+        bool mayContain(std::string_view domain) const;
+
+        /**
+         * Gets the bit a domain's hash sets for one of the filter's hash functions.
+         * 
+         * @param hash the domain's hash, from BlocklistIndexReader::hashDomain.
+         * @param i the index of the hash function.
+         * @param bitCount the number of bits in the filter.
+         * @return the index of the bit.
+         */
+        static std::uint64_t bitIndex(std::uint64_t hash, std::uint32_t i, std::uint64_t bitCount);
+
+    private:
+        MappedFile file;
+        const std::uint64_t* words = nullptr;
+        std::uint64_t bitCount = 0;
+        std::uint32_t hashCount = 0;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "BloomFilter.h"
+#include "Checkpoint.h"
+#include "StringHash.h"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+BloomFilter::BloomFilter(std::uint64_t expectedElements, double falsePositiveRate) {
+    const double ln2 = std::log(2.0);
+    const int maxHashCount = 30;
+
+    if(expectedElements == 0)
+        expectedElements = 1;
+    if(falsePositiveRate <= 0 || falsePositiveRate >= 1)
+        falsePositiveRate = 0.001;
+
+    // The optimal size is -n ln(p) / ln(2)^2 bits, with ln(2) m / n hashes
+    bitCount = (std::uint64_t)std::ceil(-(double)expectedElements * std::log(falsePositiveRate) / (ln2 * ln2));
+    wordCount = (bitCount + 63) / 64;
+    bitCount = wordCount * 64;
+    hashCount = (int)std::round((double)bitCount / expectedElements * ln2);
+    if(hashCount < 1)
+        hashCount = 1;
+    if(hashCount > maxHashCount)
+        hashCount = maxHashCount;
+
+    words.reset(new std::atomic<std::uint64_t>[wordCount]);
+    for(std::uint64_t i = 0; i < wordCount; i++)
+        words[i].store(0, std::memory_order_relaxed);
+}
+
+bool BloomFilter::insert(std::string_view element) {
+    if(bitCount == 0)
+        return true;
+    const std::uint64_t h1 = StringHash::hash(element);
+    // The second hash is odd, so the bit positions don't repeat early
+    const std::uint64_t h2 = StringHash::mix(h1 ^ 0x9e3779b97f4a7c15ULL) | 1;
+    bool added = false;
+    for(int i = 0; i < hashCount; i++) {
+        const std::uint64_t bit = (h1 + i * h2) % bitCount;
+        const std::uint64_t mask = 1ULL << (bit % 64);
+        if((words[bit / 64].fetch_or(mask, std::memory_order_relaxed) & mask) == 0)
+            added = true;
+    }
+    return added;
+}
+
+bool BloomFilter::mayContain(std::string_view element) const {
+    if(bitCount == 0)
+        return false;
+    const std::uint64_t h1 = StringHash::hash(element);
+    const std::uint64_t h2 = StringHash::mix(h1 ^ 0x9e3779b97f4a7c15ULL) | 1;
+    for(int i = 0; i < hashCount; i++) {
+        const std::uint64_t bit = (h1 + i * h2) % bitCount;
+        if((words[bit / 64].load(std::memory_order_relaxed) & (1ULL << (bit % 64))) == 0)
+            return false;
+    }
+    return true;
+}
+
+std::uint64_t BloomFilter::sizeInBytes() const {
+    return wordCount * sizeof(std::uint64_t);
+}
+
+void BloomFilter::saveState(CheckpointWriter* writer) const {
+    writer->writeUint(wordCount);
+    writer->writeUint(hashCount);
+    for(std::uint64_t i = 0; i < wordCount; i++)
+        writer->writeUint(words[i].load(std::memory_order_relaxed));
+}
+
+bool BloomFilter::loadState(CheckpointReader* reader) {
+    const std::uint64_t maxHashCount = 30;
+
+    std::uint64_t savedWordCount;
+    std::uint64_t savedHashCount;
+    if(!reader->readUint(&savedWordCount) || !reader->readUint(&savedHashCount))
+        return false;
+    // Each word takes 8 bytes, so a count the rest of the checkpoint can't hold is corrupt
+    if(savedWordCount > reader->remaining() / sizeof(std::uint64_t) || savedHashCount == 0 || savedHashCount > maxHashCount)
+        return false;
+
+    std::unique_ptr<std::atomic<std::uint64_t>[]> savedWords(new std::atomic<std::uint64_t>[savedWordCount]);
+    for(std::uint64_t i = 0; i < savedWordCount; i++) {
+        std::uint64_t word;
+        if(!reader->readUint(&word))
+            return false;
+        savedWords[i].store(word, std::memory_order_relaxed);
+    }
+    words = std::move(savedWords);
+    wordCount = savedWordCount;
+    bitCount = savedWordCount * 64;
+    hashCount = savedHashCount;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include "Checkpoint.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+/**
+ * BloomFilter is a fixed-size approximate membership filter over strings.
+ * 
+ * The filter never reports a string it holds as missing, and reports a string it doesn't hold as present at the
+ * false positive rate it was sized for. The bit array is sized from the expected number of strings and the false
+ * positive rate, and the k bit positions of a string are derived from one 64-bit hash by double hashing.
+ * 
+ * The bits are atomic words, so the filter is thread-safe without a lock.
+ */
+class BloomFilter {
+    public:
+
+        // Default constructor
+        BloomFilter() = default;
+
+        /**
+         * Constructor.
+         * 
+         * @param expectedElements the number of strings the filter is sized for.
+         * @param falsePositiveRate the rate at which missing strings are reported as present, once the filter holds expectedElements strings.
+         */
+        BloomFilter(std::uint64_t expectedElements, double falsePositiveRate);
+
+        /**
+         * Adds a string to the filter.
+         * 
+         * @param element the string to add.
+         * @return true if the string was definitely not in the filter before, false if it may have been.
+         */
+        bool insert(std::string_view element);
+
+        /**
+         * Checks whether the filter may hold a string.
+         * 
+         * @param element the string to check.
+         * @return false if the string is definitely not in the filter, true if it may be.
+         */
+        bool mayContain(std::string_view element) const;
+
+        /**
+         * Gets the size of the filter's bit array.
+         * 
+         * @return the size of the bit array in bytes.
+         */
+        std::uint64_t sizeInBytes() const;
+
+        /**
+         * Writes the filter's geometry and bits to a checkpoint.
+         * 
+         * @param writer a pointer to the checkpoint writer.
+         */
+        void saveState(CheckpointWriter* writer) const;
+
+        /**
+         * Replaces the filter with one saved to a checkpoint. Must not be called while the filter is in use.
+         * 
+         * @param reader a pointer to the checkpoint reader.
+         * @return true if the filter was read, false if the checkpoint is corrupt.
+         */
+        bool loadState(CheckpointReader* reader);
+
+    private:
+        std::unique_ptr<std::atomic<std::uint64_t>[]> words;
+        std::uint64_t wordCount = 0;
+        std::uint64_t bitCount = 0;
+        int hashCount = 0;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "Checkpoint.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+CheckpointWriter::CheckpointWriter(std::string checkpointFile) {
+    path = checkpointFile;
+    temporaryPath = checkpointFile + ".tmp";
+    file = std::fopen(temporaryPath.c_str(), "wb");
+    failed = file == NULL;
+    holding = false;
+    if(failed)
+        std::cout << "ERROR: Could Not Open Checkpoint: " << temporaryPath << "\n";
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    if(file) {
+        std::fclose(file);
+        std::remove(temporaryPath.c_str());
+    }
+}
+
+void CheckpointWriter::writeUint(std::uint64_t value) {
+    unsigned char bytes[8];
+    for(int i = 0; i < 8; i++)
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    append(bytes, sizeof(bytes));
+}
+
+void CheckpointWriter::writeInt(std::int64_t value) {
+    writeUint((std::uint64_t)value);
+}
+
+void CheckpointWriter::writeDouble(double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeUint(bits);
+}
+
+void CheckpointWriter::writeString(std::string_view value) {
+    writeUint(value.size());
+    append(value.data(), value.size());
+}
+
+void CheckpointWriter::holdWrites() {
+    holding = true;
+}
+
+void CheckpointWriter::releaseWrites() {
+    holding = false;
+    flushBuffer();
+    // The held writes can be as large as the state, so their memory is given back
+    std::string().swap(buffer);
+}
+
+void CheckpointWriter::append(const void* data, std::size_t size) {
+    const std::size_t flushBytes = 1024 * 1024;
+    if(failed)
+        return;
+    buffer.append((const char*)data, size);
+    if(!holding && buffer.size() >= flushBytes)
+        flushBuffer();
+}
+
+void CheckpointWriter::flushBuffer() {
+    if(!failed && !buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size())
+        failed = true;
+    buffer.clear();
+}
+
+bool CheckpointWriter::commit() {
+    releaseWrites();
+    if(failed) {
+        std::cout << "ERROR: Could Not Write Checkpoint: " << temporaryPath << "\n";
+        return false;
+    }
+    // The data must reach the disk before the rename does, or a crash could leave a renamed but empty checkpoint
+    bool synced = std::fflush(file) == 0;
+#ifdef _WIN32
+    synced = synced && _commit(_fileno(file)) == 0;
+#else
+    synced = synced && fsync(fileno(file)) == 0;
+#endif
+    const bool closed = std::fclose(file) == 0;
+    file = NULL;
+    if(!synced || !closed) {
+        std::cout << "ERROR: Could Not Flush Checkpoint: " << temporaryPath << "\n";
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if(error) {
+        std::cout << "ERROR: Could Not Replace Checkpoint: " << path << "\n";
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+CheckpointReader::CheckpointReader(std::string checkpointFile) {
+    std::error_code error;
+    file = std::fopen(checkpointFile.c_str(), "rb");
+    failed = file == NULL;
+    unreadBytes = failed ? 0 : std::filesystem::file_size(checkpointFile, error);
+    if(error)
+        unreadBytes = 0;
+}
+
+CheckpointReader::~CheckpointReader() {
+    if(file)
+        std::fclose(file);
+}
+
+bool CheckpointReader::isOpen() {
+    return file != NULL;
+}
+
+bool CheckpointReader::good() {
+    return !failed;
+}
+
+bool CheckpointReader::readUint(std::uint64_t* value) {
+    unsigned char bytes[8];
+    if(failed || std::fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes)) {
+        failed = true;
+        return false;
+    }
+    unreadBytes -= unreadBytes < sizeof(bytes) ? unreadBytes : sizeof(bytes);
+    *value = 0;
+    for(int i = 0; i < 8; i++)
+        *value |= (std::uint64_t)bytes[i] << (8 * i);
+    return true;
+}
+
+bool CheckpointReader::readInt(std::int64_t* value) {
+    std::uint64_t bits;
+    if(!readUint(&bits))
+        return false;
+    *value = (std::int64_t)bits;
+    return true;
+}
+
+bool CheckpointReader::readDouble(double* value) {
+    std::uint64_t bits;
+    if(!readUint(&bits))
+        return false;
+    std::memcpy(value, &bits, sizeof(bits));
+    return true;
+}
+
+bool CheckpointReader::readString(std::string* value) {
+    // Strings are URLs, domains, and spill records, so a longer length means the checkpoint is corrupt
+    const std::uint64_t maxStringSize = 16 * 1024 * 1024;
+    std::uint64_t size;
+    if(!readUint(&size) || size > maxStringSize) {
+        failed = true;
+        return false;
+    }
+    value->resize(size);
+    if(size > 0 && std::fread(value->data(), 1, size, file) != size) {
+        failed = true;
+        return false;
+    }
+    unreadBytes -= unreadBytes < size ? unreadBytes : size;
+    return true;
+}
+
+std::uint64_t CheckpointReader::remaining() {
+    return unreadBytes;
+}
\ No newline at end of file
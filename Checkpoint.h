@@ -0,0 +1,185 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+/**
+ * CheckpointWriter writes a binary snapshot of the program's state.
+ * 
+ * The snapshot is written to a temporary file next to the checkpoint. On commit, the temporary file is flushed to
+ * disk, then renamed over the checkpoint, so a crash at any point leaves either the old or the new checkpoint whole.
+ * 
+ * Writes go through an in-memory buffer. While writes are held, the buffer is not written out at all, so state can be
+ * copied while the program is paused, and written to disk once it has resumed.
+ * 
+ * Integers are written as 64-bit little-endian values, and strings as their length followed by their bytes.
+ */
+class CheckpointWriter {
+    public:
+
+        /**
+         * Constructor. Opens the temporary file.
+         * 
+         * @param checkpointFile the path of the checkpoint.
+         */
+        CheckpointWriter(std::string checkpointFile);
+
+        // Closes and deletes the temporary file if the checkpoint was not committed.
+        ~CheckpointWriter();
+
+        CheckpointWriter(const CheckpointWriter&) = delete;
+        CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+        /**
+         * Writes an unsigned integer.
+         * 
+         * @param value the value to write.
+         */
+        void writeUint(std::uint64_t value);
+
+        /**
+         * Writes a signed integer.
+         * 
+         * @param value the value to write.
+         */
+        void writeInt(std::int64_t value);
+
+        /**
+         * Writes a double.
+         * 
+         * @param value the value to write.
+         */
+        void writeDouble(double value);
+
+        /**
+         * Writes a string.
+         * 
+         * @param value the value to write.
+         */
+        void writeString(std::string_view value);
+
+        /**
+         * Keeps every later write in memory, until the writes are released.
+         */
+        void holdWrites();
+
+        /**
+         * Writes the held writes to the temporary file, and lets later writes through.
+         */
+        void releaseWrites();
+
+        /**
+         * Flushes the temporary file to disk, and renames it over the checkpoint.
+         * 
+         * @return true if the checkpoint was replaced, false if any write failed.
+         */
+        bool commit();
+
+    private:
+        std::string path;
+        std::string temporaryPath;
+        std::FILE* file;
+        bool failed;
+
+        std::string buffer;
+        bool holding;
+
+        /**
+         * Appends bytes to the buffer, and writes the buffer to the file once it is full, unless writes are held.
+         * 
+         * @param data the bytes to append.
+         * @param size the number of bytes to append.
+         */
+        void append(const void* data, std::size_t size);
+
+        /**
+         * Writes the buffer to the temporary file, and empties it.
+         */
+        void flushBuffer();
+};
+
+/**
+ * CheckpointReader reads a snapshot written by CheckpointWriter.
+ * 
+ * Once a read fails, every later read fails too, so a snapshot can be read field by field and checked once.
+ */
+class CheckpointReader {
+    public:
+
+        /**
+         * Constructor. Opens the checkpoint.
+         * 
+         * @param checkpointFile the path of the checkpoint.
+         */
+        CheckpointReader(std::string checkpointFile);
+
+        // Closes the checkpoint.
+        ~CheckpointReader();
+
+        CheckpointReader(const CheckpointReader&) = delete;
+        CheckpointReader& operator=(const CheckpointReader&) = delete;
+
+        /**
+         * Checks whether the checkpoint exists and was opened.
+         * 
+         * @return true if the checkpoint is open, false otherwise.
+         */
+        bool isOpen();
+
+        /**
+         * Checks whether every read so far has succeeded.
+         * 
+         * @return true if no read has failed, false otherwise.
+         */
+        bool good();
+
+        /**
+         * Reads an unsigned integer.
+         * 
+         * @param[out] value the value read.
+         * @return true if the value was read, false otherwise.
+         */
+        bool readUint(std::uint64_t* value);
+
+        /**
+         * Reads a signed integer.
+         * 
+         * @param[out] value the value read.
+         * @return true if the value was read, false otherwise.
+         */
+        bool readInt(std::int64_t* value);
+
+        /**
+         * Reads a double.
+         * 
+         * @param[out] value the value read.
+         * @return true if the value was read, false otherwise.
+         */
+        bool readDouble(double* value);
+
+        /**
+         * Reads a string.
+         * 
+         * @param[out] value the value read.
+         * @return true if the value was read, false otherwise.
+         */
+        bool readString(std::string* value);
+
+        /**
+         * Gets the number of bytes not read yet, so a length read from the checkpoint can be checked before it is
+         * allocated.
+         * 
+         * @return the number of unread bytes.
+         */
+        std::uint64_t remaining();
+
+    private:
+        std::FILE* file;
+        bool failed;
+        std::uint64_t unreadBytes;
+};
+
+#endif
\ No newline at end of file
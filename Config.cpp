@@ -17,7 +17,7 @@ Config::Config() {
 
 std::string Config::getConfig(std::string configKey, std::string defaultValue) {
     std::unordered_map<std::string, std::string>::iterator it = configMap.find(configKey);
-    if(!configMap.empty() && it == configMap.end()) {
+    if(!configMap.empty() && it != configMap.end()) {
         return it->second;
     }
     return defaultValue;
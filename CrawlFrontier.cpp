@@ -0,0 +1,404 @@
+#include "CrawlFrontier.h"
+#include "Checkpoint.h"
+#include "Config.h"
+#include "DomainInternTable.h"
+#include "SpillQueue.h"
+#include "ThreadSafeQueue.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Encodes a URL as a spill record: the score, the depth, the length of the host, the host, then the URL. The host is
+ * written out in full, so spilled URLs hold no ids.
+ * 
+ * @param url the URL.
+ * @param host the host of the URL.
+ * @param score the score of the URL.
+ * @param depth the depth of the URL.
+ * @return the encoded record.
+ */
+static std::string encodeSpilledUrl(const std::string& url, std::string_view host, double score, int depth) {
+    const std::uint32_t hostLength = host.size();
+    std::string record(sizeof(score) + sizeof(depth) + sizeof(hostLength), '\0');
+    std::memcpy(&record[0], &score, sizeof(score));
+    std::memcpy(&record[sizeof(score)], &depth, sizeof(depth));
+    std::memcpy(&record[sizeof(score) + sizeof(depth)], &hostLength, sizeof(hostLength));
+    record += host;
+    record += url;
+    return record;
+}
+
+/**
+ * Decodes a spill record written by encodeSpilledUrl.
+ * 
+ * @param[in] record the record to decode.
+ * @param[out] url the URL.
+ * @param[out] host the host of the URL.
+ * @param[out] score the score of the URL.
+ * @param[out] depth the depth of the URL.
+ * @return true if the record was decoded, false if it is malformed.
+ */
+static bool decodeSpilledUrl(const std::string& record, std::string* url, std::string* host, double* score, int* depth) {
+    std::uint32_t hostLength;
+    const std::size_t headerSize = sizeof(*score) + sizeof(*depth) + sizeof(hostLength);
+    if(record.size() < headerSize)
+        return false;
+    std::memcpy(score, &record[0], sizeof(*score));
+    std::memcpy(depth, &record[sizeof(*score)], sizeof(*depth));
+    std::memcpy(&hostLength, &record[sizeof(*score) + sizeof(*depth)], sizeof(hostLength));
+    if(record.size() - headerSize < hostLength)
+        return false;
+    host->assign(record, headerSize, hostLength);
+    url->assign(record, headerSize + hostLength, std::string::npos);
+    return true;
+}
+
+bool CrawlFrontier::frontierUrlOrder::operator()(const frontierUrl& a, const frontierUrl& b) const {
+    if(a.score != b.score)
+        return a.score < b.score;
+    return a.sequence > b.sequence;
+}
+
+bool CrawlFrontier::hostRankOrder::operator()(const hostRank& a, const hostRank& b) const {
+    return a.priority < b.priority;
+}
+
+CrawlFrontier::CrawlFrontier(Config* config, DomainInternTable* dTable) {
+    const int defaultDepthDecayPercent = 50;
+    const int defaultLowWatermark = 1000;
+    const int defaultMaxPendingUrls = 100000;
+    const int defaultMaxMemoryUrls = 1000000;
+    const std::string defaultSpillDirectory = "frontier_spill";
+    const std::uint64_t spillSegmentBytes = 64 * 1024 * 1024;
+    const int defaultSpillReloadBatch = 10000;
+    const std::size_t defaultMinHostRanks = 1024;
+
+    domainTable = dTable;
+    depthDecay = config->getIntConfig("Frontier_DepthDecayPercent", defaultDepthDecayPercent, 0, 100) / 100.0;
+    lowWatermark = config->getIntConfig("Frontier_LowWatermark", defaultLowWatermark, 1, INT_MAX);
+    maxPendingUrls = config->getIntConfig("Frontier_MaxPendingUrls", defaultMaxPendingUrls, 1, INT_MAX);
+    maxMemoryUrls = config->getIntConfig("Frontier_MaxMemoryUrls", defaultMaxMemoryUrls, 1, INT_MAX);
+    spill = new SpillQueue(config->getConfig("Frontier_SpillDirectory", defaultSpillDirectory), spillSegmentBytes);
+    spillReloadBatch = defaultSpillReloadBatch;
+    minHostRanks = defaultMinHostRanks;
+
+    sequence = 0;
+    rankVersion = 0;
+    queuedUrls = 0;
+}
+
+CrawlFrontier::~CrawlFrontier() {
+    delete spill;
+}
+
+double CrawlFrontier::scoreLinks(int termsFound, int pageDepth) {
+    return termsFound * std::pow(depthDecay, pageDepth);
+}
+
+void CrawlFrontier::push(const std::string& url, std::uint32_t hostId, double score, int depth) {
+    push(std::vector<queuedUrl> {queuedUrl {url, hostId}}, score, depth);
+}
+
+void CrawlFrontier::push(const std::vector<queuedUrl>& urls, double score, int depth) {
+    // The URLs which don't fit in the window, by their index in urls
+    std::vector<std::size_t> overflow;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        for(std::size_t i = 0; i < urls.size(); i++) {
+            if(spill && queuedUrls >= maxMemoryUrls)
+                overflow.push_back(i);
+            else
+                queueInMemory(urls[i].url, urls[i].hostId, score, depth);
+        }
+    }
+    if(overflow.empty())
+        return;
+
+    // Once the window is full, URLs are spilled. If the spill fails, the URLs are kept in memory rather than lost
+    std::size_t spilled = 0;
+    {
+        std::lock_guard<std::mutex> lock(spillMutex);
+        while(spilled < overflow.size()) {
+            const queuedUrl& it = urls[overflow[spilled]];
+            if(!spill->push(encodeSpilledUrl(it.url, domainTable->lookup(it.hostId), score, depth)))
+                break;
+            spilled++;
+        }
+    }
+    if(spilled == overflow.size())
+        return;
+    std::lock_guard<std::mutex> lock(mu);
+    for(std::size_t i = spilled; i < overflow.size(); i++)
+        queueInMemory(urls[overflow[i]].url, urls[overflow[i]].hostId, score, depth);
+}
+
+void CrawlFrontier::queueInMemory(const std::string& url, std::uint32_t hostId, double score, int depth) {
+    hostQueue& queue = hosts[hostId];
+    queue.urls.push_back(frontierUrl {url, score, depth, sequence++});
+    std::push_heap(queue.urls.begin(), queue.urls.end(), frontierUrlOrder());
+    queuedUrls++;
+    // A host is only reranked if the new URL is its best
+    if(!queue.ranked || score > queue.rankedScore)
+        rankHost(hostId, &queue);
+}
+
+bool CrawlFrontier::refill(ThreadSafeQueue<std::string>* urlQueue) {
+    bool released = false;
+    while(urlQueue->size() < lowWatermark) {
+        std::string url;
+        std::uint32_t hostId;
+        int depth;
+        reloadSpilledUrls();
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            if(!pop(&url, &hostId, &depth))
+                break;
+            // Fetched and failed transfers take their depths back, but URLs dropped before they are fetched, and
+            // successful transfers with an empty body, are never reported, so their depths are forgotten in the order
+            // they were released once the limit is reached
+            // A URL released again replaces its earlier release, which is skipped when it reaches the front
+            pendingUrls.insert_or_assign(url, pendingUrl {hostId, depth, sequence});
+            pendingOrder.push(pendingRelease {url, sequence++});
+            while(pendingOrder.size() > maxPendingUrls) {
+                std::unordered_map<std::string, pendingUrl>::iterator it = pendingUrls.find(pendingOrder.front().url);
+                if(it != pendingUrls.end() && it->second.sequence == pendingOrder.front().sequence)
+                    pendingUrls.erase(it);
+                pendingOrder.pop();
+            }
+        }
+        urlQueue->push(url);
+        released = true;
+    }
+    return released;
+}
+
+int CrawlFrontier::takeDepth(const std::string& url) {
+    std::lock_guard<std::mutex> lock(mu);
+    std::unordered_map<std::string, pendingUrl>::iterator it = pendingUrls.find(url);
+    if(it == pendingUrls.end())
+        return 0;
+    const int depth = it->second.depth;
+    // The URL stays in pendingOrder, and is skipped when it reaches the front
+    pendingUrls.erase(it);
+    return depth;
+}
+
+void CrawlFrontier::saveState(CheckpointWriter* writer) {
+    // Spilled URLs are already on disk, so only their place in the spill is written, first, so it is adopted on resume
+    // before anything else is queued
+    std::unique_lock<std::mutex> spillLock(spillMutex);
+    if(holdingSavedSpill)
+        spill->releaseSnapshot(savedSpill);
+    holdingSavedSpill = spill != nullptr;
+    if(spill)
+        spill->takeSnapshot(&savedSpill);
+    writer->writeInt(savedSpill.firstSegment);
+    writer->writeUint(savedSpill.firstOffset);
+    writer->writeUint(holdingSavedSpill ? savedSpill.segmentRecords.size() : 0);
+    for(std::size_t i = 0; holdingSavedSpill && i < savedSpill.segmentRecords.size(); i++)
+        writer->writeInt(savedSpill.segmentRecords[i]);
+    spillLock.unlock();
+
+    std::lock_guard<std::mutex> lock(mu);
+    writer->writeUint(pendingUrls.size());
+    for(const std::pair<const std::string, pendingUrl>& pending : pendingUrls) {
+        writer->writeString(pending.first);
+        writer->writeString(domainTable->lookup(pending.second.hostId));
+        writer->writeInt(pending.second.depth);
+    }
+
+    writer->writeUint(queuedUrls);
+    for(const std::pair<const std::uint32_t, hostQueue>& host : hosts) {
+        for(const frontierUrl& queued : host.second.urls) {
+            writer->writeString(queued.url);
+            writer->writeString(domainTable->lookup(host.first));
+            writer->writeDouble(queued.score);
+            writer->writeInt(queued.depth);
+        }
+    }
+}
+
+bool CrawlFrontier::syncSpilledUrls() {
+    {
+        std::lock_guard<std::mutex> lock(spillMutex);
+        if(!holdingSavedSpill)
+            return true;
+    }
+    // The snapshot's segments are kept, so they can be synced without the lock
+    return spill->syncSnapshot(savedSpill);
+}
+
+void CrawlFrontier::finishCheckpoint(bool committed) {
+    std::lock_guard<std::mutex> lock(spillMutex);
+    if(!holdingSavedSpill)
+        return;
+    holdingSavedSpill = false;
+    if(!committed) {
+        spill->releaseSnapshot(savedSpill);
+        return;
+    }
+    // The previous checkpoint has been replaced, so the segments only it referred to can be deleted
+    if(holdingCommittedSpill)
+        spill->releaseSnapshot(committedSpill);
+    committedSpill = savedSpill;
+    holdingCommittedSpill = true;
+}
+
+bool CrawlFrontier::loadState(CheckpointReader* reader) {
+    // Released URLs may not have been fetched, so they are fetched again before anything else
+    const double releasedUrlScore = std::numeric_limits<double>::max();
+
+    std::string url;
+    std::string host;
+    double score;
+    std::int64_t depth;
+    std::int64_t firstSegment;
+    std::int64_t segmentRecords;
+    std::uint64_t count;
+
+    spillSnapshot snapshot;
+    if(!reader->readInt(&firstSegment) || !reader->readUint(&snapshot.firstOffset) || !reader->readUint(&count))
+        return false;
+    snapshot.firstSegment = firstSegment;
+    for(std::uint64_t i = 0; i < count; i++) {
+        if(!reader->readInt(&segmentRecords))
+            return false;
+        snapshot.segmentRecords.push_back(segmentRecords);
+        snapshot.records += segmentRecords;
+    }
+    // Without its segments the spilled URLs are lost, but the rest of the checkpoint can still be resumed from
+    if(count > 0 && spill) {
+        std::lock_guard<std::mutex> lock(spillMutex);
+        if(spill->adoptSnapshot(snapshot)) {
+            committedSpill = snapshot;
+            holdingCommittedSpill = true;
+        }
+    }
+
+    if(!reader->readUint(&count))
+        return false;
+    for(std::uint64_t i = 0; i < count; i++) {
+        if(!reader->readString(&url) || !reader->readString(&host) || !reader->readInt(&depth))
+            return false;
+        const std::uint32_t hostId = domainTable->intern(host);
+        if(hostId != 0)
+            push(url, hostId, releasedUrlScore, depth);
+    }
+
+    if(!reader->readUint(&count))
+        return false;
+    for(std::uint64_t i = 0; i < count; i++) {
+        if(!reader->readString(&url) || !reader->readString(&host) || !reader->readDouble(&score) || !reader->readInt(&depth))
+            return false;
+        const std::uint32_t hostId = domainTable->intern(host);
+        if(hostId != 0)
+            push(url, hostId, score, depth);
+    }
+    return true;
+}
+
+long CrawlFrontier::size() {
+    long queued;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        queued = queuedUrls;
+    }
+    return queued + spilledSize();
+}
+
+long CrawlFrontier::spilledSize() {
+    std::lock_guard<std::mutex> lock(spillMutex);
+    return spill ? spill->size() : 0;
+}
+
+void CrawlFrontier::reloadSpilledUrls() {
+    long reloadCount;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        if(queuedUrls > maxMemoryUrls / 2)
+            return;
+        reloadCount = std::min<long>(spillReloadBatch, maxMemoryUrls - queuedUrls);
+    }
+
+    // Reads are batched, and done without the mutex, so a refill doesn't hold up the analysis workers
+    std::vector<std::string> records;
+    {
+        std::lock_guard<std::mutex> lock(spillMutex);
+        if(!spill || spill->empty())
+            return;
+        std::string record;
+        while((long)records.size() < reloadCount && spill->pop(&record))
+            records.push_back(record);
+    }
+
+    std::string url;
+    std::string host;
+    double score;
+    int depth;
+    std::lock_guard<std::mutex> lock(mu);
+    for(const std::string& record : records) {
+        if(!decodeSpilledUrl(record, &url, &host, &score, &depth))
+            continue;
+        const std::uint32_t hostId = domainTable->intern(host);
+        if(hostId != 0)
+            queueInMemory(url, hostId, score, depth);
+    }
+}
+
+void CrawlFrontier::rankHost(std::uint32_t hostId, hostQueue* queue) {
+    queue->version = ++rankVersion;
+    queue->ranked = true;
+    queue->rankedScore = queue->urls.front().score;
+    hostRanks.push(hostRank {queue->rankedScore / (1 + queue->released), hostId, queue->version});
+    // Every rerank leaves the host's previous ranking behind, so they are cleared out once they outnumber the hosts
+    if(hostRanks.size() > std::max(minHostRanks, 2 * hosts.size()))
+        compactHostRanks();
+}
+
+void CrawlFrontier::compactHostRanks() {
+    std::vector<hostRank> ranks;
+    ranks.reserve(hosts.size());
+    for(const std::pair<const std::uint32_t, hostQueue>& host : hosts) {
+        if(host.second.ranked)
+            ranks.push_back(hostRank {host.second.rankedScore / (1 + host.second.released), host.first, host.second.version});
+    }
+    hostRanks = std::priority_queue<hostRank, std::vector<hostRank>, hostRankOrder>(hostRankOrder(), std::move(ranks));
+}
+
+bool CrawlFrontier::pop(std::string* url, std::uint32_t* hostId, int* depth) {
+    while(!hostRanks.empty()) {
+        const hostRank rank = hostRanks.top();
+        hostRanks.pop();
+        std::unordered_map<std::uint32_t, hostQueue>::iterator it = hosts.find(rank.hostId);
+        if(it == hosts.end() || it->second.version != rank.version || it->second.urls.empty())
+            continue;
+
+        hostQueue& queue = it->second;
+        std::pop_heap(queue.urls.begin(), queue.urls.end(), frontierUrlOrder());
+        *url = queue.urls.back().url;
+        *depth = queue.urls.back().depth;
+        *hostId = rank.hostId;
+        queue.urls.pop_back();
+        queue.released++;
+        queue.ranked = false;
+        queuedUrls--;
+        // A drained host is kept with its released count, so URLs found for it later don't get a fresh budget and put
+        // it back ahead of hosts it has already been ahead of. Only its URL storage is freed
+        if(!queue.urls.empty())
+            rankHost(rank.hostId, &queue);
+        else
+            std::vector<frontierUrl>().swap(queue.urls);
+        return true;
+    }
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,279 @@
+#ifndef CRAWLFRONTIER_H
+#define CRAWLFRONTIER_H
+
+#include "Checkpoint.h"
+#include "Config.h"
+#include "DomainInternTable.h"
+#include "SpillQueue.h"
+#include "ThreadSafeQueue.h"
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * CrawlFrontier holds the URLs waiting to be crawled, and releases them to curl in priority order.
+ * 
+ * Each URL inherits a score from the page it was found on: the number of unique terms on the page, decayed by the
+ * page's depth from the initial sources. URLs are queued per host, and hosts are ranked by the score of their best
+ * URL divided by one plus the number of URLs already released for the host, so a single dense site can't starve
+ * every other host. Hosts are held as their ids in the shared DomainInternTable.
+ * 
+ * The frontier remembers the depth of each URL released to curl, so the depth of a fetched page can be looked up
+ * when its links are scored.
+ * 
+ * Only a window of URLs is ranked in memory. Once the window is full, new URLs are spilled to segment files on disk,
+ * and are read back in the order they were spilled as the window drains. The spill has its own lock, so its reads and
+ * writes never hold up the URLs ranked in memory. A checkpoint refers to the spilled URLs where they are on disk,
+ * rather than copying them, so the segments a committed checkpoint refers to are kept until the next one is committed.
+ * 
+ * A host keeps its released count once its last queued URL is released, so a host found again later doesn't jump
+ * back ahead of the hosts it was ranked behind. Its queued URLs are freed, so each drained host costs a few words,
+ * next to the name the intern table already holds for it.
+ * 
+ * This class is thread-safe.
+ */
+class CrawlFrontier {
+    public:
+
+        // A structure representing a URL to queue, and the id of its host
+        struct queuedUrl {
+            std::string url;
+            std::uint32_t hostId;
+        };
+
+        // Default constructor
+        CrawlFrontier() = default;
+
+        /**
+         * Constructor.
+         * 
+         * @param config a pointer to the object holding the program's configurations.
+         *      CrawlFrontier Configs:
+         *          Frontier_DepthDecayPercent the percentage of a page's score its links keep per level of depth.
+         *          Frontier_LowWatermark the number of URLs kept in curl's input queue.
+         *          Frontier_MaxPendingUrls the number of released URLs whose depth is remembered.
+         *          Frontier_MaxMemoryUrls the number of queued URLs held in memory before URLs are spilled to disk.
+         *          Frontier_SpillDirectory the directory spilled URLs are written to.
+         * @param dTable a pointer to the table host ids are interned in.
+         */
+        CrawlFrontier(Config* config, DomainInternTable* dTable);
+
+        // Deletes the spilled URLs.
+        ~CrawlFrontier();
+
+        /**
+         * Scores the links found on a page.
+         * 
+         * @param termsFound the number of unique terms found on the page.
+         * @param pageDepth the depth of the page.
+         * @return the score the page's links inherit.
+         */
+        double scoreLinks(int termsFound, int pageDepth);
+
+        /**
+         * Queues a URL.
+         * 
+         * @param url the URL to queue.
+         * @param hostId the id of the URL's host, which the URL is ranked fairly against other hosts by.
+         * @param score the score of the URL. Higher scores are released first.
+         * @param depth the depth of the URL.
+         */
+        void push(const std::string& url, std::uint32_t hostId, double score, int depth);
+
+        /**
+         * Queues the URLs found on a page.
+         * 
+         * @param urls the URLs to queue, and the ids of their hosts, which URLs are ranked fairly against other hosts by.
+         * @param score the score of the URLs. Higher scores are released first.
+         * @param depth the depth of the URLs.
+         */
+        void push(const std::vector<queuedUrl>& urls, double score, int depth);
+
+        /**
+         * Releases the URLs of the highest ranked hosts to curl's input queue, until it holds the low watermark.
+         * 
+         * @param urlQueue a pointer to curl's input queue.
+         * @return true if any URL was released, false otherwise.
+         */
+        bool refill(ThreadSafeQueue<std::string>* urlQueue);
+
+        /**
+         * Looks up the depth of a released URL, and forgets it.
+         * 
+         * @param url the URL as it was released to curl.
+         * @return the depth of the URL, or 0 if the URL is unknown.
+         */
+        int takeDepth(const std::string& url);
+
+        /**
+         * Writes the URLs queued in memory, and the URLs released but not yet analysed, to a checkpoint. The spilled
+         * URLs are not written, only a snapshot of where they are in the spill's segments.
+         * 
+         * @param writer a pointer to the checkpoint writer.
+         */
+        void saveState(CheckpointWriter* writer);
+
+        /**
+         * Flushes the segments of the snapshot taken by saveState through to disk, without holding up the rest of the
+         * frontier.
+         * 
+         * @return true if the segments reached the disk, false otherwise.
+         */
+        bool syncSpilledUrls();
+
+        /**
+         * Keeps the segments of the snapshot taken by saveState if its checkpoint was committed, in place of the
+         * previous checkpoint's, and releases the snapshot otherwise.
+         * 
+         * @param committed whether the checkpoint was committed.
+         */
+        void finishCheckpoint(bool committed);
+
+        /**
+         * Queues the URLs saved to a checkpoint by saveState. URLs which had been released are queued ahead of every
+         * other URL, and the spilled URLs are read from the segments the checkpoint refers to.
+         * 
+         * @param reader a pointer to the checkpoint reader.
+         * @return true if the state was read, false if the checkpoint is corrupt.
+         */
+        bool loadState(CheckpointReader* reader);
+
+        /**
+         * Gets the number of queued URLs.
+         * 
+         * @return the number of URLs queued and not yet released, including spilled URLs.
+         */
+        long size();
+
+        /**
+         * Gets the number of URLs spilled to disk.
+         * 
+         * @return the number of URLs waiting on disk.
+         */
+        long spilledSize();
+
+    private:
+        struct frontierUrl {
+            std::string url;
+            double score;
+            int depth;
+            // Orders URLs of equal score first in, first out
+            long sequence;
+        };
+
+        struct frontierUrlOrder {
+            bool operator()(const frontierUrl& a, const frontierUrl& b) const;
+        };
+
+        struct hostQueue {
+            // A heap ordered by frontierUrlOrder. A vector is used rather than a priority_queue so it can be saved
+            std::vector<frontierUrl> urls;
+            long released = 0;
+            // Rankings with an older version are stale, and are skipped. Versions are unique across every host
+            long version = 0;
+            double rankedScore = 0;
+            bool ranked = false;
+        };
+
+        struct hostRank {
+            double priority;
+            std::uint32_t hostId;
+            long version;
+        };
+
+        struct hostRankOrder {
+            bool operator()(const hostRank& a, const hostRank& b) const;
+        };
+
+        std::unordered_map<std::uint32_t, hostQueue> hosts;
+        std::priority_queue<hostRank, std::vector<hostRank>, hostRankOrder> hostRanks;
+
+        struct pendingUrl {
+            std::uint32_t hostId;
+            int depth;
+            // Tells this release of the URL apart from earlier ones still in pendingOrder
+            long sequence;
+        };
+
+        struct pendingRelease {
+            std::string url;
+            long sequence;
+        };
+
+        // The depth and host of each released URL, and the order the URLs were released in
+        std::unordered_map<std::string, pendingUrl> pendingUrls;
+        std::queue<pendingRelease> pendingOrder;
+
+        std::mutex mu;
+
+        DomainInternTable* domainTable;
+
+        // URLs which don't fit in memory. Allocated by the constructor, as the queue can't be copied
+        SpillQueue* spill = nullptr;
+        // Guards the spill. Never held together with mu, so disk reads and writes don't block the in-memory window
+        std::mutex spillMutex;
+        // The spill's records when the last checkpoint was taken, until it is committed or abandoned
+        spillSnapshot savedSpill;
+        bool holdingSavedSpill = false;
+        // The spill's records the last committed checkpoint refers to
+        spillSnapshot committedSpill;
+        bool holdingCommittedSpill = false;
+
+        long sequence;
+        long rankVersion;
+        long queuedUrls;
+        long maxMemoryUrls;
+        int spillReloadBatch;
+        // The number of host rankings kept before stale rankings are cleared out, whatever the number of hosts
+        std::size_t minHostRanks;
+
+        double depthDecay;
+        int lowWatermark;
+        std::size_t maxPendingUrls;
+
+        /**
+         * Ranks a host by the score of its best URL. Stale rankings are cleared out once they outnumber the hosts.
+         * Must be called with the mutex held.
+         * 
+         * @param hostId the id of the host to rank.
+         * @param queue a pointer to the host's queue. The queue must not be empty.
+         */
+        void rankHost(std::uint32_t hostId, hostQueue* queue);
+
+        /**
+         * Queues a URL in memory. Must be called with the mutex held.
+         * 
+         * @param url the URL to queue.
+         * @param hostId the id of the URL's host.
+         * @param score the score of the URL.
+         * @param depth the depth of the URL.
+         */
+        void queueInMemory(const std::string& url, std::uint32_t hostId, double score, int depth);
+
+        /**
+         * Rebuilds the host rankings from the hosts' current rankings, dropping stale ones. Must be called with the
+         * mutex held.
+         */
+        void compactHostRanks();
+
+        /**
+         * Reads a batch of spilled URLs back into memory, if the in-memory window is less than half full.
+         * Must be called without the mutex held.
+         */
+        void reloadSpilledUrls();
+
+        /**
+         * Takes the best URL of the highest ranked host. Must be called with the mutex held.
+         * 
+         * @param[out] url the URL taken.
+         * @param[out] hostId the id of the host of the URL taken.
+         * @param[out] depth the depth of the URL taken.
+         * @return true if a URL was taken, false if the frontier is empty.
+         */
+        bool pop(std::string* url, std::uint32_t* hostId, int* depth);
+};
+
+#endif
\ No newline at end of file
@@ -1,69 +1,159 @@
 #include "Crawler.h"
+#include "Checkpoint.h"
 #include "Config.h"
+#include "CrawlFrontier.h"
 #include "CurlInteractionStructs.h"
+#include "DomainFilterSet.h"
+#include "DomainInternTable.h"
+#include "MetricsRegistry.h"
+#include "PageTracer.h"
+#include "DomainExtractor.h"
+#include "LinkTokenizer.h"
+#include "PublicSuffixList.h"
+#include "TaskScheduler.h"
 #include "TermMatcher.h"
 #include "ThreadSafeSet.h"
 #include "ThreadSafeQueue.h"
+#include "Url.h"
+#include "VisitedUrlStore.h"
 #include <atomic>
-#include <boost/regex.hpp>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <unordered_set>
 #include <unordered_map>
+#include <vector>
 
-Crawler::Crawler(curlIO cIO, ThreadSafeQueue<std::string>* initialQueue, std::atomic<int>* killS, ThreadSafeQueue<std::string>* extractedDomains, std::unordered_set<std::string> eDomains, Config* config) {
+Crawler::Crawler(curlIO cIO, std::atomic<int>* killS, ThreadSafeQueue<extractedDomain>* extractedDomains, DomainFilterSet* cDomains, std::unordered_set<std::string> eDomains, Config* config, DomainInternTable* dTable, MetricsRegistry* metricsRegistry, PageTracer* pageTracer) : traversedDomains(config, dTable), frontier(config, dTable), visitedUrls(dTable) {
     const int defaultMaxRequestsPerDomain = 150;
     const int defaultMaxExtractedLinksPerPage = 500;
+    const int defaultFollowEmbeddedLinks = 0;
+    const std::string defaultPublicSuffixList = "public_suffix_list.dat";
+    const int defaultAnalysisWorkers = 4;
+    const int maxAnalysisWorkersLimit = 64;
 
     maxDomainSize = 253;  // https://www.freesoft.org/CIE/RFC/1035/9.htm
-
-    sleepLockMilliseconds = std::chrono::milliseconds(20);
     
     curlOutputQueue = cIO.output;
     urlQueue = cIO.urls;
     killSwitch = killS;
     extractedDomainQueue = extractedDomains;
+    checkedDomains = cDomains;
+    domainTable = dTable;
+    metrics = metricsRegistry;
+    tracer = pageTracer;
     excludedDomains = eDomains;
 
-    maxRequestsPerDomain = config->getIntConfig("Crawler_MaxRequestsPerDomain", defaultMaxRequestsPerDomain);
+    maxRequestsPerDomain = config->getIntConfig("Crawler_MaxRequestsPerDomain", defaultMaxRequestsPerDomain, 0, std::numeric_limits<int>::max());
+    maxAnalysisWorkers = config->getIntConfig("Crawler_AnalysisThreads", defaultAnalysisWorkers, 1, maxAnalysisWorkersLimit);
     maxExtractedLinksPerPage = config->getIntConfig("Crawler_MaxExtractedLinksPerPage", defaultMaxExtractedLinksPerPage);
-    
+    followEmbeddedLinks = config->getIntConfig("Crawler_FollowEmbeddedLinks", defaultFollowEmbeddedLinks, 0, 1) == 1;
+    suffixList = PublicSuffixList(config->getConfig("Crawler_PublicSuffixList", defaultPublicSuffixList));
+}
+
+void Crawler::addStages(TaskScheduler* scheduler, TermMatcher* validator) {
+    scheduler->addStage([this, validator]() { return crawlPage(validator); }, maxAnalysisWorkers);
+    // The frontier keeps curl's input queue topped up, so the best URLs are chosen as late as possible
+    scheduler->addStage([this]() { return frontier.refill(urlQueue); }, 1);
+}
+
+void Crawler::queueInitialSources(ThreadSafeQueue<std::string>* initialQueue) {
+    // Initial sources are released before any discovered link
+    const double initialSourceScore = std::numeric_limits<double>::max();
+
+    std::queue<Url> queuedUrls;
     std::string initialQueueData;
     if(initialQueue->empty())
         std::cout << "ERROR: sources.txt Has Not Been Populated\n";
     else
         while(initialQueue->safePop(&initialQueueData) && initialQueueData.length() < maxDomainSize) {
-            std::queue<std::string> domain;
+            Url initialUrl;
             if(initialQueueData.length() < maxDomainSize) {
-                extractDomains(initialQueueData, &domain);
-                if(!domain.empty())
-                    queuedUrls.push(std::make_pair(initialQueueData, domain.front()));
+                if(initialUrl.parse(initialQueueData))
+                    queuedUrls.push(initialUrl);
                 else
                     std::cout << "ERROR: Invalid Initial Domain: " << initialQueueData << "\n";
             } else
                 std::cout << "ERROR: Initial Domain Exceeds Max Size: " << initialQueueData << "\n";
         }
         
-    pushUrls();
+    pushUrls(&queuedUrls, initialSourceScore, 0);
 }
 
-void Crawler::crawl(TermMatcher* validator) {
-    // Thread will operate until the killswitch is thrown 
-    while(killSwitch->load() == 0) {
-        siteData data;
-        if(curlOutputQueue->safePop(&data)) {
-            domainScraper(data, validator);
-            pushUrls();
-        // If there is no work, the crawler thread sleeps
-        } else
-            std::this_thread::sleep_for(sleepLockMilliseconds);
+void Crawler::saveState(CheckpointWriter* writer) {
+    std::unique_lock<std::mutex> lock(frontierMutex);
+
+    traversedDomains.saveState(writer);
+
+    visitedUrls.saveState(writer);
+    lock.unlock();
+
+    frontier.saveState(writer);
+}
+
+bool Crawler::syncSpilledUrls() {
+    return frontier.syncSpilledUrls();
+}
+
+void Crawler::finishCheckpoint(bool committed) {
+    frontier.finishCheckpoint(committed);
+}
+
+bool Crawler::loadState(CheckpointReader* reader) {
+    // Only domains which had not been traversed have visited URLs saved, so the two need no reconciling
+    std::unique_lock<std::mutex> lock(frontierMutex);
+    if(!traversedDomains.loadState(reader) || !visitedUrls.loadState(reader))
+        return false;
+    lock.unlock();
+
+    return frontier.loadState(reader);
+}
+
+long Crawler::getFrontierSize() {
+    return frontier.size();
+}
+
+bool Crawler::crawlPage(TermMatcher* validator) {
+    siteData data;
+    if(!curlOutputQueue->safePop(&data))
+        return false;
+    if(data.trace)
+        data.trace->dequeuedAt = std::chrono::steady_clock::now();
+    const int depth = frontier.takeDepth(data.siteUrl);
+    metrics->record(MetricsRegistry::crawlerQueueWaitHistogram, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - data.queuedAt).count());
+    metrics->record(MetricsRegistry::crawlerFetchLatencyHistogram, (std::uint64_t)(data.fetchSeconds * 1000000));
+    if(data.transferFailed) {
+        metrics->increment(MetricsRegistry::crawlerFailuresCounter);
+        tracer->record("crawler", data);
+        return true;
     }
-    std::cout << "Crawler Exiting\n";
+    std::uint64_t pageBytes = 0;
+    for(const std::string& chunk : data.siteContents)
+        pageBytes += chunk.size();
+    metrics->increment(MetricsRegistry::crawlerPagesCounter);
+    metrics->increment(MetricsRegistry::bytesFetchedCounter, pageBytes);
+    metrics->record(MetricsRegistry::pageBytesHistogram, pageBytes);
+    // Each worker queues the links of its own page, then merges them into the shared frontier
+    std::queue<Url> queuedUrls;
+    int termsFound = 0;
+    domainScraper(data, validator, &queuedUrls, &termsFound);
+    if(!queuedUrls.empty())
+        pushUrls(&queuedUrls, frontier.scoreLinks(termsFound, depth), depth + 1);
+    if(data.trace) {
+        data.trace->analysisEndedAt = std::chrono::steady_clock::now();
+        tracer->record("crawler", data);
+    }
+    return true;
 }
 
-void Crawler::domainScraper(siteData inputData, TermMatcher* validator) {
+void Crawler::domainScraper(siteData inputData, TermMatcher* validator, std::queue<Url>* queuedUrls, int* termsFound) {
     /**
      * Checks to see if there is any data, then checks to see if data returned is an HTML document.
      * If there is no data, or the document does start with the DOCTYPE decleration, the site is ignored.
@@ -71,111 +161,122 @@ void Crawler::domainScraper(siteData inputData, TermMatcher* validator) {
     const std::string htmlDoctypeTag = "<!DOCTYPE";
     if(inputData.siteContents.empty() || !(inputData.siteContents.front().compare(0, htmlDoctypeTag.size(), htmlDoctypeTag)) == 0)
         return;
-    // If the site has the number of required terms, use regex to search for links and call extractDomains. Otherwise, the site is ignored
-    if(validator->matchTerms(inputData.siteContents, false)) {
-        const int urlIndex = 1;
-        const int domainIndex = 3;
-        const char selfReferencingLink = '/';
-        const std::string defaultProtocol = "https://";
-
+    // If the site has the number of required terms, tokenize the page for links and call extractDomains. Otherwise, the site is ignored
+    const std::chrono::steady_clock::time_point matchStart = std::chrono::steady_clock::now();
+    const bool matched = validator->matchTerms(inputData.siteContents, false, termsFound);
+    const std::chrono::steady_clock::time_point matchEnd = std::chrono::steady_clock::now();
+    metrics->record(MetricsRegistry::matchTimeHistogram, std::chrono::duration_cast<std::chrono::microseconds>(matchEnd - matchStart).count());
+    // The trace is shared with the caller's copy of the page
+    if(inputData.trace) {
+        inputData.trace->matchStartedAt = matchStart;
+        inputData.trace->matchEndedAt = matchEnd;
+    }
+    if(matched) {
         // processSiteContents is called on the site contents to parse out potential domains
         processSiteContents(inputData);
 
-        // This regex idientifies A HREF links for the crawler to follow
-        // This regex ignores URL fragments by truncating the fragment part of the URL
-        boost::regex expression(R"(<a[^h>]*href=\"(([^:\/]*:\/\/([^\/":?]+)|\/)[^"&=>#?]*))");
+        LinkTokenizer tokenizer(followEmbeddedLinks);
+        std::queue<htmlLink> links;
 
-        std::queue<std::string> siteDomain;
-        
-        // Find current URL's domain
-        extractDomains(inputData.siteUrl, &siteDomain);
+        // Relative links are resolved against the <base> element's URL if there is one, and the page's URL otherwise
+        Url baseUrl;
+        if(!baseUrl.parse(inputData.siteUrl))
+            return;
         
         int linksFound = 0;
-        // Limit total links processed per page
+        // Limit total links processed per page. The tokenizer is fed every chunk, as tags may be split between chunks
         for(size_t i = 0; i < inputData.siteContents.size() && linksFound < maxExtractedLinksPerPage; i++) {
-            boost::sregex_iterator j = boost::sregex_iterator(inputData.siteContents[i].begin(), inputData.siteContents[i].end(), expression);
-            boost::sregex_iterator end;
+            tokenizer.tokenize(inputData.siteContents[i], &links);
             // Iterate through every found link
-            for(; j != end && linksFound < maxExtractedLinksPerPage; j++, linksFound++) {
-                boost::smatch match = *j;
-                /** 
-                 * Handle self referencing links by concatenating current_url to just the domain, then adding the rest of the match
-                 * If the root domain could not be extracted, ignore the self referencing URL
-                 */
-                if(match.str(urlIndex)[0] == selfReferencingLink && !siteDomain.empty())
-                    // Send URL for validation
-                    queuedUrls.push(std::make_pair(defaultProtocol + siteDomain.front() + match.str(urlIndex), siteDomain.front()));
-                // Exclude excluded domains
-                else if(excludedDomains.empty() || excludedDomains.find(match.str(domainIndex)) == excludedDomains.end())
-                    queuedUrls.push(std::make_pair(match.str(urlIndex), match.str(domainIndex)));
+            for(; !links.empty() && linksFound < maxExtractedLinksPerPage; links.pop()) {
+                if(links.front().isBase) {
+                    Url resolvedBaseUrl;
+                    if(baseUrl.resolve(links.front().url, &resolvedBaseUrl))
+                        baseUrl = resolvedBaseUrl;
+                } else {
+                    queueLink(links.front().url, baseUrl, queuedUrls);
+                    linksFound++;
+                }
             }
+            // Links point into the tokenizer's buffers, and must not outlive the next call to tokenize
+            std::queue<htmlLink>().swap(links);
         }
     }
 }
 
-void Crawler::extractDomains(std::string data, std::queue<std::string>* extractedDomains) {
-    // This expression is used to filter for domains
-    boost::regex expression(R"([^\w\.\-]([\w-]+?\.(([\w-]+?\.)+)?([a-zA-Z]+|XN--[A-Za-z0-9]+)))");
+void Crawler::queueLink(std::string_view link, const Url& baseUrl, std::queue<Url>* queuedUrls) {
+    // Truncate query strings and fragments
+    link = link.substr(0, link.find_first_of("?#"));
 
-    boost::sregex_iterator i = boost::sregex_iterator(data.begin(), data.end(), expression);
-    boost::sregex_iterator end;
-
-    /**
-     * For every domain extracted, check for a valid top level domain, then exclude any matches
-     * that are followed by a `(` character to reduce false positives
-     */
-    for(; i != end; i++) {
-        boost::smatch match = *i;
-        
-        if(TOP_LEVEL_DOMAINS.find(match.str(4)) != TOP_LEVEL_DOMAINS.end() && ((std::string)match.suffix())[1] != '(')
-            extractedDomains->push(match.str(1));
-    }
+    // Resolve the link, then exclude excluded domains and links curl cannot follow
+    Url url;
+    if(baseUrl.resolve(link, &url) && !isExcluded(url.getHost()))
+        // Send URL for validation
+        queuedUrls->push(url);
 }
 
-void Crawler::extractDomains(std::vector<std::string> data, std::queue<std::string>* extractedDomains) {
-    // For every string in the data
-    for(std::string it : data) {
-        // Perform domain extraction on the string
-        extractDomains(it, extractedDomains);
-    }
+bool Crawler::isExcluded(std::string_view domain) {
+    if(excludedDomains.empty())
+        return false;
+    // Excluding a registrable domain excludes all of its subdomains
+    return excludedDomains.find(std::string(domain)) != excludedDomains.end()
+        || excludedDomains.find(std::string(suffixList.getRegistrableDomain(domain))) != excludedDomains.end();
 }
 
 void Crawler::processSiteContents(siteData inputData) {
     std::queue<std::string> extractedDomains;
-    extractDomains(inputData.siteContents, &extractedDomains);        
+    DomainExtractor::extractDomains(inputData.siteContents, &extractedDomains);        
     
+    // Every domain extracted from the page shares one copy of the page's URL
+    std::shared_ptr<const std::string> referrer;
+    if(!extractedDomains.empty())
+        referrer = std::make_shared<const std::string>(inputData.siteUrl);
     while(!extractedDomains.empty()) {
         // Excludes domains on the exclusion list, and domains that are too large
-        if(extractedDomains.front().size() < maxDomainSize && excludedDomains.find(extractedDomains.front()) == excludedDomains.end())
-            extractedDomainQueue->push(extractedDomains.front());
+        if(extractedDomains.front().size() < maxDomainSize && !isExcluded(extractedDomains.front())) {
+            // Domains already checked are dropped here, so only domains the searcher will fetch are interned
+            if(!checkedDomains->contains(extractedDomains.front())) {
+                const std::uint32_t domainId = domainTable->intern(extractedDomains.front());
+                if(domainId != 0)
+                    extractedDomainQueue->push(extractedDomain {domainId, referrer});
+            }
+            metrics->increment(MetricsRegistry::domainsExtractedCounter);
+        }
         extractedDomains.pop();
     }
 }
 
-void Crawler::pushUrls() {
-    while(!queuedUrls.empty()) {
-        std::string url = queuedUrls.front().first;
-        std::string domain = queuedUrls.front().second;
-
-        if(!traversedDomains.contains(domain) && url.length() > 0) {
-            // If this URL's domain has never been seen before, create a new domain entry
-            if(visitedUrlsPerDomain.find(domain) == visitedUrlsPerDomain.end()) {
-                std::unordered_set<std::string> newSet = {url};
-                visitedUrlsPerDomain.insert(std::make_pair(domain, newSet));
-                urlQueue->push(url);
-            // If the domain has been seen, and the URL has not been visited before
-            } else if(visitedUrlsPerDomain[domain].find(url) == visitedUrlsPerDomain[domain].end()) {
+void Crawler::pushUrls(std::queue<Url>* queuedUrls, double score, int depth) {
+    // URLs are queued in the frontier once the lock is released, as the frontier may write them to disk
+    std::vector<CrawlFrontier::queuedUrl> acceptedUrls;
+    while(!queuedUrls->empty()) {
+        // URLs are deduplicated on their normalized form, so equivalent URLs are only fetched once
+        std::string urlKey = queuedUrls->front().getDedupKey();
+        // URLs are budgeted by registrable domain, so that every subdomain of a site shares one budget
+        const std::string_view registrableDomain = suffixList.getRegistrableDomain(queuedUrls->front().getHost());
+
+        // The frontier is shared by every analysis worker
+        std::unique_lock<std::mutex> lock(frontierMutex);
+        // Domains are only interned once their budget is known to be open, so links to traversed domains cost nothing
+        if(!traversedDomains.contains(registrableDomain) && urlKey.length() > 0) {
+            const std::uint32_t domainId = domainTable->intern(registrableDomain);
+            const std::uint32_t hostId = domainTable->intern(queuedUrls->front().getHost());
+            const std::uint32_t visitedCount = visitedUrls.count(domainId);
+            // If the URL has not been visited before. Domains the intern table had no room for are skipped
+            if(domainId != 0 && hostId != 0 && visitedUrls.insert(domainId, urlKey)) {
                 // If the number of URLs visited meets the MAX_LINKS_PER_DOMAIN after this addition
-                if(visitedUrlsPerDomain[domain].size() >= maxRequestsPerDomain) {
+                if(visitedCount >= maxRequestsPerDomain) {
                     // Exclude URLs associated with this domain in the future
-                    traversedDomains.safeInsert(domain);
-                    // Save memory by deleting the URLs stored in the map
-                    visitedUrlsPerDomain.erase(visitedUrlsPerDomain.find(domain));
-                } else
-                    visitedUrlsPerDomain[domain].insert(url);
-                urlQueue->push(url);
+                    traversedDomains.safeInsert(domainId);
+                    // Save memory by forgetting the URLs stored for the domain
+                    visitedUrls.retireDomain(domainId);
+                }
+                acceptedUrls.push_back(CrawlFrontier::queuedUrl {queuedUrls->front().toString(), hostId});
             }
         }
-        queuedUrls.pop();
+        lock.unlock();
+        queuedUrls->pop();
     }
+    if(!acceptedUrls.empty())
+        frontier.push(acceptedUrls, score, depth);
 }
\ No newline at end of file
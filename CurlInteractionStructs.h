@@ -2,18 +2,51 @@
 #define SITEDATASTRUCT_H
 
 #include "ThreadSafeQueue.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
 
+/**
+ * A structure representing the timeline of one sampled page through the pipeline.
+ * 
+ * The curl timings are the durations libcurl reports from the start of the transfer, which begins when the URL is
+ * assigned to a handle. The remaining times are set by the stage consuming the page.
+ */
+struct pageTrace {
+    std::chrono::steady_clock::time_point handleAssignedAt;
+    double nameLookupSeconds = 0;
+    double connectSeconds = 0;
+    double tlsSeconds = 0;
+    double preTransferSeconds = 0;
+    double startTransferSeconds = 0;
+    double totalSeconds = 0;
+    std::chrono::steady_clock::time_point dequeuedAt;
+    std::chrono::steady_clock::time_point matchStartedAt;
+    std::chrono::steady_clock::time_point matchEndedAt;
+    std::chrono::steady_clock::time_point analysisEndedAt;
+};
+
 /**
  * A structure representing site data.
  * 
- * This struct holds both a vector of strings representing the site's data, and a string representing the site's URL
+ * This struct holds both a vector of strings representing the site's data, and a string representing the site's URL.
+ * Failed transfers are reported with transferFailed set, and no contents. The HTTP status and the total time of the
+ * transfer are reported for every transfer, along with the time it was queued for its consumer. Sampled pages carry
+ * a trace, which is shared by every copy of the page. While a transfer is recorded, its handle's siteData also holds
+ * the response's headers.
  */
 struct siteData {
     std::vector<std::string> siteContents;
     std::string siteUrl;
     int maxContentBytes;
+    bool transferFailed = false;
+    long httpStatus = 0;
+    double fetchSeconds = 0;
+    std::chrono::steady_clock::time_point queuedAt;
+    std::shared_ptr<pageTrace> trace;
+    std::string responseHeaders;
 
     siteData() = default;
 
@@ -23,6 +56,16 @@ struct siteData {
     }
 };
 
+/**
+ * A structure representing a domain extracted by the crawler, and the page it was extracted from.
+ * 
+ * The page's URL is shared by every domain extracted from the page.
+ */
+struct extractedDomain {
+    std::uint32_t domainId;
+    std::shared_ptr<const std::string> referrer;
+};
+
 // A structure representing input/output elements and configurations needed for the curl handler. 
 struct curlIO {
     ThreadSafeQueue<siteData>* output;
@@ -1,20 +1,25 @@
 #include "CurlThread.h"
 #include "Config.h"
 #include "CurlInteractionStructs.h"
+#include "MetricsRegistry.h"
+#include "PageTracer.h"
 #include "ThreadSafeQueue.h"
+#include "WarcArchive.h"
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <curl/curl.h>
 #include <iostream>
+#include <memory>
 #include <queue>
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
-CurlThread::CurlThread(curlIO cIO, std::atomic<int>* kSwitch, Config* config) {
+CurlThread::CurlThread(curlIO cIO, std::atomic<int>* kSwitch, Config* config, MetricsRegistry* metricsRegistry, PageTracer* pageTracer, WarcArchive* warcArchive) {
     // Non-configurable libcurl constants
     const std::string acceptedProtocols = "http,https";
-    const std::string preferredProtocol = "https";
     const std::string lowerByteRange = "0-";                        // See https://curl.se/libcurl/c/CURLOPT_RANGE.html
     const long slowTimeoutBytesASecond = 50L;                       // See https://curl.se/libcurl/c/CURLOPT_LOW_SPEED_LIMIT.html
     const long hardTimeOutSeconds = 300L;                           // Hard timeout in seconds
@@ -22,6 +27,8 @@ CurlThread::CurlThread(curlIO cIO, std::atomic<int>* kSwitch, Config* config) {
     const long enableNoSignal = 1L;                                 // See https://curl.se/libcurl/c/threadsafe.html
 
     const std::string defaultSslCertLocation = "cacert.pem";        // The location of the SSL cert
+    const std::string defaultPreferredProtocol = "https";           // The protocol of URLs without a scheme, such as the searcher's domains
+    const std::string defaultConnectTo = "";                        // See https://curl.se/libcurl/c/CURLOPT_CONNECT_TO.html
     const std::string defaultUserAgent = "Mozilla/5.0 (Windows NT 10.0) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/114.0.0.0 Safari/537.36";
     const int defaultUpperByteRange = 15000000;                     // Number of bytes to read per page
     
@@ -36,18 +43,27 @@ CurlThread::CurlThread(curlIO cIO, std::atomic<int>* kSwitch, Config* config) {
     outputQueue = cIO.output;
     urlQueue = cIO.urls;
 
-    int MaxConnections = defaultMaxConnections;
+    maxConnections = defaultMaxConnections;
     if(cIO.maxConnections > 0)
-        MaxConnections = cIO.maxConnections;
+        maxConnections = cIO.maxConnections;
 
     const std::string sslCertLocation = config->getConfig("Curl_SslCertLocation", defaultSslCertLocation);
     const std::string userAgent = config->getConfig("Curl_UserAgent", defaultUserAgent);
     const long maxRedirects = config->getLongConfig("Curl_MaxRedirects", defaultMaxRedirects);
     const long slowTimeoutSeconds = config->getLongConfig("Curl_Timeout", defaultSlowTimeoutSeconds);
+    std::string preferredProtocol = config->getConfig("Curl_DefaultProtocol", defaultPreferredProtocol);
+    if(preferredProtocol != "http" && preferredProtocol != "https") {
+        std::cout << "ERROR: Invalid Configuration: Curl_DefaultProtocol\n";
+        preferredProtocol = defaultPreferredProtocol;
+    }
+    const std::string connectTo = config->getConfig("Curl_ConnectTo", defaultConnectTo);
     upperByteLimit = config->getIntConfig("Curl_BytesToRead", defaultUpperByteRange);
     const std::string acceptedByteRange = lowerByteRange + std::to_string(upperByteLimit);
 
     killSwitch = kSwitch;
+    metrics = metricsRegistry;
+    tracer = pageTracer;
+    archive = warcArchive;
     
     multiHandle = curl_multi_init();
     curl_multi_setopt(multiHandle, CURLMOPT_MAX_HOST_CONNECTIONS, 50);
@@ -64,11 +80,25 @@ CurlThread::CurlThread(curlIO cIO, std::atomic<int>* kSwitch, Config* config) {
     HTTPHeaderOptions = curl_slist_append(HTTPHeaderOptions, "Sec-Fetch-Site: same-origin");
     HTTPHeaderOptions = curl_slist_append(HTTPHeaderOptions, "Sec-Fetch-User: ?1");
 
+    // Redirects connections to another host and port, without changing the URLs or the Host header. Entries are comma separated
+    connectToOptions = NULL;
+    std::size_t entryStart = 0;
+    while(entryStart < connectTo.size()) {
+        std::size_t entryEnd = connectTo.find(',', entryStart);
+        if(entryEnd == std::string::npos)
+            entryEnd = connectTo.size();
+        if(entryEnd > entryStart)
+            connectToOptions = curl_slist_append(connectToOptions, connectTo.substr(entryStart, entryEnd - entryStart).c_str());
+        entryStart = entryEnd + 1;
+    }
+
     /**
      * For each allowed connection, initialize a curl easy handle, then a pointer to the handle is added both a 
-     * queue of waiting handles, and a map which is used to store any data the handle might return
+     * queue of waiting handles, and a map which is used to store any data the handle might return. Replayed
+     * responses need no handles
      */ 
-    for(size_t i = 0; i < MaxConnections; i++) {
+    const int handleCount = archive->isReplaying() ? 0 : maxConnections;
+    for(size_t i = 0; i < handleCount; i++) {
         CURL* eHandle = curl_easy_init();
         if(eHandle) {
             // A siteData object the callback function uses to output data
@@ -92,6 +122,13 @@ CurlThread::CurlThread(curlIO cIO, std::atomic<int>* kSwitch, Config* config) {
             curl_easy_setopt(eHandle, CURLOPT_MAXREDIRS, maxRedirects);
             curl_easy_setopt(eHandle, CURLOPT_RANGE, acceptedByteRange);
             curl_easy_setopt(eHandle, CURLOPT_HTTPHEADER, HTTPHeaderOptions);
+            if(connectToOptions)
+                curl_easy_setopt(eHandle, CURLOPT_CONNECT_TO, connectToOptions);
+            // Headers are only needed to record the response
+            if(archive->isRecording()) {
+                curl_easy_setopt(eHandle, CURLOPT_HEADERFUNCTION, CurlThread::curlWriteHeaderCallback);
+                curl_easy_setopt(eHandle, CURLOPT_HEADERDATA, sData);
+            }
             handlesWaitingForNewURLs.push(eHandle);
 
             easyHandles.insert(std::pair<CURL*, siteData*> (eHandle, sData));
@@ -103,6 +140,7 @@ CurlThread::CurlThread(curlIO cIO, std::atomic<int>* kSwitch, Config* config) {
 
 void CurlThread::cleanup() {
     curl_slist_free_all(HTTPHeaderOptions);
+    curl_slist_free_all(connectToOptions);
     for(auto handle : easyHandles) {
         if(handle.first) {
             curl_multi_remove_handle(multiHandle, handle.first);
@@ -120,6 +158,12 @@ void CurlThread::consumeUrls() {
     struct CURLMsg* message;
     CURLMcode multiResponse;
     std::string url;
+
+    if(archive->isReplaying()) {
+        replayUrls();
+        return;
+    }
+
     // While the kill switch has not been thrown
     do {
         int messageQueueItems = 0;
@@ -158,24 +202,66 @@ void CurlThread::consumeUrls() {
                 CURL* eHandle = message->easy_handle;
                 // If the message indicates a completed transfer
                 if(message->msg == CURLMSG_DONE) {
+                    // Find the siteData the curl handle used
+                    std::unordered_map<CURL*, siteData*>::iterator outputIt = easyHandles.find(eHandle);
+                    siteData* siteOutput = outputIt->second;
+                    long httpStatus = 0;
+                    double fetchSeconds = 0;
+                    curl_easy_getinfo(eHandle, CURLINFO_RESPONSE_CODE, &httpStatus);
+                    curl_easy_getinfo(eHandle, CURLINFO_TOTAL_TIME, &fetchSeconds);
+                    if(siteOutput->trace) {
+                        pageTrace* trace = siteOutput->trace.get();
+                        curl_easy_getinfo(eHandle, CURLINFO_NAMELOOKUP_TIME, &trace->nameLookupSeconds);
+                        curl_easy_getinfo(eHandle, CURLINFO_CONNECT_TIME, &trace->connectSeconds);
+                        curl_easy_getinfo(eHandle, CURLINFO_APPCONNECT_TIME, &trace->tlsSeconds);
+                        curl_easy_getinfo(eHandle, CURLINFO_PRETRANSFER_TIME, &trace->preTransferSeconds);
+                        curl_easy_getinfo(eHandle, CURLINFO_STARTTRANSFER_TIME, &trace->startTransferSeconds);
+                        trace->totalSeconds = fetchSeconds;
+                    }
                     // If the transfer was successful
                     if(message->data.result == CURLE_OK) {
-                        // Find the siteData the curl handle used
-                        std::unordered_map<CURL*, siteData*>::iterator outputIt = easyHandles.find(eHandle);
-                        siteData* siteOutput = outputIt->second;
                         /**
                          * If the request did not involve an empty URL, the request did not return empty,
                          * the URL size is less than Chrome's maximum URL length of 2 MB,
                          * and the handle was not misallocated, initiate a siteData object and populate it with the output of 
                          * the curl operation. This siteData object is then pushed to the output queue.
                          */
-                        if(!siteOutput->siteUrl.empty() && siteOutput->siteUrl.size() < maxUrlLength && !siteOutput->siteContents.empty() && outputIt != easyHandles.end())
-                            outputQueue->push(siteData(siteOutput->siteContents, siteOutput->siteUrl));
-                        siteData empty;
-                        // Deallocate memory; Prevents bloat caused by large sites or URLs
-                        siteOutput->siteContents = empty.siteContents;
-                        siteOutput->siteUrl = empty.siteUrl;
+                        if(!siteOutput->siteUrl.empty() && siteOutput->siteUrl.size() < maxUrlLength && !siteOutput->siteContents.empty() && outputIt != easyHandles.end()) {
+                            siteData fetched(siteOutput->siteContents, siteOutput->siteUrl);
+                            fetched.httpStatus = httpStatus;
+                            fetched.fetchSeconds = fetchSeconds;
+                            fetched.queuedAt = std::chrono::steady_clock::now();
+                            fetched.trace = siteOutput->trace;
+                            outputQueue->push(fetched);
+                        }
+                    } else if(!siteOutput->siteUrl.empty() && siteOutput->siteUrl.size() < maxUrlLength) {
+                        // Failed transfers are reported, so consumers can stop waiting on the URL and remember the failure
+                        siteData failed;
+                        failed.siteUrl = siteOutput->siteUrl;
+                        failed.transferFailed = true;
+                        failed.httpStatus = httpStatus;
+                        failed.fetchSeconds = fetchSeconds;
+                        failed.queuedAt = std::chrono::steady_clock::now();
+                        failed.trace = siteOutput->trace;
+                        outputQueue->push(failed);
                     }
+                    if(message->data.result != CURLE_OK)
+                        metrics->countCurlError(message->data.result);
+                    if(archive->isRecording() && !siteOutput->siteUrl.empty()) {
+                        char* effectiveUrl = NULL;
+                        curl_easy_getinfo(eHandle, CURLINFO_EFFECTIVE_URL, &effectiveUrl);
+                        const std::string targetUrl = effectiveUrl ? effectiveUrl : siteOutput->siteUrl;
+                        if(message->data.result == CURLE_OK)
+                            archive->recordResponse(siteOutput->siteUrl, targetUrl, siteOutput->responseHeaders, siteOutput->siteContents, fetchSeconds);
+                        else
+                            archive->recordFailure(siteOutput->siteUrl, targetUrl, message->data.result, httpStatus, fetchSeconds);
+                    }
+                    siteData empty;
+                    // Deallocate memory; Prevents bloat caused by large sites or URLs. Partial data of failed transfers is dropped too
+                    siteOutput->siteContents = empty.siteContents;
+                    siteOutput->siteUrl = empty.siteUrl;
+                    siteOutput->trace = nullptr;
+                    siteOutput->responseHeaders = empty.responseHeaders;
                     handlesWaitingForNewURLs.push(eHandle);
                     workDone = true;
                 }
@@ -206,7 +292,7 @@ size_t CurlThread::curlWriteDataCallback(char* ptr, size_t size, size_t nmemb, s
 
     // Gets total size of all strings representing the site's content
     std::size_t currentContentSize = 0;
-    for(std::string e : buffer->siteContents) {
+    for(const std::string& e : buffer->siteContents) {
         currentContentSize += e.size();
     }
 
@@ -224,7 +310,7 @@ size_t CurlThread::curlWriteDataCallback(char* ptr, size_t size, size_t nmemb, s
     }
     
     // When the string is less than size 100000, the char * ptr variable is converted to a string and pushed to the buffer's string vector
-    str.assign(ptr);
+    str.assign(ptr, charsToParse);
     if(currentContentSize + str.size() < buffer->maxContentBytes)
         buffer->siteContents.push_back(str);
 
@@ -232,11 +318,109 @@ size_t CurlThread::curlWriteDataCallback(char* ptr, size_t size, size_t nmemb, s
     return nmemb;
 };
 
+size_t CurlThread::curlWriteHeaderCallback(char* ptr, size_t size, size_t nmemb, siteData* buffer) {
+    const std::string statusLinePrefix = "HTTP/";
+
+    // A status line starts a new response, such as the next response of a redirect chain
+    if(nmemb >= statusLinePrefix.size() && statusLinePrefix.compare(0, statusLinePrefix.size(), ptr, statusLinePrefix.size()) == 0)
+        buffer->responseHeaders.clear();
+    buffer->responseHeaders.append(ptr, nmemb);
+    return nmemb;
+}
+
+void CurlThread::replayUrls() {
+    const int maxUrlLength = 2097152;
+    const int maxOutputQueue = 1000;
+    // Responses are due at arbitrary times, so the loop sleeps for less than sleepLockMilliseconds while any are in flight
+    const std::chrono::milliseconds maxReplaySleep = std::chrono::milliseconds(5);
+
+    // A replayed transfer, and the time its response is due
+    struct replayedTransfer {
+        std::chrono::steady_clock::time_point dueAt;
+        siteData page;
+        int curlCode;
+    };
+    const auto dueLater = [](const std::shared_ptr<replayedTransfer>& a, const std::shared_ptr<replayedTransfer>& b) {
+        return a->dueAt > b->dueAt;
+    };
+    // The transfers in flight, earliest due first
+    std::priority_queue<std::shared_ptr<replayedTransfer>, std::vector<std::shared_ptr<replayedTransfer>>, decltype(dueLater)> inFlight(dueLater);
+
+    std::string url;
+    warcResponse response;
+    do {
+        bool workDone = false;
+
+        // Start transfers while there are free connections, as when fetching
+        while((int)inFlight.size() < maxConnections && outputQueue->size() < maxOutputQueue && urlQueue->safePop(&url)) {
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            std::shared_ptr<replayedTransfer> transfer = std::make_shared<replayedTransfer>();
+            transfer->page.siteUrl = url;
+            transfer->dueAt = now;
+            if(archive->replay(url, &response)) {
+                transfer->curlCode = response.curlCode;
+                transfer->page.httpStatus = response.httpStatus;
+                transfer->page.fetchSeconds = archive->replayLatencySeconds(response);
+                transfer->dueAt += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(transfer->page.fetchSeconds));
+                // Bodies are split as curl delivers them, so every replay is analysed in the same chunks
+                const std::size_t bodyBytes = std::min(response.body.size(), (std::size_t)std::max(0, upperByteLimit));
+                for(std::size_t i = 0; i < bodyBytes; i += CURL_MAX_WRITE_SIZE)
+                    transfer->page.siteContents.push_back(response.body.substr(i, std::min<std::size_t>(CURL_MAX_WRITE_SIZE, bodyBytes - i)));
+            } else {
+                transfer->curlCode = CURLE_COULDNT_RESOLVE_HOST;
+            }
+            if(tracer->sample()) {
+                transfer->page.trace = std::make_shared<pageTrace>();
+                transfer->page.trace->handleAssignedAt = now;
+                transfer->page.trace->totalSeconds = transfer->page.fetchSeconds;
+            }
+            inFlight.push(transfer);
+            workDone = true;
+        }
+
+        // Output the responses which are due, the same way fetched responses are output
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        while(!inFlight.empty() && inFlight.top()->dueAt <= now) {
+            std::shared_ptr<replayedTransfer> transfer = inFlight.top();
+            inFlight.pop();
+            siteData& page = transfer->page;
+            if(!page.siteUrl.empty() && page.siteUrl.size() < maxUrlLength) {
+                page.queuedAt = now;
+                if(transfer->curlCode == CURLE_OK) {
+                    if(!page.siteContents.empty())
+                        outputQueue->push(page);
+                } else {
+                    page.transferFailed = true;
+                    page.siteContents.clear();
+                    outputQueue->push(page);
+                }
+            }
+            if(transfer->curlCode != CURLE_OK)
+                metrics->countCurlError(transfer->curlCode);
+            workDone = true;
+        }
+
+        if(!workDone) {
+            std::chrono::steady_clock::duration sleepTime = sleepLockMilliseconds;
+            if(!inFlight.empty())
+                sleepTime = std::min<std::chrono::steady_clock::duration>(maxReplaySleep, inFlight.top()->dueAt - now);
+            std::this_thread::sleep_for(sleepTime);
+        }
+    } while(killSwitch->load() == 0);
+
+    std::cout << "CurlThread Replay Exiting\n";
+    cleanup();
+}
+
 void CurlThread::updateHandleURL(CURL* eHandle, std::string url) {
     std::unordered_map<CURL*, siteData*>::iterator it = easyHandles.find(eHandle);
 
     // Find the the curl handle, update the siteData with a new URL
     it->second->siteUrl = url.c_str();
+    if(tracer->sample()) {
+        it->second->trace = std::make_shared<pageTrace>();
+        it->second->trace->handleAssignedAt = std::chrono::steady_clock::now();
+    }
     
     // Update the multi handle by removing and readding the changed handle
     curl_multi_remove_handle(multiHandle, eHandle);
@@ -3,8 +3,12 @@
 
 #include "Config.h"
 #include "CurlInteractionStructs.h"
+#include "MetricsRegistry.h"
+#include "PageTracer.h"
 #include "ThreadSafeQueue.h"
+#include "WarcArchive.h"
 #include <atomic>
+#include <chrono>
 #include <curl/curl.h>
 #include <iostream>
 #include <queue>
@@ -17,6 +21,9 @@
  * Implementation of libcurl.
  * 
  * CurlThread takes a string representation of a URL and points curl at the specified URL. The output is then handled and returned as a string.
+ * 
+ * Responses can be recorded to a WARC archive as they are fetched. When the archive replays, CurlThread answers URLs
+ * from the archive rather than the network.
  */
 class CurlThread {
     public:
@@ -36,8 +43,14 @@ class CurlThread {
          *          Curl_BytesToRead the number of bytes to read.
          *          Curl_MaxRedirects the maximum number of redirects to follow in the case of a 3XX response code.
          *          Curl_Timeout the time CurlThread allots to an exceptionally slow connection before the connection is closed.
+         *          Curl_DefaultProtocol the protocol used for URLs without a scheme, either "http" or "https". Defaults to "https".
+         *          Curl_ConnectTo comma separated curl CONNECT_TO entries (HOST:PORT:CONNECT-TO-HOST:CONNECT-TO-PORT), which
+         *              send connections to another server. An empty HOST or PORT matches any. Defaults to none.
+         * @param metricsRegistry a pointer to the registry the curl error codes of failed transfers are counted in.
+         * @param pageTracer a pointer to the tracer which decides which pages carry a trace.
+         * @param warcArchive a pointer to the archive responses are recorded to, or replayed from.
          */
-        CurlThread(curlIO cIO, std::atomic<int>* kSwitch, Config* config);
+        CurlThread(curlIO cIO, std::atomic<int>* kSwitch, Config* config, MetricsRegistry* metricsRegistry, PageTracer* pageTracer, WarcArchive* warcArchive);
 
         // Performs the libcurl cleanup operations.
         void cleanup();
@@ -50,6 +63,8 @@ class CurlThread {
          * 
          * Libcurl easy handles which have completed their transfers are placed in the handlesWaitingForNewURLs
          * queue to await additional URLs.
+         * 
+         * If the archive replays, URLs are answered by replayUrls instead.
          */
         void consumeUrls();
 
@@ -63,9 +78,16 @@ class CurlThread {
 
         std::atomic<int>* killSwitch;
 
+        MetricsRegistry* metrics = nullptr;
+        PageTracer* tracer = nullptr;
+        WarcArchive* archive = nullptr;
+
+        int maxConnections;
+
         std::unordered_map<CURL*, siteData*> easyHandles;
 
         struct curl_slist* HTTPHeaderOptions;
+        struct curl_slist* connectToOptions;
 
         std::chrono::milliseconds sleepLockMilliseconds;
 
@@ -81,11 +103,32 @@ class CurlThread {
          */
         static size_t curlWriteDataCallback(char* ptr, size_t size, size_t nmemb, siteData* buffer);
 
+        /**
+         * Static callback which follows the prototype found at https://curl.se/libcurl/c/CURLOPT_HEADERFUNCTION.html.
+         * Keeps the headers of the latest response, so only the final response of a redirect chain is recorded.
+         * 
+         * @param[in] ptr a pointer to the header line delivered by curl.
+         * @param[in] size "size is always 1" (https://curl.se/libcurl/c/CURLOPT_HEADERFUNCTION.html).
+         * @param[in] nmemb the size of the header line.
+         * @param[out] buffer the siteData object the headers are written to.
+         */
+        static size_t curlWriteHeaderCallback(char* ptr, size_t size, size_t nmemb, siteData* buffer);
+
+        /**
+         * Answers URLs from the archive until the kill switch is thrown.
+         * 
+         * Each URL is held back by the archive's latency model before its response is output, and at most the
+         * maximum number of connections are in flight at once, as when fetching. URLs the archive holds no response
+         * to fail as though their host could not be resolved.
+         */
+        void replayUrls();
+
         
         /**
          * updateHandleURL updates the easy handle with a new URL.
          * 
-         * The easy handle is removed and re-added to the multi handle to update the values.
+         * The easy handle is removed and re-added to the multi handle to update the values. If the page is sampled, a
+         * trace is started for it.
          * 
          * @param eHandle the handle to refresh.
          * @param url the URL the handle should query next.
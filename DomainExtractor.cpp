@@ -0,0 +1,109 @@
+#include "DomainExtractor.h"
+#include "TopLevelDomains.h"
+#include <array>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Builds the byte to character class table.
+ * 
+ * Word characters (\w) and hyphens make up labels, dots separate labels, and every other byte is a delimiter.
+ */
+static constexpr std::array<unsigned char, 256> buildCharacterClasses(unsigned char delimiter, unsigned char letter, unsigned char label, unsigned char dot) {
+    std::array<unsigned char, 256> classes {};
+    for(int c = 0; c < 256; c++) {
+        if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+            classes[c] = letter;
+        else if((c >= '0' && c <= '9') || c == '_' || c == '-')
+            classes[c] = label;
+        else if(c == '.')
+            classes[c] = dot;
+        else
+            classes[c] = delimiter;
+    }
+    return classes;
+}
+
+const std::array<unsigned char, 256> DomainExtractor::CHARACTER_CLASSES = buildCharacterClasses(delimiterCharacter, letterCharacter, labelCharacter, dotCharacter);
+
+DomainExtractor::DomainExtractor(std::string_view data) {
+    buffer = data;
+    position = 0;
+}
+
+DomainExtractor::characterClass DomainExtractor::classAt(std::size_t index) const {
+    return (characterClass)CHARACTER_CLASSES[(unsigned char)buffer[index]];
+}
+
+bool DomainExtractor::nextCandidate(std::string_view* domain, std::string_view* topLevelDomain) {
+    const char functionCallCharacter = '(';
+    const std::size_t size = buffer.size();
+
+    while(position < size) {
+        // A candidate must be preceded by a delimiter
+        if(classAt(position) != delimiterCharacter) {
+            position++;
+            continue;
+        }
+        const std::size_t start = position + 1;
+        std::size_t i = start;
+
+        // The first label must be non-empty and followed by a dot
+        while(i < size && (classAt(i) == letterCharacter || classAt(i) == labelCharacter))
+            i++;
+        if(i == start || i == size || classAt(i) != dotCharacter) {
+            position = i;
+            continue;
+        }
+
+        /**
+         * Walk the chain of dotted labels. The top level domain starts after the last dot whose next byte is a letter,
+         * which is where the expression settles after backtracking out of the repeated label group.
+         */
+        std::size_t topLevelStart = 0;
+        while(i < size && classAt(i) == dotCharacter) {
+            i++;
+            if(i < size && classAt(i) == letterCharacter)
+                topLevelStart = i;
+            const std::size_t labelStart = i;
+            while(i < size && (classAt(i) == letterCharacter || classAt(i) == labelCharacter))
+                i++;
+            if(i == labelStart)
+                break;
+        }
+        if(topLevelStart == 0) {
+            position = i;
+            continue;
+        }
+
+        std::size_t end = topLevelStart;
+        while(end < size && classAt(end) == letterCharacter)
+            end++;
+        position = end;
+
+        // Exclude matches that are followed by a `(` character to reduce false positives
+        if(end < size && buffer[end] == functionCallCharacter)
+            continue;
+
+        *domain = buffer.substr(start, end - start);
+        *topLevelDomain = buffer.substr(topLevelStart, end - topLevelStart);
+        return true;
+    }
+    return false;
+}
+
+void DomainExtractor::extractDomains(const std::vector<std::string>& data, std::queue<std::string>* extractedDomains) {
+    std::string_view domain;
+    std::string_view topLevelDomain;
+
+    // For every chunk of the page, keep the domains with a valid top level domain
+    for(const std::string& chunk : data) {
+        DomainExtractor extractor(chunk);
+        while(extractor.nextCandidate(&domain, &topLevelDomain)) {
+            if(TopLevelDomains::contains(topLevelDomain))
+                extractedDomains->push(std::string(domain));
+        }
+    }
+}
\ No newline at end of file
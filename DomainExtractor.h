@@ -0,0 +1,72 @@
+#ifndef DOMAINEXTRACTOR_H
+#define DOMAINEXTRACTOR_H
+
+#include <array>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * DomainExtractor is a single-pass scanner which pulls domain-like strings out of a buffer.
+ * 
+ * The scanner accepts exactly what the expression [^\w\.\-]([\w-]+?\.(([\w-]+?\.)+)?([a-zA-Z]+)) accepts, without
+ * backtracking and without allocating. Bytes are mapped to character classes through a lookup table, and each
+ * candidate is read left to right once.
+ * 
+ * Candidates are returned as views into the scanned buffer, so the buffer must outlive the extractor.
+ */
+class DomainExtractor {
+    public:
+
+        /**
+         * Constructor.
+         * 
+         * @param data the buffer to scan.
+         */
+        DomainExtractor(std::string_view data);
+
+        /**
+         * Finds the next domain-like string in the buffer.
+         * 
+         * Candidates immediately followed by a `(` character are skipped, as they are usually function calls
+         * rather than domains.
+         * 
+         * @param[out] domain the domain-like string, e.g. "pool.example.com".
+         * @param[out] topLevelDomain the trailing run of letters of the domain, e.g. "com".
+         * @return true if a candidate was found, false once the buffer is exhausted.
+         */
+        bool nextCandidate(std::string_view* domain, std::string_view* topLevelDomain);
+
+        /**
+         * Pulls every domain-like string with a valid top level domain out of a page, as the crawler does.
+         * 
+         * @param[in] data the page, split into chunks. Domains split across two chunks are not found.
+         * @param[out] extractedDomains a pointer to the queue the domains are pushed to.
+         */
+        static void extractDomains(const std::vector<std::string>& data, std::queue<std::string>* extractedDomains);
+
+    private:
+        // The classes a byte can fall in. Letters and other label characters are split, as only letters may start a top level domain
+        enum characterClass : unsigned char {
+            delimiterCharacter,
+            letterCharacter,
+            labelCharacter,
+            dotCharacter
+        };
+
+        static const std::array<unsigned char, 256> CHARACTER_CLASSES;
+
+        std::string_view buffer;
+        std::size_t position;
+
+        /**
+         * Gets the character class of the byte at an index.
+         * 
+         * @param index the index of the byte. Must be less than the buffer size.
+         * @return the character class of the byte.
+         */
+        characterClass classAt(std::size_t index) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "DomainFilterSet.h"
+#include "BloomFilter.h"
+#include "Checkpoint.h"
+#include "Config.h"
+#include "DomainInternTable.h"
+#include "ThreadSafeSet.h"
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+DomainFilterSet::DomainFilterSet(Config* config, DomainInternTable* dTable) {
+    const int defaultExpectedDomains = 10000000;
+    const int defaultFalsePositivesPerMillion = 1000;
+    const int defaultBloomOnly = 0;
+    const double partsPerMillion = 1000000.0;
+
+    const int expectedDomains = config->getIntConfig("DomainFilter_ExpectedDomains", defaultExpectedDomains, 1, INT_MAX);
+    const int falsePositivesPerMillion = config->getIntConfig("DomainFilter_FalsePositivesPerMillion", defaultFalsePositivesPerMillion, 1, 999999);
+    domainTable = dTable;
+    bloomOnly = config->getIntConfig("DomainFilter_BloomOnly", defaultBloomOnly, 0, 1) == 1;
+    filter = BloomFilter(expectedDomains, falsePositivesPerMillion / partsPerMillion);
+}
+
+bool DomainFilterSet::contains(std::uint32_t domainId) {
+    if(!filter.mayContain(domainTable->lookup(domainId)))
+        return false;
+    if(bloomOnly)
+        return true;
+    return exactSet.contains(domainId);
+}
+
+bool DomainFilterSet::contains(std::string_view domain) {
+    std::uint32_t domainId;
+    if(!filter.mayContain(domain))
+        return false;
+    if(bloomOnly)
+        return true;
+    // A domain that was never interned can't be in the exact set
+    return domainTable->find(domain, &domainId) && exactSet.contains(domainId);
+}
+
+bool DomainFilterSet::safeInsert(std::uint32_t domainId) {
+    const bool definitelyNew = filter.insert(domainTable->lookup(domainId));
+    if(bloomOnly)
+        return definitelyNew;
+    return exactSet.safeInsert(domainId);
+}
+
+void DomainFilterSet::saveState(CheckpointWriter* writer) {
+    filter.saveState(writer);
+    writer->writeUint(bloomOnly ? 0 : exactSet.size());
+    if(!bloomOnly)
+        exactSet.forEach([this, writer](const std::uint32_t& domainId) { writer->writeString(domainTable->lookup(domainId)); });
+}
+
+bool DomainFilterSet::loadState(CheckpointReader* reader) {
+    /**
+     * The saved filter replaces this one, as filters of different sizes can't be merged. Domains already in the
+     * exact set are added back to it.
+     */
+    std::string domain;
+    std::uint64_t count;
+    BloomFilter currentFilter = std::move(filter);
+    if(!filter.loadState(reader)) {
+        filter = std::move(currentFilter);
+        return false;
+    }
+    exactSet.forEach([this](const std::uint32_t& domainId) { filter.insert(domainTable->lookup(domainId)); });
+
+    if(!reader->readUint(&count))
+        return false;
+    for(std::uint64_t i = 0; i < count; i++) {
+        if(!reader->readString(&domain))
+            return false;
+        const std::uint32_t domainId = domainTable->intern(domain);
+        if(domainId != 0)
+            safeInsert(domainId);
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef DOMAINFILTERSET_H
+#define DOMAINFILTERSET_H
+
+#include "BloomFilter.h"
+#include "Checkpoint.h"
+#include "Config.h"
+#include "DomainInternTable.h"
+#include "ThreadSafeSet.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * DomainFilterSet is a set of domains with a Bloom filter in front of an exact set.
+ * 
+ * Domains are held as their ids in the shared DomainInternTable. The filter hashes the domain itself rather than
+ * its id, so a saved filter stays valid when ids are reassigned on resume.
+ * 
+ * Domains the filter has never seen are answered by the filter alone, without taking the exact set's lock. In
+ * memory-capped mode, the exact set is dropped and the filter answers every query, so a small share of new domains
+ * are taken to have been seen already. Domains can be queried by name, so callers can leave a domain out of the
+ * intern table until they know it is new.
+ * 
+ * This class is thread-safe.
+ */
+class DomainFilterSet {
+    public:
+
+        /**
+         * Constructor.
+         * 
+         * @param config a pointer to the object holding the program's configurations.
+         *      DomainFilterSet Configs:
+         *          DomainFilter_ExpectedDomains the number of domains the filter is sized for.
+         *          DomainFilter_FalsePositivesPerMillion the filter's false positive rate, in parts per million.
+         *          DomainFilter_BloomOnly 1 to keep only the filter and drop the exact set, 0 to keep both.
+         * @param dTable a pointer to the table domain ids are interned in.
+         */
+        DomainFilterSet(Config* config, DomainInternTable* dTable);
+
+        /**
+         * Checks whether the set contains a domain.
+         * 
+         * @param domainId the id of the domain to search for.
+         * @return true if the set contains the domain, false otherwise. In memory-capped mode, may be a false positive.
+         */
+        bool contains(std::uint32_t domainId);
+
+        /**
+         * Checks whether the set contains a domain, without interning it.
+         * 
+         * @param domain the domain to search for.
+         * @return true if the set contains the domain, false otherwise. In memory-capped mode, may be a false positive.
+         */
+        bool contains(std::string_view domain);
+
+        /**
+         * Inserts a domain into the set.
+         * 
+         * @param domainId the id of the domain to insert.
+         * @return true if the domain was not in the set before, false otherwise. In memory-capped mode, a new domain
+         *      may be reported as already in the set.
+         */
+        bool safeInsert(std::uint32_t domainId);
+
+        /**
+         * Writes the filter, and the exact set if it is kept, to a checkpoint.
+         * 
+         * @param writer a pointer to the checkpoint writer.
+         */
+        void saveState(CheckpointWriter* writer);
+
+        /**
+         * Merges the set saved to a checkpoint into this set. Must not be called while the set is in use.
+         * 
+         * @param reader a pointer to the checkpoint reader.
+         * @return true if the set was read, false if the checkpoint is corrupt.
+         */
+        bool loadState(CheckpointReader* reader);
+
+    private:
+        BloomFilter filter;
+        ThreadSafeSet<std::uint32_t> exactSet;
+        DomainInternTable* domainTable;
+        bool bloomOnly;
+};
+
+#endif
\ No newline at end of file
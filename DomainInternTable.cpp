@@ -0,0 +1,97 @@
+#include "DomainInternTable.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+DomainInternTable::DomainInternTable() {
+    viewChunks.reset(new std::atomic<std::string_view*>[VIEW_CHUNK_COUNT]);
+    for(std::uint32_t i = 0; i < VIEW_CHUNK_COUNT; i++)
+        viewChunks[i].store(nullptr);
+    // Id 0 is reserved
+    nextId = 1;
+    full = false;
+}
+
+DomainInternTable::~DomainInternTable() {
+    for(std::uint32_t i = 0; i < VIEW_CHUNK_COUNT; i++)
+        delete[] viewChunks[i].load();
+}
+
+std::uint32_t DomainInternTable::intern(std::string_view domain) {
+    internShard& shard = shards[std::hash<std::string_view>()(domain) % SHARD_COUNT];
+    std::lock_guard<std::mutex> lock(shard.mu);
+    std::unordered_map<std::string_view, std::uint32_t>::iterator it = shard.ids.find(domain);
+    if(it != shard.ids.end())
+        return it->second;
+
+    const std::uint32_t id = nextId.fetch_add(1);
+    if(id >= MAX_IDS) {
+        nextId.store(MAX_IDS);
+        if(!full.exchange(true))
+            std::cout << "ERROR: Domain Intern Table Is Full, New Domains Will Be Dropped\n";
+        return 0;
+    }
+    const std::string_view stored = storeCharacters(&shard, domain);
+    // The view is written before the id is returned, so any thread the id is handed to can look it up
+    *viewSlot(id) = stored;
+    shard.ids.emplace(stored, id);
+    return id;
+}
+
+bool DomainInternTable::find(std::string_view domain, std::uint32_t* id) {
+    internShard& shard = shards[std::hash<std::string_view>()(domain) % SHARD_COUNT];
+    std::lock_guard<std::mutex> lock(shard.mu);
+    std::unordered_map<std::string_view, std::uint32_t>::iterator it = shard.ids.find(domain);
+    if(it == shard.ids.end())
+        return false;
+    *id = it->second;
+    return true;
+}
+
+std::string_view DomainInternTable::lookup(std::uint32_t id) const {
+    if(id == 0 || id >= MAX_IDS)
+        return std::string_view();
+    const std::string_view* chunk = viewChunks[id / VIEW_CHUNK_SIZE].load();
+    if(!chunk)
+        return std::string_view();
+    return chunk[id % VIEW_CHUNK_SIZE];
+}
+
+std::uint32_t DomainInternTable::size() const {
+    return nextId.load() - 1;
+}
+
+std::string_view DomainInternTable::storeCharacters(internShard* shard, std::string_view domain) {
+    // Domains longer than a chunk get a chunk of their own
+    if(shard->chunkUsed + domain.size() > CHARACTER_CHUNK_SIZE) {
+        shard->characterChunks.emplace_back(new char[std::max(CHARACTER_CHUNK_SIZE, domain.size())]);
+        shard->chunkUsed = 0;
+    }
+    char* stored = shard->characterChunks.back().get() + shard->chunkUsed;
+    std::memcpy(stored, domain.data(), domain.size());
+    // A chunk holding one long domain is left full
+    shard->chunkUsed = domain.size() > CHARACTER_CHUNK_SIZE ? CHARACTER_CHUNK_SIZE : shard->chunkUsed + domain.size();
+    return std::string_view(stored, domain.size());
+}
+
+std::string_view* DomainInternTable::viewSlot(std::uint32_t id) {
+    std::atomic<std::string_view*>& chunk = viewChunks[id / VIEW_CHUNK_SIZE];
+    std::string_view* views = chunk.load();
+    if(!views) {
+        std::lock_guard<std::mutex> lock(viewChunkMutex);
+        views = chunk.load();
+        if(!views) {
+            views = new std::string_view[VIEW_CHUNK_SIZE];
+            chunk.store(views);
+        }
+    }
+    return &views[id % VIEW_CHUNK_SIZE];
+}
\ No newline at end of file
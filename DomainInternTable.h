@@ -0,0 +1,112 @@
+#ifndef DOMAININTERNTABLE_H
+#define DOMAININTERNTABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * DomainInternTable maps each distinct domain to a stable 32-bit id, and stores each domain's characters once.
+ * 
+ * The table is split into shards by hash, each with its own lock, map and character storage. Characters are stored
+ * in fixed-size chunks which are never moved, so the views returned by lookup stay valid for the table's lifetime.
+ * Ids index a chunked array of views which is read without a lock.
+ * 
+ * Id 0 is never assigned, so it can mark an empty slot or a missing domain. It is also what intern returns once the
+ * table is full, so callers skip any domain interned as 0.
+ * 
+ * This class is thread-safe, as long as ids are handed between threads through a synchronized queue or set, as
+ * every id in the program is. Domains are never removed.
+ */
+class DomainInternTable {
+    public:
+
+        /**
+         * Constructor.
+         */
+        DomainInternTable();
+
+        // Frees the table's storage.
+        ~DomainInternTable();
+
+        DomainInternTable(const DomainInternTable&) = delete;
+        DomainInternTable& operator=(const DomainInternTable&) = delete;
+
+        /**
+         * Gets the id of a domain, adding the domain to the table if it is new. Prints an error the first time a new
+         * domain doesn't fit.
+         * 
+         * @param domain the domain.
+         * @return the domain's id, or 0 if the table is full.
+         */
+        std::uint32_t intern(std::string_view domain);
+
+        /**
+         * Gets the id of a domain without adding it to the table.
+         * 
+         * @param[in] domain the domain.
+         * @param[out] id the domain's id.
+         * @return true if the domain is in the table, false otherwise.
+         */
+        bool find(std::string_view domain, std::uint32_t* id);
+
+        /**
+         * Gets the domain of an id.
+         * 
+         * @param id an id returned by intern.
+         * @return a view of the domain, valid for the table's lifetime. Empty for id 0 and unknown ids.
+         */
+        std::string_view lookup(std::uint32_t id) const;
+
+        /**
+         * Gets the number of domains in the table.
+         * 
+         * @return the number of domains.
+         */
+        std::uint32_t size() const;
+
+    private:
+        static constexpr int SHARD_COUNT = 64;
+        static constexpr std::size_t CHARACTER_CHUNK_SIZE = 1 << 20;
+        static constexpr std::uint32_t VIEW_CHUNK_SIZE = 1 << 16;
+        static constexpr std::uint32_t VIEW_CHUNK_COUNT = 1 << 15;
+        static constexpr std::uint32_t MAX_IDS = VIEW_CHUNK_SIZE * VIEW_CHUNK_COUNT;
+
+        struct internShard {
+            std::mutex mu;
+            std::unordered_map<std::string_view, std::uint32_t> ids;
+            std::vector<std::unique_ptr<char[]>> characterChunks;
+            std::size_t chunkUsed = CHARACTER_CHUNK_SIZE;
+        };
+
+        internShard shards[SHARD_COUNT];
+
+        // The view of each id, in chunks allocated as ids are assigned
+        std::unique_ptr<std::atomic<std::string_view*>[]> viewChunks;
+        std::atomic<std::uint32_t> nextId;
+        std::atomic<bool> full;
+        std::mutex viewChunkMutex;
+
+        /**
+         * Stores a domain's characters in a shard's chunks. Must be called with the shard's lock held.
+         * 
+         * @param shard a pointer to the shard.
+         * @param domain the domain to store.
+         * @return a view of the stored characters.
+         */
+        std::string_view storeCharacters(internShard* shard, std::string_view domain);
+
+        /**
+         * Gets the slot holding an id's view, allocating the slot's chunk if needed.
+         * 
+         * @param id the id.
+         * @return a pointer to the slot.
+         */
+        std::string_view* viewSlot(std::uint32_t id);
+};
+
+#endif
\ No newline at end of file
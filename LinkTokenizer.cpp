@@ -0,0 +1,283 @@
+#include "LinkTokenizer.h"
+#include <cstring>
+#include <queue>
+#include <string>
+#include <string_view>
+
+/**
+ * Checks whether a character is HTML whitespace.
+ * 
+ * @param c the character to check.
+ * @return true if the character is a space, tab, line feed, form feed or carriage return.
+ */
+static bool isHtmlWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\f' || c == '\r';
+}
+
+/**
+ * Lowercases an ASCII character.
+ * 
+ * @param c the character to lowercase.
+ * @return the lowercase character.
+ */
+static char toLowerAscii(char c) {
+    if(c >= 'A' && c <= 'Z')
+        return c - 'A' + 'a';
+    return c;
+}
+
+/**
+ * Compares a string to a lowercase string, ignoring ASCII case.
+ * 
+ * @param str the string to compare.
+ * @param lowercase the lowercase string to compare against.
+ * @return true if the strings are equal, ignoring case.
+ */
+static bool equalsIgnoreCase(std::string_view str, std::string_view lowercase) {
+    if(str.size() != lowercase.size())
+        return false;
+    for(std::size_t i = 0; i < str.size(); i++) {
+        if(toLowerAscii(str[i]) != lowercase[i])
+            return false;
+    }
+    return true;
+}
+
+LinkTokenizer::LinkTokenizer(bool includeEmbeddedLinks) {
+    // Tags longer than this are dropped rather than carried between chunks
+    const std::size_t defaultMaxPendingTagSize = 65536;
+
+    followEmbeddedLinks = includeEmbeddedLinks;
+    maxPendingTagSize = defaultMaxPendingTagSize;
+
+    state = textState;
+    carryingTag = false;
+    discardingTag = false;
+    tagQuote = 0;
+    tagAfterEquals = false;
+    commentDashes = 0;
+    rawTextMatched = 0;
+}
+
+void LinkTokenizer::tokenize(std::string_view chunk, std::queue<htmlLink>* links) {
+    const std::string_view endTagOpen = "</";
+    const std::size_t size = chunk.size();
+
+    // The index of the first character after the `<` of the current tag, if the tag started in this chunk
+    std::size_t tagStart = 0;
+    std::size_t i = 0;
+
+    completedTag.clear();
+
+    while(i < size) {
+        const char c = chunk[i];
+        switch(state) {
+            case textState: {
+                // Skip straight to the next tag
+                const char* tagOpen = (const char*)std::memchr(chunk.data() + i, '<', size - i);
+                if(!tagOpen) {
+                    i = size;
+                    continue;
+                }
+                i = tagOpen - chunk.data() + 1;
+                tagStart = i;
+                carryingTag = false;
+                discardingTag = false;
+                tagQuote = 0;
+                tagAfterEquals = false;
+                state = tagOpenState;
+                continue;
+            }
+            case tagOpenState:
+                if(c == '!')
+                    state = markupState;
+                else if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '/')
+                    state = tagState;
+                // A lone `<` is text, so the character is read again as text
+                else {
+                    state = textState;
+                    continue;
+                }
+                break;
+            case markupState:
+                if(c == '-')
+                    state = markupDashState;
+                else {
+                    state = tagState;
+                    continue;
+                }
+                break;
+            case markupDashState:
+                if(c == '-') {
+                    state = commentState;
+                    commentDashes = 0;
+                } else {
+                    state = tagState;
+                    continue;
+                }
+                break;
+            case commentState:
+                if(c == '>' && commentDashes >= 2)
+                    state = textState;
+                else if(c == '-')
+                    commentDashes++;
+                else
+                    commentDashes = 0;
+                break;
+            case tagState:
+                if(tagQuote) {
+                    if(c == tagQuote)
+                        tagQuote = 0;
+                } else if(c == '>') {
+                    std::string_view tag;
+                    if(carryingTag && !discardingTag) {
+                        pendingTag.append(chunk.data(), i);
+                        completedTag.swap(pendingTag);
+                        pendingTag.clear();
+                        tag = completedTag;
+                    } else if(!carryingTag && !discardingTag)
+                        tag = chunk.substr(tagStart, i - tagStart);
+                    i++;
+                    finishTag(tag, links);
+                    continue;
+                } else if(c == '=')
+                    tagAfterEquals = true;
+                // Quotes only delimit attribute values
+                else if((c == '"' || c == '\'') && tagAfterEquals) {
+                    tagQuote = c;
+                    tagAfterEquals = false;
+                } else if(!isHtmlWhitespace(c))
+                    tagAfterEquals = false;
+                break;
+            case rawTextState: {
+                if(rawTextMatched == 0) {
+                    const char* tagOpen = (const char*)std::memchr(chunk.data() + i, '<', size - i);
+                    if(!tagOpen) {
+                        i = size;
+                        continue;
+                    }
+                    i = tagOpen - chunk.data() + 1;
+                    rawTextMatched = 1;
+                    continue;
+                }
+                // Match the end tag one character at a time, as it may be split between chunks
+                const char expected = rawTextMatched < endTagOpen.size() ? endTagOpen[rawTextMatched] : rawTextEndTag[rawTextMatched - endTagOpen.size()];
+                if(toLowerAscii(c) == expected) {
+                    rawTextMatched++;
+                    if(rawTextMatched == endTagOpen.size() + rawTextEndTag.size()) {
+                        state = tagState;
+                        carryingTag = false;
+                        discardingTag = true;
+                        tagQuote = 0;
+                        tagAfterEquals = false;
+                    }
+                } else {
+                    rawTextMatched = 0;
+                    continue;
+                }
+                break;
+            }
+        }
+        i++;
+    }
+
+    // Carry an unfinished tag over to the next chunk
+    if((state == tagOpenState || state == markupState || state == markupDashState || state == tagState) && !discardingTag) {
+        if(carryingTag)
+            pendingTag.append(chunk.data(), size);
+        else {
+            pendingTag.assign(chunk.data() + tagStart, size - tagStart);
+            carryingTag = true;
+        }
+        if(pendingTag.size() > maxPendingTagSize) {
+            pendingTag.clear();
+            discardingTag = true;
+        }
+    }
+}
+
+void LinkTokenizer::finishTag(std::string_view tag, std::queue<htmlLink>* links) {
+    const bool parse = !discardingTag;
+    state = textState;
+    carryingTag = false;
+    discardingTag = false;
+    if(parse && parseTag(tag, links)) {
+        state = rawTextState;
+        rawTextMatched = 0;
+    }
+}
+
+bool LinkTokenizer::parseTag(std::string_view tag, std::queue<htmlLink>* links) {
+    const std::size_t size = tag.size();
+
+    // End tags, comments, and declarations such as <!DOCTYPE> carry no links
+    if(size == 0 || !((tag[0] >= 'a' && tag[0] <= 'z') || (tag[0] >= 'A' && tag[0] <= 'Z')))
+        return false;
+
+    std::size_t i = 0;
+    while(i < size && !isHtmlWhitespace(tag[i]) && tag[i] != '/')
+        i++;
+    const std::string_view tagName = tag.substr(0, i);
+
+    std::string_view wantedAttribute;
+    bool isBase = false;
+    if(equalsIgnoreCase(tagName, "a") || equalsIgnoreCase(tagName, "area"))
+        wantedAttribute = "href";
+    else if(equalsIgnoreCase(tagName, "base")) {
+        wantedAttribute = "href";
+        isBase = true;
+    } else if(followEmbeddedLinks && equalsIgnoreCase(tagName, "link"))
+        wantedAttribute = "href";
+    else if(followEmbeddedLinks && (equalsIgnoreCase(tagName, "iframe") || equalsIgnoreCase(tagName, "frame")))
+        wantedAttribute = "src";
+    else if(equalsIgnoreCase(tagName, "script")) {
+        rawTextEndTag = "script";
+        return true;
+    } else if(equalsIgnoreCase(tagName, "style")) {
+        rawTextEndTag = "style";
+        return true;
+    }
+
+    if(wantedAttribute.empty())
+        return false;
+
+    while(i < size) {
+        while(i < size && (isHtmlWhitespace(tag[i]) || tag[i] == '/'))
+            i++;
+        const std::size_t nameStart = i;
+        while(i < size && !isHtmlWhitespace(tag[i]) && tag[i] != '=' && tag[i] != '/')
+            i++;
+        const std::string_view attributeName = tag.substr(nameStart, i - nameStart);
+
+        while(i < size && isHtmlWhitespace(tag[i]))
+            i++;
+        std::string_view attributeValue;
+        if(i < size && tag[i] == '=') {
+            i++;
+            while(i < size && isHtmlWhitespace(tag[i]))
+                i++;
+            if(i < size && (tag[i] == '"' || tag[i] == '\'')) {
+                const char quote = tag[i];
+                const std::size_t valueStart = ++i;
+                while(i < size && tag[i] != quote)
+                    i++;
+                attributeValue = tag.substr(valueStart, i - valueStart);
+                if(i < size)
+                    i++;
+            } else {
+                const std::size_t valueStart = i;
+                while(i < size && !isHtmlWhitespace(tag[i]))
+                    i++;
+                attributeValue = tag.substr(valueStart, i - valueStart);
+            }
+        }
+
+        // Only the first occurrence of an attribute counts
+        if(equalsIgnoreCase(attributeName, wantedAttribute)) {
+            if(!attributeValue.empty())
+                links->push(htmlLink {attributeValue, isBase});
+            return false;
+        }
+    }
+    return false;
+}
\ No newline at end of file
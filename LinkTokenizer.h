@@ -0,0 +1,98 @@
+#ifndef LINKTOKENIZER_H
+#define LINKTOKENIZER_H
+
+#include <queue>
+#include <string>
+#include <string_view>
+
+/**
+ * A structure representing a link found in an HTML document.
+ * 
+ * The url is a view into either the chunk passed to LinkTokenizer::tokenize, or a buffer owned by the tokenizer.
+ */
+struct htmlLink {
+    std::string_view url;
+    bool isBase;
+};
+
+/**
+ * LinkTokenizer is a streaming HTML tag tokenizer which extracts link targets in a single pass.
+ * 
+ * The tokenizer reads tags out of the document one chunk at a time, and carries any tag which is split between
+ * chunks over to the next call. Double-quoted, single-quoted and unquoted attribute values are supported. Comments
+ * and the contents of script and style elements are skipped.
+ * 
+ * Links are reported for <a href>, <area href> and <base href>, and optionally for <link href>, <iframe src> and
+ * <frame src>.
+ */
+class LinkTokenizer {
+    public:
+
+        /**
+         * Constructor.
+         * 
+         * @param includeEmbeddedLinks whether <link href>, <iframe src> and <frame src> links are reported.
+         */
+        LinkTokenizer(bool includeEmbeddedLinks);
+
+        /**
+         * Tokenizes the next chunk of a document.
+         * 
+         * The links pushed to the queue are only valid until the next call to tokenize, and while the chunk is alive.
+         * 
+         * @param[in] chunk the next chunk of the document.
+         * @param[out] links a pointer to the queue the found links are pushed to.
+         */
+        void tokenize(std::string_view chunk, std::queue<htmlLink>* links);
+
+    private:
+        enum tokenizerState {
+            textState,
+            tagOpenState,
+            markupState,
+            markupDashState,
+            commentState,
+            tagState,
+            rawTextState
+        };
+
+        tokenizerState state;
+
+        bool followEmbeddedLinks;
+
+        // Holds the start of a tag which did not end in the previous chunk
+        std::string pendingTag;
+        // Holds a carried-over tag completed during the current call. Links may point into this buffer
+        std::string completedTag;
+        bool carryingTag;
+        bool discardingTag;
+
+        char tagQuote;
+        bool tagAfterEquals;
+
+        int commentDashes;
+
+        std::string_view rawTextEndTag;
+        std::size_t rawTextMatched;
+
+        std::size_t maxPendingTagSize;
+
+        /**
+         * Parses the contents of a complete tag, and pushes the wanted attribute value if one is found.
+         * 
+         * @param[in] tag the text between the `<` and `>` characters.
+         * @param[out] links a pointer to the queue the found links are pushed to.
+         * @return true if the tag opens an element whose contents are raw text, false otherwise.
+         */
+        bool parseTag(std::string_view tag, std::queue<htmlLink>* links);
+
+        /**
+         * Completes the current tag and moves the tokenizer to the state following it.
+         * 
+         * @param tag the text between the `<` and `>` characters.
+         * @param[out] links a pointer to the queue the found links are pushed to.
+         */
+        void finishTag(std::string_view tag, std::queue<htmlLink>* links);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,357 @@
+#include "MetricsExporter.h"
+#include "Config.h"
+#include "MetricsRegistry.h"
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+// A counter, and the family and labels it is exported under
+struct exportedCounter {
+    MetricsRegistry::counter counter;
+    const char* family;
+    const char* help;
+    const char* labels;
+};
+
+// A histogram, and the family and labels it is exported under. Microsecond histograms are exported in seconds
+struct exportedHistogram {
+    MetricsRegistry::histogram histogram;
+    const char* family;
+    const char* help;
+    const char* labels;
+    bool microseconds;
+};
+
+// Samples of the same family must be adjacent, and only the first sample of a family carries its help text
+static const exportedCounter EXPORTED_COUNTERS[] = {
+    {MetricsRegistry::crawlerPagesCounter, "cryptocensus_pages_fetched_total", "Pages fetched successfully.", "stage=\"crawler\""},
+    {MetricsRegistry::searcherPagesCounter, "cryptocensus_pages_fetched_total", nullptr, "stage=\"searcher\""},
+    {MetricsRegistry::crawlerFailuresCounter, "cryptocensus_transfers_failed_total", "Transfers which failed.", "stage=\"crawler\""},
+    {MetricsRegistry::searcherFailuresCounter, "cryptocensus_transfers_failed_total", nullptr, "stage=\"searcher\""},
+    {MetricsRegistry::bytesFetchedCounter, "cryptocensus_bytes_fetched_total", "Bytes of page contents fetched.", ""},
+    {MetricsRegistry::domainsExtractedCounter, "cryptocensus_domains_extracted_total", "Domains extracted from crawled pages.", ""},
+    {MetricsRegistry::domainsVerifiedCounter, "cryptocensus_domains_verified_total", "Domains verified as crypto related.", ""},
+    {MetricsRegistry::cachedVerdictsCounter, "cryptocensus_cached_verdicts_total", "Domains answered from the verdict cache.", ""}
+};
+
+static const exportedHistogram EXPORTED_HISTOGRAMS[] = {
+    {MetricsRegistry::crawlerFetchLatencyHistogram, "cryptocensus_fetch_duration_seconds", "Total time of a transfer.", "stage=\"crawler\"", true},
+    {MetricsRegistry::searcherFetchLatencyHistogram, "cryptocensus_fetch_duration_seconds", nullptr, "stage=\"searcher\"", true},
+    {MetricsRegistry::crawlerQueueWaitHistogram, "cryptocensus_queue_wait_seconds", "Time a fetched page waited for analysis.", "stage=\"crawler\"", true},
+    {MetricsRegistry::searcherQueueWaitHistogram, "cryptocensus_queue_wait_seconds", nullptr, "stage=\"searcher\"", true},
+    {MetricsRegistry::matchTimeHistogram, "cryptocensus_match_duration_seconds", "Time spent matching terms on a page.", "", true},
+    {MetricsRegistry::pageBytesHistogram, "cryptocensus_page_bytes", "Size of a fetched page.", "", false}
+};
+
+/**
+ * Formats a whole number of microseconds as decimal seconds, without rounding.
+ * 
+ * @param microseconds the value to format.
+ * @return the value in seconds.
+ */
+static std::string formatMicroseconds(std::uint64_t microseconds) {
+    const std::uint64_t microsecondsPerSecond = 1000000;
+    std::string fraction = std::to_string(microseconds % microsecondsPerSecond);
+    fraction.insert(0, 6 - fraction.size(), '0');
+    while(!fraction.empty() && fraction.back() == '0')
+        fraction.pop_back();
+    const std::string seconds = std::to_string(microseconds / microsecondsPerSecond);
+    return fraction.empty() ? seconds : seconds + "." + fraction;
+}
+
+/**
+ * Formats a sample's labels, with an extra label appended.
+ * 
+ * @param labels the sample's labels, or an empty string.
+ * @param extraLabel the label to append, or an empty string.
+ * @return the label set including its braces, or an empty string if there are no labels.
+ */
+static std::string formatLabels(const std::string& labels, const std::string& extraLabel) {
+    if(labels.empty() && extraLabel.empty())
+        return "";
+    if(labels.empty() || extraLabel.empty())
+        return "{" + labels + extraLabel + "}";
+    return "{" + labels + "," + extraLabel + "}";
+}
+
+/**
+ * Closes a socket.
+ * 
+ * @param socketToClose the socket.
+ */
+static void closeSocket(std::intptr_t socketToClose) {
+#ifdef _WIN32
+    closesocket((SOCKET)socketToClose);
+#else
+    ::close((int)socketToClose);
+#endif
+}
+
+MetricsExporter::MetricsExporter(Config* config, MetricsRegistry* metricsRegistry) {
+    const std::string defaultMetricsFile = "metrics.prom";
+    const int defaultFileIntervalSeconds = 15;
+    const int defaultHttpPort = 0;
+    const int maxPort = 65535;
+
+    metrics = metricsRegistry;
+    metricsFile = config->getConfig("Metrics_File", defaultMetricsFile);
+    fileInterval = std::chrono::seconds(config->getIntConfig("Metrics_FileIntervalSeconds", defaultFileIntervalSeconds, 0, INT_MAX));
+    const int httpPort = config->getIntConfig("Metrics_HttpPort", defaultHttpPort, 0, maxPort);
+    listenSocket = -1;
+    closing = false;
+    stopListening = false;
+
+    if(fileInterval.count() > 0)
+        fileThread = std::thread(&MetricsExporter::fileLoop, this);
+    if(httpPort > 0) {
+        if(openListener(httpPort))
+            httpThread = std::thread(&MetricsExporter::httpLoop, this);
+        else
+            std::cout << "ERROR: Could Not Listen For Metrics Requests On Port: " << httpPort << "\n";
+    }
+}
+
+MetricsExporter::~MetricsExporter() {
+    close();
+}
+
+void MetricsExporter::close() {
+    {
+        std::lock_guard<std::mutex> lock(closingMutex);
+        if(closing)
+            return;
+        closing = true;
+    }
+    wake.notify_one();
+    stopListening = true;
+    if(fileThread.joinable())
+        fileThread.join();
+    if(httpThread.joinable())
+        httpThread.join();
+    if(listenSocket != -1) {
+        closeSocket(listenSocket);
+        listenSocket = -1;
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+}
+
+void MetricsExporter::fileLoop() {
+    std::unique_lock<std::mutex> lock(closingMutex);
+    while(!closing) {
+        wake.wait_for(lock, fileInterval, [this]() { return closing; });
+        lock.unlock();
+        writeFile();
+        lock.lock();
+    }
+}
+
+bool MetricsExporter::writeFile() {
+    metricsSnapshot snapshot;
+    metrics->collect(&snapshot);
+    const std::string contents = renderText(snapshot);
+
+    const std::string temporaryPath = metricsFile + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+        if(!file.is_open() || !file.write(contents.data(), contents.size()) || !file.flush()) {
+            std::cout << "ERROR: Could Not Write Metrics File: " << temporaryPath << "\n";
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, metricsFile, error);
+    if(error) {
+        std::cout << "ERROR: Could Not Replace Metrics File: " << metricsFile << "\n";
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
+
+bool MetricsExporter::openListener(int port) {
+    const int connectionBacklog = 16;
+    const int enableReuseAddress = 1;
+
+#ifdef _WIN32
+    WSADATA wsaData;
+    if(WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+        return false;
+    const SOCKET created = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(created == INVALID_SOCKET) {
+        WSACleanup();
+        return false;
+    }
+#else
+    const int created = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(created < 0)
+        return false;
+#endif
+    setsockopt(created, SOL_SOCKET, SO_REUSEADDR, (const char*)&enableReuseAddress, sizeof(enableReuseAddress));
+
+    // Only the local machine may scrape the metrics
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(bind(created, (const sockaddr*)&address, sizeof(address)) != 0 || listen(created, connectionBacklog) != 0) {
+        closeSocket((std::intptr_t)created);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return false;
+    }
+    listenSocket = (std::intptr_t)created;
+    return true;
+}
+
+void MetricsExporter::httpLoop() {
+    // The stop flag is checked between waits, so closing is not held up by an idle listener
+    const long acceptPollMicroseconds = 100000;
+
+    while(!stopListening.load()) {
+        fd_set readable;
+        FD_ZERO(&readable);
+#ifdef _WIN32
+        FD_SET((SOCKET)listenSocket, &readable);
+#else
+        FD_SET((int)listenSocket, &readable);
+#endif
+        timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = acceptPollMicroseconds;
+        if(select((int)listenSocket + 1, &readable, NULL, NULL, &timeout) <= 0)
+            continue;
+#ifdef _WIN32
+        const SOCKET connection = accept((SOCKET)listenSocket, NULL, NULL);
+        if(connection == INVALID_SOCKET)
+            continue;
+#else
+        const int connection = accept((int)listenSocket, NULL, NULL);
+        if(connection < 0)
+            continue;
+#endif
+        serveConnection((std::intptr_t)connection);
+    }
+}
+
+void MetricsExporter::serveConnection(std::intptr_t connection) {
+    const std::string metricsPath = "/metrics";
+    const std::size_t maxRequestSize = 8192;
+    const int receiveTimeoutMilliseconds = 1000;
+#ifdef MSG_NOSIGNAL
+    const int sendFlags = MSG_NOSIGNAL;
+#else
+    const int sendFlags = 0;
+#endif
+
+    // A client which connects and sends nothing must not hold up the listener for long
+#ifdef _WIN32
+    const DWORD receiveTimeout = receiveTimeoutMilliseconds;
+    setsockopt((SOCKET)connection, SOL_SOCKET, SO_RCVTIMEO, (const char*)&receiveTimeout, sizeof(receiveTimeout));
+#else
+    timeval receiveTimeout;
+    receiveTimeout.tv_sec = receiveTimeoutMilliseconds / 1000;
+    receiveTimeout.tv_usec = (receiveTimeoutMilliseconds % 1000) * 1000;
+    setsockopt((int)connection, SOL_SOCKET, SO_RCVTIMEO, (const char*)&receiveTimeout, sizeof(receiveTimeout));
+#endif
+
+    // Only the request line is needed, so the request is read until its first line ends
+    std::string request;
+    char buffer[1024];
+    while(request.find('\n') == std::string::npos && request.size() < maxRequestSize) {
+        const int received = (int)recv(connection, buffer, sizeof(buffer), 0);
+        if(received <= 0)
+            break;
+        request.append(buffer, received);
+    }
+
+    std::string status = "404 Not Found";
+    std::string body = "Not Found\n";
+    const std::size_t pathStart = request.find(' ');
+    if(pathStart != std::string::npos && request.compare(0, pathStart, "GET") == 0) {
+        const std::size_t pathEnd = request.find_first_of(" ?\r\n", pathStart + 1);
+        const std::string path = request.substr(pathStart + 1, pathEnd == std::string::npos ? std::string::npos : pathEnd - pathStart - 1);
+        if(path == metricsPath || path == "/") {
+            metricsSnapshot snapshot;
+            metrics->collect(&snapshot);
+            status = "200 OK";
+            body = renderText(snapshot);
+        }
+    }
+    const std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: "
+        + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+
+    std::size_t sent = 0;
+    while(sent < response.size()) {
+        const int written = (int)send(connection, response.data() + sent, (int)(response.size() - sent), sendFlags);
+        if(written <= 0)
+            break;
+        sent += written;
+    }
+    closeSocket(connection);
+}
+
+std::string MetricsExporter::renderText(const metricsSnapshot& snapshot) {
+    // Histograms are exported with the bucket ending each power of two, rather than every bucket
+    const int exportedBucketStride = MetricsRegistry::SUB_BUCKET_COUNT;
+
+    std::string text;
+    for(const exportedCounter& exported : EXPORTED_COUNTERS) {
+        if(exported.help) {
+            text += "# HELP " + std::string(exported.family) + " " + exported.help + "\n";
+            text += "# TYPE " + std::string(exported.family) + " counter\n";
+        }
+        text += exported.family + formatLabels(exported.labels, "") + " " + std::to_string(snapshot.counters[exported.counter]) + "\n";
+    }
+
+    text += "# HELP cryptocensus_curl_errors_total Transfers which failed, by curl error code.\n";
+    text += "# TYPE cryptocensus_curl_errors_total counter\n";
+    for(std::size_t code = 0; code < snapshot.curlErrors.size(); code++) {
+        if(snapshot.curlErrors[code] > 0)
+            text += "cryptocensus_curl_errors_total{code=\"" + std::to_string(code) + "\"} " + std::to_string(snapshot.curlErrors[code]) + "\n";
+    }
+
+    for(const exportedHistogram& exported : EXPORTED_HISTOGRAMS) {
+        const std::string family = exported.family;
+        if(exported.help) {
+            text += "# HELP " + family + " " + exported.help + "\n";
+            text += "# TYPE " + family + " histogram\n";
+        }
+        const std::size_t first = (std::size_t)exported.histogram * MetricsRegistry::HISTOGRAM_BUCKET_COUNT;
+        std::uint64_t cumulative = 0;
+        for(int i = 0; i < MetricsRegistry::HISTOGRAM_BUCKET_COUNT; i++) {
+            cumulative += snapshot.histogramBuckets[first + i];
+            if(i % exportedBucketStride != exportedBucketStride - 1)
+                continue;
+            const std::uint64_t bound = MetricsRegistry::bucketUpperBound(i);
+            const std::string le = exported.microseconds ? formatMicroseconds(bound) : std::to_string(bound);
+            text += family + "_bucket" + formatLabels(exported.labels, "le=\"" + le + "\"") + " " + std::to_string(cumulative) + "\n";
+        }
+        const std::uint64_t sum = snapshot.histogramSums[exported.histogram];
+        text += family + "_bucket" + formatLabels(exported.labels, "le=\"+Inf\"") + " " + std::to_string(cumulative) + "\n";
+        text += family + "_sum" + formatLabels(exported.labels, "") + " " + (exported.microseconds ? formatMicroseconds(sum) : std::to_string(sum)) + "\n";
+        text += family + "_count" + formatLabels(exported.labels, "") + " " + std::to_string(cumulative) + "\n";
+    }
+    return text;
+}
\ No newline at end of file
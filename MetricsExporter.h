@@ -0,0 +1,110 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include "Config.h"
+#include "MetricsRegistry.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * MetricsExporter publishes the metrics registry in the Prometheus text exposition format.
+ * 
+ * The metrics can be written to a file on an interval, for node_exporter's textfile collector. The file is written
+ * to a temporary file, then renamed into place, so the collector never reads a partial file. The metrics can also be
+ * served over HTTP by a listener bound to the loopback interface.
+ * 
+ * Each export sums the registry's shards once and formats the totals, and runs on the exporter's own threads, so
+ * the pipeline's stages never wait on an export. Histograms are exported with one bucket per power of two.
+ */
+class MetricsExporter {
+    public:
+
+        /**
+         * Constructor. Opens the HTTP listener, and starts the exporter's threads.
+         * 
+         * @param config a pointer to the object holding the program's configurations.
+         *      MetricsExporter Configs:
+         *          Metrics_File the file the metrics are written to.
+         *          Metrics_FileIntervalSeconds the seconds between writes of the file. 0 disables the file.
+         *          Metrics_HttpPort the loopback port the metrics are served on at /metrics. 0 disables the listener.
+         * @param metricsRegistry a pointer to the registry to export.
+         */
+        MetricsExporter(Config* config, MetricsRegistry* metricsRegistry);
+
+        // Stops the exporter, if it has not been stopped.
+        ~MetricsExporter();
+
+        MetricsExporter(const MetricsExporter&) = delete;
+        MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+        /**
+         * Stops the exporter's threads and closes the HTTP listener. The file is written one last time, so it holds
+         * the final totals.
+         */
+        void close();
+
+        /**
+         * Formats a snapshot in the Prometheus text exposition format.
+         * 
+         * @param snapshot the snapshot to format.
+         * @return the formatted metrics.
+         */
+        static std::string renderText(const metricsSnapshot& snapshot);
+
+    private:
+        MetricsRegistry* metrics;
+
+        std::string metricsFile;
+        std::chrono::seconds fileInterval;
+
+        // The listening socket, or -1 if there is none. Stored as an integer so this header needs no socket headers
+        std::intptr_t listenSocket;
+
+        bool closing;
+        std::mutex closingMutex;
+        std::condition_variable wake;
+        // Checked by the HTTP thread between waits for a connection
+        std::atomic<bool> stopListening;
+
+        std::thread fileThread;
+        std::thread httpThread;
+
+        /**
+         * Writes the metrics file every file interval until the exporter is closed.
+         */
+        void fileLoop();
+
+        /**
+         * Serves connections to the HTTP listener until the exporter is closed.
+         */
+        void httpLoop();
+
+        /**
+         * Collects the registry and writes it to the metrics file.
+         * 
+         * @return true if the file was written, false otherwise.
+         */
+        bool writeFile();
+
+        /**
+         * Opens a listening socket on a loopback port.
+         * 
+         * @param port the port to listen on.
+         * @return true if the socket is listening, false otherwise.
+         */
+        bool openListener(int port);
+
+        /**
+         * Reads a request from a connection and answers it, then closes the connection.
+         * 
+         * @param connection the connection's socket.
+         */
+        void serveConnection(std::intptr_t connection);
+};
+
+#endif
\ No newline at end of file
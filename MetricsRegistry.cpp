@@ -0,0 +1,147 @@
+#include "MetricsRegistry.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * Gets the number of bits needed to represent a value.
+ * 
+ * @param value the value. Must not be 0.
+ * @return the index of the highest set bit, plus one.
+ */
+static int bitWidth(std::uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long highestBit;
+    _BitScanReverse64(&highestBit, value);
+    return (int)highestBit + 1;
+#else
+    return 64 - __builtin_clzll(value);
+#endif
+}
+
+std::atomic<std::uint64_t> MetricsRegistry::nextGeneration(1);
+
+MetricsRegistry::MetricsRegistry() : generation(nextGeneration.fetch_add(1)) {}
+
+MetricsRegistry::~MetricsRegistry() {
+    for(shard* s : shards)
+        delete s;
+}
+
+void MetricsRegistry::add(std::atomic<std::uint64_t>* value, std::uint64_t amount) {
+    // The owning thread is the only writer, so the update needs no atomic read-modify-write
+    value->store(value->load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+MetricsRegistry::shard* MetricsRegistry::localShard() {
+    // The last registry the thread updated is checked first, as a thread almost always updates a single registry
+    thread_local std::uint64_t ownGeneration = 0;
+    thread_local shard* ownShard = nullptr;
+    thread_local std::unordered_map<std::uint64_t, shard*> ownShards;
+    if(ownGeneration != generation) {
+        shard*& cached = ownShards[generation];
+        if(!cached) {
+            // Value-initializing the shard zeroes every counter
+            cached = new shard();
+            std::lock_guard<std::mutex> lock(shardsMutex);
+            shards.push_back(cached);
+        }
+        ownGeneration = generation;
+        ownShard = cached;
+    }
+    return ownShard;
+}
+
+void MetricsRegistry::increment(counter metric, std::uint64_t amount) {
+    add(&localShard()->counters[metric], amount);
+}
+
+void MetricsRegistry::record(histogram metric, std::uint64_t value) {
+    shard* s = localShard();
+    add(&s->histogramBuckets[metric * HISTOGRAM_BUCKET_COUNT + bucketIndex(value)], 1);
+    add(&s->histogramSums[metric], value);
+}
+
+void MetricsRegistry::countCurlError(int code) {
+    if(code < 0 || code >= CURL_CODE_COUNT)
+        code = CURL_CODE_COUNT - 1;
+    add(&localShard()->curlErrors[code], 1);
+}
+
+void MetricsRegistry::collect(metricsSnapshot* snapshot) {
+    snapshot->counters.assign(COUNTER_COUNT, 0);
+    snapshot->histogramBuckets.assign(HISTOGRAM_COUNT * HISTOGRAM_BUCKET_COUNT, 0);
+    snapshot->histogramSums.assign(HISTOGRAM_COUNT, 0);
+    snapshot->curlErrors.assign(CURL_CODE_COUNT, 0);
+
+    std::lock_guard<std::mutex> lock(shardsMutex);
+    for(shard* s : shards) {
+        for(int i = 0; i < COUNTER_COUNT; i++)
+            snapshot->counters[i] += s->counters[i].load(std::memory_order_relaxed);
+        for(int i = 0; i < HISTOGRAM_COUNT * HISTOGRAM_BUCKET_COUNT; i++)
+            snapshot->histogramBuckets[i] += s->histogramBuckets[i].load(std::memory_order_relaxed);
+        for(int i = 0; i < HISTOGRAM_COUNT; i++)
+            snapshot->histogramSums[i] += s->histogramSums[i].load(std::memory_order_relaxed);
+        for(int i = 0; i < CURL_CODE_COUNT; i++)
+            snapshot->curlErrors[i] += s->curlErrors[i].load(std::memory_order_relaxed);
+    }
+}
+
+int MetricsRegistry::bucketIndex(std::uint64_t value) {
+    if(value < (std::uint64_t)SUB_BUCKET_COUNT)
+        return (int)value;
+    // Shifting the value down to SUB_BUCKET_BITS + 1 bits leaves its leading 1 and the index within its power of two
+    const int shift = bitWidth(value) - SUB_BUCKET_BITS - 1;
+    const int bucket = SUB_BUCKET_COUNT + shift * SUB_BUCKET_COUNT + (int)((value >> shift) - SUB_BUCKET_COUNT);
+    return bucket < HISTOGRAM_BUCKET_COUNT ? bucket : HISTOGRAM_BUCKET_COUNT - 1;
+}
+
+std::uint64_t MetricsRegistry::bucketUpperBound(int bucket) {
+    if(bucket < SUB_BUCKET_COUNT)
+        return (std::uint64_t)bucket;
+    const int shift = (bucket - SUB_BUCKET_COUNT) / SUB_BUCKET_COUNT;
+    const std::uint64_t subBucket = (std::uint64_t)((bucket - SUB_BUCKET_COUNT) % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT);
+    return ((subBucket + 1) << shift) - 1;
+}
+
+std::uint64_t MetricsRegistry::quantile(const metricsSnapshot& snapshot, histogram metric, double quantile) {
+    const std::size_t first = (std::size_t)metric * HISTOGRAM_BUCKET_COUNT;
+    std::uint64_t total = 0;
+    for(int i = 0; i < HISTOGRAM_BUCKET_COUNT; i++)
+        total += snapshot.histogramBuckets[first + i];
+    if(total == 0)
+        return 0;
+
+    // The rank of the value at the quantile, counting from 1
+    std::uint64_t rank = (std::uint64_t)(quantile * total);
+    if(rank < 1)
+        rank = 1;
+    std::uint64_t seen = 0;
+    for(int i = 0; i < HISTOGRAM_BUCKET_COUNT; i++) {
+        seen += snapshot.histogramBuckets[first + i];
+        if(seen >= rank)
+            return bucketUpperBound(i);
+    }
+    return bucketUpperBound(HISTOGRAM_BUCKET_COUNT - 1);
+}
+
+void MetricsRegistry::difference(const metricsSnapshot& later, const metricsSnapshot& earlier, metricsSnapshot* window) {
+    *window = later;
+    // An empty snapshot counts as all zeroes
+    if(earlier.counters.empty())
+        return;
+    for(std::size_t i = 0; i < window->counters.size(); i++)
+        window->counters[i] -= earlier.counters[i];
+    for(std::size_t i = 0; i < window->histogramBuckets.size(); i++)
+        window->histogramBuckets[i] -= earlier.histogramBuckets[i];
+    for(std::size_t i = 0; i < window->histogramSums.size(); i++)
+        window->histogramSums[i] -= earlier.histogramSums[i];
+    for(std::size_t i = 0; i < window->curlErrors.size(); i++)
+        window->curlErrors[i] -= earlier.curlErrors[i];
+}
\ No newline at end of file
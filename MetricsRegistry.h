@@ -0,0 +1,182 @@
+#ifndef METRICSREGISTRY_H
+#define METRICSREGISTRY_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A structure holding the totals of every metric at one point in time.
+ * 
+ * Histogram buckets are stored one histogram after another, HISTOGRAM_BUCKET_COUNT buckets each.
+ */
+struct metricsSnapshot {
+    std::vector<std::uint64_t> counters;
+    std::vector<std::uint64_t> histogramBuckets;
+    std::vector<std::uint64_t> histogramSums;
+    std::vector<std::uint64_t> curlErrors;
+};
+
+/**
+ * MetricsRegistry collects the counters and histograms the pipeline's stages update as they run.
+ * 
+ * Every thread which updates a metric is given its own shard of the registry the first time it does so. A shard is
+ * only ever written by its thread, so an update is a relaxed load and store with no lock and no contended cache
+ * line. Readers sum the shards with relaxed loads, so a snapshot may be a few updates behind, but never blocks a
+ * stage.
+ * 
+ * Histograms are log-linear, in the style of HDR histograms: values below 16 have their own buckets, and every
+ * power of two above that is split into 16 buckets, so a bucket's bounds are within 6.25% of each other. Values
+ * are tracked up to 2^40, and larger values fall into the last bucket.
+ * 
+ * This class is thread-safe.
+ */
+class MetricsRegistry {
+    public:
+
+        // The counters the stages update
+        enum counter {
+            crawlerPagesCounter,
+            crawlerFailuresCounter,
+            searcherPagesCounter,
+            searcherFailuresCounter,
+            bytesFetchedCounter,
+            domainsExtractedCounter,
+            domainsVerifiedCounter,
+            cachedVerdictsCounter,
+            COUNTER_COUNT
+        };
+
+        // The histograms the stages update. Times are in microseconds, and sizes in bytes
+        enum histogram {
+            crawlerFetchLatencyHistogram,
+            searcherFetchLatencyHistogram,
+            pageBytesHistogram,
+            matchTimeHistogram,
+            crawlerQueueWaitHistogram,
+            searcherQueueWaitHistogram,
+            HISTOGRAM_COUNT
+        };
+
+        static const int SUB_BUCKET_BITS = 4;
+        static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+        static const int TRACKED_VALUE_BITS = 40;
+        static const int HISTOGRAM_BUCKET_COUNT = SUB_BUCKET_COUNT + (TRACKED_VALUE_BITS - SUB_BUCKET_BITS) * SUB_BUCKET_COUNT;
+        // Curl error codes at or above this are counted together in the last slot
+        static const int CURL_CODE_COUNT = 128;
+
+        // Constructor
+        MetricsRegistry();
+
+        // Frees every thread's shard. No thread may update the registry once it is destroyed.
+        ~MetricsRegistry();
+
+        MetricsRegistry(const MetricsRegistry&) = delete;
+        MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+        /**
+         * Adds to a counter.
+         * 
+         * @param metric the counter to add to.
+         * @param amount the amount to add.
+         */
+        void increment(counter metric, std::uint64_t amount = 1);
+
+        /**
+         * Records a value in a histogram.
+         * 
+         * @param metric the histogram to record the value in.
+         * @param value the value to record.
+         */
+        void record(histogram metric, std::uint64_t value);
+
+        /**
+         * Counts a transfer which failed with a curl error code.
+         * 
+         * @param code the CURLcode the transfer failed with.
+         */
+        void countCurlError(int code);
+
+        /**
+         * Sums every thread's shard.
+         * 
+         * @param[out] snapshot the snapshot the totals are written to.
+         */
+        void collect(metricsSnapshot* snapshot);
+
+        /**
+         * Gets the bucket a value falls into.
+         * 
+         * @param value the value.
+         * @return the index of the bucket within its histogram.
+         */
+        static int bucketIndex(std::uint64_t value);
+
+        /**
+         * Gets the largest value which falls into a bucket.
+         * 
+         * @param bucket the index of the bucket within its histogram.
+         * @return the bucket's inclusive upper bound.
+         */
+        static std::uint64_t bucketUpperBound(int bucket);
+
+        /**
+         * Estimates a quantile of a histogram in a snapshot.
+         * 
+         * @param snapshot the snapshot holding the histogram.
+         * @param metric the histogram.
+         * @param quantile the quantile, between 0 and 1.
+         * @return the upper bound of the bucket holding the quantile, or 0 if the histogram is empty.
+         */
+        static std::uint64_t quantile(const metricsSnapshot& snapshot, histogram metric, double quantile);
+
+        /**
+         * Gets the change in every metric between two snapshots.
+         * 
+         * @param[in] later the later snapshot.
+         * @param[in] earlier the earlier snapshot.
+         * @param[out] window the snapshot the differences are written to.
+         */
+        static void difference(const metricsSnapshot& later, const metricsSnapshot& earlier, metricsSnapshot* window);
+
+    private:
+        // One thread's metrics. Shards are aligned to cache lines, so threads never write to each other's lines
+        struct alignas(64) shard {
+            std::array<std::atomic<std::uint64_t>, COUNTER_COUNT> counters;
+            std::array<std::atomic<std::uint64_t>, HISTOGRAM_COUNT * HISTOGRAM_BUCKET_COUNT> histogramBuckets;
+            std::array<std::atomic<std::uint64_t>, HISTOGRAM_COUNT> histogramSums;
+            std::array<std::atomic<std::uint64_t>, CURL_CODE_COUNT> curlErrors;
+        };
+
+        std::vector<shard*> shards;
+        // Held while a shard is added, and while the shards are summed
+        std::mutex shardsMutex;
+
+        /**
+         * Identifies the registry in each thread's shard cache. Unlike the registry's address, it is never reused by a
+         * later registry, so a thread can't mistake a destroyed registry's shard for its own.
+         */
+        const std::uint64_t generation;
+        static std::atomic<std::uint64_t> nextGeneration;
+
+        /**
+         * Gets the calling thread's shard, and creates it if the thread has none. Each thread keeps its shard of every
+         * registry it has updated, so a thread moving between registries gets the same shard back.
+         * 
+         * @return the calling thread's shard.
+         */
+        shard* localShard();
+
+        /**
+         * Adds to a value only the calling thread writes.
+         * 
+         * @param value the value to add to.
+         * @param amount the amount to add.
+         */
+        static void add(std::atomic<std::uint64_t>* value, std::uint64_t amount);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "OutputFinalizer.h"
+#include "BlocklistExporter.h"
+#include "Config.h"
+#include "PublicSuffixList.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#ifdef CRYPTOCENSUS_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+OutputFinalizer::OutputFinalizer(Config* config) {
+    const std::string defaultOutputFile = "output.txt";
+    const std::string defaultSortedFile = "output_sorted.txt";
+    const std::string defaultDeltaFile = "output_delta.txt";
+    const int defaultCompress = 0;
+    const int defaultCompressionLevel = 19;
+    const std::string defaultPublicSuffixList = "public_suffix_list.dat";
+    const std::string defaultIndexFile = "blocklist.idx";
+    const std::string defaultBloomFile = "blocklist.bloom";
+    const int defaultFalsePositivesPerMillion = 1000;
+    const double partsPerMillion = 1000000.0;
+
+    outputFile = config->getConfig("Output_File", defaultOutputFile);
+    sortedFile = config->getConfig("Finalizer_SortedFile", defaultSortedFile);
+    deltaFile = config->getConfig("Finalizer_DeltaFile", defaultDeltaFile);
+    indexFile = config->getConfig("Blocklist_IndexFile", defaultIndexFile);
+    bloomFile = config->getConfig("Blocklist_BloomFile", defaultBloomFile);
+    bloomFalsePositiveRate = config->getIntConfig("Blocklist_FalsePositivesPerMillion", defaultFalsePositivesPerMillion, 1, 999999) / partsPerMillion;
+    compress = config->getIntConfig("Finalizer_Compress", defaultCompress, 0, 1) == 1;
+    compressionLevel = config->getIntConfig("Finalizer_CompressionLevel", defaultCompressionLevel, 1, 22);
+    suffixList = PublicSuffixList(config->getConfig("Crawler_PublicSuffixList", defaultPublicSuffixList));
+}
+
+bool OutputFinalizer::finalize() {
+    std::vector<std::string> domains;
+    if(!readDomains(outputFile, &domains)) {
+        std::cout << "ERROR: Could Not Read Output File: " << outputFile << "\n";
+        return false;
+    }
+    sortDomains(&domains);
+
+    // The previous run's sorted list is read before it is replaced. If there is none, every domain is new
+    std::vector<std::string> previousDomains;
+    readDomains(sortedFile, &previousDomains);
+
+    std::string sorted;
+    for(const std::string& domain : domains) {
+        sorted += domain;
+        sorted += '\n';
+    }
+
+    const std::unordered_set<std::string> current(domains.begin(), domains.end());
+    const std::unordered_set<std::string> previous(previousDomains.begin(), previousDomains.end());
+    std::string delta;
+    for(const std::string& domain : domains) {
+        if(previous.find(domain) == previous.end())
+            delta += "+" + domain + "\n";
+    }
+    for(const std::string& domain : previousDomains) {
+        if(current.find(domain) == current.end())
+            delta += "-" + domain + "\n";
+    }
+
+    bool written = writeFile(deltaFile, delta) && writeFile(sortedFile, sorted);
+    written = writeFile(indexFile, BlocklistExporter::encodeIndex(domains)) && written;
+    written = writeFile(bloomFile, BlocklistExporter::encodeBloomFilter(domains, bloomFalsePositiveRate)) && written;
+    if(compress)
+        written = writeCompressedFile(sortedFile + ".zst", sorted) && written;
+    return written;
+}
+
+bool OutputFinalizer::readDomains(const std::string& path, std::vector<std::string>* domains) {
+    std::ifstream file(path);
+    if(!file.is_open())
+        return false;
+    std::string line;
+    while(std::getline(file, line)) {
+        // Lines written on Windows keep their carriage return
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        line.erase(0, line.find_first_not_of(" \t"));
+        if(line.empty())
+            continue;
+        std::transform(line.begin(), line.end(), line.begin(), [](char c) { return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c; });
+        domains->push_back(line);
+    }
+    return true;
+}
+
+void OutputFinalizer::sortDomains(std::vector<std::string>* domains) {
+    // Each domain is sorted by its registrable domain first, so a site's subdomains end up next to it
+    std::vector<std::pair<std::string_view, std::string*>> keys;
+    keys.reserve(domains->size());
+    for(std::string& domain : *domains)
+        keys.emplace_back(suffixList.getRegistrableDomain(domain), &domain);
+    std::sort(keys.begin(), keys.end(), [](const std::pair<std::string_view, std::string*>& a, const std::pair<std::string_view, std::string*>& b) {
+        if(a.first != b.first)
+            return a.first < b.first;
+        return *a.second < *b.second;
+    });
+
+    std::vector<std::string> sorted;
+    sorted.reserve(keys.size());
+    for(const std::pair<std::string_view, std::string*>& key : keys) {
+        if(sorted.empty() || sorted.back() != *key.second)
+            sorted.push_back(std::move(*key.second));
+    }
+    domains->swap(sorted);
+}
+
+bool OutputFinalizer::writeFile(const std::string& path, const std::string& contents) {
+    const std::string temporaryPath = path + ".tmp";
+    std::FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+    if(!file) {
+        std::cout << "ERROR: Could Not Write Finalized Output: " << temporaryPath << "\n";
+        return false;
+    }
+    // The data must reach the disk before the rename does, or a crash could leave a renamed but empty file
+    bool written = contents.empty() || std::fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+    written = std::fflush(file) == 0 && written;
+#ifdef _WIN32
+    written = _commit(_fileno(file)) == 0 && written;
+#else
+    written = fsync(fileno(file)) == 0 && written;
+#endif
+    written = std::fclose(file) == 0 && written;
+    if(!written) {
+        std::cout << "ERROR: Could Not Write Finalized Output: " << temporaryPath << "\n";
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if(error) {
+        std::cout << "ERROR: Could Not Replace Finalized Output: " << path << "\n";
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
+
+bool OutputFinalizer::writeCompressedFile([[maybe_unused]] const std::string& path, [[maybe_unused]] const std::string& contents) {
+#ifdef CRYPTOCENSUS_WITH_ZSTD
+    std::string compressed(ZSTD_compressBound(contents.size()), '\0');
+    const std::size_t compressedSize = ZSTD_compress(&compressed[0], compressed.size(), contents.data(), contents.size(), compressionLevel);
+    if(ZSTD_isError(compressedSize)) {
+        std::cout << "ERROR: Could Not Compress Finalized Output: " << ZSTD_getErrorName(compressedSize) << "\n";
+        return false;
+    }
+    compressed.resize(compressedSize);
+    return writeFile(path, compressed);
+#else
+    std::cout << "ERROR: Finalizer_Compress Is Set, But Crypto Census Was Built Without zstd Support\n";
+    return false;
+#endif
+}
\ No newline at end of file
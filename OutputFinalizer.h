@@ -0,0 +1,97 @@
+#ifndef OUTPUTFINALIZER_H
+#define OUTPUTFINALIZER_H
+
+#include "Config.h"
+#include "PublicSuffixList.h"
+#include <string>
+#include <vector>
+
+/**
+ * OutputFinalizer turns the append-only output file into a sorted list, and a delta against the previous run's list.
+ * 
+ * Domains are lowercased and deduplicated, then grouped by registrable domain: groups are sorted by registrable
+ * domain, and the domains of a group are sorted after it. The delta file lists the domains added since the previous
+ * run's sorted list as "+domain", and the domains removed as "-domain". Every file is written to a temporary file,
+ * then renamed into place.
+ * 
+ * The sorted list is also exported as a binary blocklist index and Bloom filter, for lookup services which map
+ * them with the blocklist reader library.
+ * 
+ * If built with CRYPTOCENSUS_WITH_ZSTD defined, and linked against libzstd, the sorted list can also be written
+ * compressed with zstd.
+ */
+class OutputFinalizer {
+    public:
+
+        /**
+         * Constructor.
+         * 
+         * @param config a pointer to the object holding the program's configurations.
+         *      OutputFinalizer Configs:
+         *          Output_File the output file to finalize.
+         *          Finalizer_SortedFile the file the sorted list is written to. The previous run's list is read from it first.
+         *          Finalizer_DeltaFile the file the added and removed domains are written to.
+         *          Finalizer_Compress 1 to also write the sorted list compressed with zstd, 0 otherwise.
+         *          Finalizer_CompressionLevel the zstd compression level.
+         *          Blocklist_IndexFile the file the binary blocklist index is written to.
+         *          Blocklist_BloomFile the file the blocklist Bloom filter is written to.
+         *          Blocklist_FalsePositivesPerMillion the Bloom filter's false positive rate, in parts per million.
+         *          Crawler_PublicSuffixList the Public Suffix List file registrable domains are found with.
+         */
+        OutputFinalizer(Config* config);
+
+        /**
+         * Writes the sorted list, the delta file, the binary blocklist files, and the compressed list if enabled.
+         * 
+         * @return true if every file was written, false otherwise.
+         */
+        bool finalize();
+
+    private:
+        std::string outputFile;
+        std::string sortedFile;
+        std::string deltaFile;
+        std::string indexFile;
+        std::string bloomFile;
+        double bloomFalsePositiveRate;
+        bool compress;
+        int compressionLevel;
+
+        PublicSuffixList suffixList;
+
+        /**
+         * Reads the domains of a file, one per line. Blank lines are skipped, and domains are lowercased.
+         * 
+         * @param[in] path the file to read.
+         * @param[out] domains a pointer to the vector the domains are appended to.
+         * @return true if the file was read, false if it could not be opened.
+         */
+        static bool readDomains(const std::string& path, std::vector<std::string>* domains);
+
+        /**
+         * Sorts domains by registrable domain, then by domain, and removes duplicates.
+         * 
+         * @param domains a pointer to the domains to sort.
+         */
+        void sortDomains(std::vector<std::string>* domains);
+
+        /**
+         * Writes a file through a temporary file, so a crash never leaves it half written.
+         * 
+         * @param path the file to write.
+         * @param contents the contents of the file.
+         * @return true if the file was written, false otherwise.
+         */
+        static bool writeFile(const std::string& path, const std::string& contents);
+
+        /**
+         * Writes a file compressed with zstd.
+         * 
+         * @param path the file to write.
+         * @param contents the uncompressed contents of the file.
+         * @return true if the file was written, false if it could not be written or zstd support is not built in.
+         */
+        bool writeCompressedFile(const std::string& path, const std::string& contents);
+};
+
+#endif
\ No newline at end of file
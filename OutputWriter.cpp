@@ -0,0 +1,100 @@
+#include "OutputWriter.h"
+#include "Config.h"
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+OutputWriter::OutputWriter(std::string outputFile, bool append, Config* config) {
+    const int defaultFlushBytes = 65536;
+    const int defaultFlushIntervalMilliseconds = 1000;
+
+    path = outputFile;
+    flushBytes = config->getIntConfig("Output_FlushBytes", defaultFlushBytes, 1, INT_MAX);
+    flushInterval = std::chrono::milliseconds(config->getIntConfig("Output_FlushIntervalMilliseconds", defaultFlushIntervalMilliseconds, 1, INT_MAX));
+    closing = false;
+
+    file = std::fopen(path.c_str(), append ? "ab" : "wb");
+    if(!file)
+        std::cout << "ERROR: Could Not Open Output File: " << path << "\n";
+    writerThread = std::thread(&OutputWriter::writeLoop, this);
+}
+
+OutputWriter::~OutputWriter() {
+    close();
+}
+
+void OutputWriter::write(std::string_view line) {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pending.append(line);
+    pending += '\n';
+    if(pending.size() >= flushBytes)
+        wake.notify_one();
+}
+
+bool OutputWriter::sync() {
+    return writePending(true);
+}
+
+void OutputWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        closing = true;
+    }
+    wake.notify_one();
+    if(writerThread.joinable())
+        writerThread.join();
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if(file) {
+        std::fclose(file);
+        file = NULL;
+    }
+}
+
+void OutputWriter::writeLoop() {
+    std::unique_lock<std::mutex> lock(pendingMutex);
+    while(!closing) {
+        wake.wait_for(lock, flushInterval, [this]() { return closing || pending.size() >= flushBytes; });
+        // The batch's lock is released while the file is written, so lines can still be queued
+        lock.unlock();
+        writePending(false);
+        lock.lock();
+    }
+    lock.unlock();
+    writePending(false);
+}
+
+bool OutputWriter::writePending(bool durable) {
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    std::string batch;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        batch.swap(pending);
+    }
+    if(!file)
+        return false;
+
+    bool written = batch.empty() || std::fwrite(batch.data(), 1, batch.size(), file) == batch.size();
+    written = std::fflush(file) == 0 && written;
+    if(durable) {
+#ifdef _WIN32
+        written = _commit(_fileno(file)) == 0 && written;
+#else
+        written = fsync(fileno(file)) == 0 && written;
+#endif
+    }
+    if(!written)
+        std::cout << "ERROR: Could Not Write Output File: " << path << "\n";
+    return written;
+}
\ No newline at end of file
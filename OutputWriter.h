@@ -0,0 +1,95 @@
+#ifndef OUTPUTWRITER_H
+#define OUTPUTWRITER_H
+
+#include "Config.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/**
+ * OutputWriter is an asynchronous line sink for an output file.
+ * 
+ * Lines are appended to an in-memory batch, and a dedicated thread writes the batch to the file once it reaches a
+ * size threshold, or once a time threshold has passed since the last write. Writers only take the batch's lock, so
+ * they never wait on the disk. sync forces the batch to disk and flushes it through to the storage device, and is
+ * meant for checkpoints.
+ * 
+ * This class is thread-safe.
+ */
+class OutputWriter {
+    public:
+
+        /**
+         * Constructor. Opens the file and starts the writer thread.
+         * 
+         * @param outputFile the file lines are written to.
+         * @param append whether lines are appended to the file, rather than replacing its contents.
+         * @param config a pointer to the object holding the program's configurations.
+         *      OutputWriter Configs:
+         *          Output_FlushBytes the size a batch reaches before it is written.
+         *          Output_FlushIntervalMilliseconds the longest a line waits before it is written.
+         */
+        OutputWriter(std::string outputFile, bool append, Config* config);
+
+        // Writes any remaining lines, then closes the file.
+        ~OutputWriter();
+
+        OutputWriter(const OutputWriter&) = delete;
+        OutputWriter& operator=(const OutputWriter&) = delete;
+
+        /**
+         * Queues a line to be written. A newline is added to the line.
+         * 
+         * @param line the line to write.
+         */
+        void write(std::string_view line);
+
+        /**
+         * Writes every queued line, then flushes the file to disk. Blocks until the file is flushed.
+         * 
+         * @return true if the lines reached the disk, false otherwise.
+         */
+        bool sync();
+
+        /**
+         * Stops the writer thread, writes any remaining lines, then closes the file.
+         */
+        void close();
+
+    private:
+        std::string path;
+        std::FILE* file;
+
+        // Lines waiting for the writer thread
+        std::string pending;
+        std::mutex pendingMutex;
+        std::condition_variable wake;
+        bool closing;
+
+        // Held while the file is written, so sync and the writer thread don't interleave
+        std::mutex fileMutex;
+
+        std::size_t flushBytes;
+        std::chrono::milliseconds flushInterval;
+
+        std::thread writerThread;
+
+        /**
+         * Writes batches until the writer is closed.
+         */
+        void writeLoop();
+
+        /**
+         * Takes the batch of queued lines and writes it to the file.
+         * 
+         * @param durable whether the file is flushed through to the storage device after the write.
+         * @return true if the batch was written, false otherwise.
+         */
+        bool writePending(bool durable);
+};
+
+#endif
\ No newline at end of file
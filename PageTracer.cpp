@@ -0,0 +1,123 @@
+#include "PageTracer.h"
+#include "Config.h"
+#include "CurlInteractionStructs.h"
+#include "OutputWriter.h"
+#include "ResultRecord.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+PageTracer::PageTracer(Config* config) {
+    const std::string defaultTraceFile = "trace.json";
+    const int defaultSamplesPerMillion = 0;
+    const int samplesPerMillionLimit = 1000000;
+
+    samplesPerMillion = config->getIntConfig("Trace_SamplesPerMillion", defaultSamplesPerMillion, 0, samplesPerMillionLimit);
+    sampleCounter = 0;
+    nextTrackId = 1;
+    traceStart = std::chrono::steady_clock::now();
+
+    if(samplesPerMillion > 0) {
+        output = new OutputWriter(config->getConfig("Trace_File", defaultTraceFile), false, config);
+        output->write("[");
+    }
+}
+
+PageTracer::~PageTracer() {
+    close();
+}
+
+void PageTracer::close() {
+    if(!output)
+        return;
+    // The last event carries no trailing comma, so the array can be terminated
+    output->write("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CryptoCensus\"}}");
+    output->write("]");
+    output->close();
+    delete output;
+    output = nullptr;
+}
+
+bool PageTracer::sample() {
+    const std::uint64_t samplingPeriod = 1000000;
+
+    if(samplesPerMillion == 0)
+        return false;
+    // A page is sampled each time the counter crosses a multiple of the period
+    const std::uint64_t before = sampleCounter.fetch_add(samplesPerMillion, std::memory_order_relaxed);
+    return before / samplingPeriod != (before + samplesPerMillion) / samplingPeriod;
+}
+
+std::int64_t PageTracer::toTraceMicroseconds(std::chrono::steady_clock::time_point time) {
+    return std::max<std::int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(time - traceStart).count());
+}
+
+void PageTracer::appendEvent(std::string* events, const char* name, std::uint64_t trackId, std::int64_t start, std::int64_t duration) {
+    if(duration <= 0)
+        return;
+    *events += "{\"name\":\"";
+    *events += name;
+    *events += "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(trackId) + ",\"ts\":" + std::to_string(start)
+        + ",\"dur\":" + std::to_string(duration) + "},\n";
+}
+
+void PageTracer::record(const char* stage, const siteData& page) {
+    const double microsecondsPerSecond = 1000000;
+
+    if(!output || !page.trace)
+        return;
+    const pageTrace& trace = *page.trace;
+    const std::uint64_t trackId = nextTrackId.fetch_add(1, std::memory_order_relaxed);
+
+    // Curl's timings are cumulative from the start of the transfer, and are clamped so each phase nests in the fetch
+    const std::int64_t fetchStart = toTraceMicroseconds(trace.handleAssignedAt);
+    const std::int64_t total = (std::int64_t)(trace.totalSeconds * microsecondsPerSecond);
+    const std::int64_t nameLookup = std::min(total, (std::int64_t)(trace.nameLookupSeconds * microsecondsPerSecond));
+    const std::int64_t connect = std::min(total, std::max(nameLookup, (std::int64_t)(trace.connectSeconds * microsecondsPerSecond)));
+    const std::int64_t tls = std::min(total, std::max(connect, (std::int64_t)(trace.tlsSeconds * microsecondsPerSecond)));
+    const std::int64_t preTransfer = std::min(total, std::max(tls, (std::int64_t)(trace.preTransferSeconds * microsecondsPerSecond)));
+    const std::int64_t startTransfer = std::min(total, std::max(preTransfer, (std::int64_t)(trace.startTransferSeconds * microsecondsPerSecond)));
+
+    // Curl's clock and the pipeline's clock differ slightly, so the later phases are clamped to follow the fetch
+    const bool analysed = trace.analysisEndedAt.time_since_epoch().count() != 0;
+    const std::int64_t queued = std::max(fetchStart + total, toTraceMicroseconds(page.queuedAt));
+    const std::int64_t dequeued = std::max(queued, toTraceMicroseconds(trace.dequeuedAt));
+    const std::int64_t analysisEnd = std::max(dequeued, toTraceMicroseconds(trace.analysisEndedAt));
+    const std::int64_t pageEnd = analysed ? analysisEnd : dequeued;
+
+    std::string events;
+    events += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(trackId) + ",\"args\":{\"name\":";
+    ResultRecord::appendJsonString(&events, std::string(stage) + " " + page.siteUrl);
+    events += "}},\n";
+
+    std::size_t pageBytes = 0;
+    for(const std::string& chunk : page.siteContents)
+        pageBytes += chunk.size();
+    events += "{\"name\":\"page\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(trackId) + ",\"ts\":" + std::to_string(fetchStart)
+        + ",\"dur\":" + std::to_string(std::max<std::int64_t>(1, pageEnd - fetchStart)) + ",\"args\":{\"url\":";
+    ResultRecord::appendJsonString(&events, page.siteUrl);
+    events += ",\"httpStatus\":" + std::to_string(page.httpStatus) + ",\"pageBytes\":" + std::to_string(pageBytes)
+        + ",\"transferFailed\":" + (page.transferFailed ? "true" : "false") + "}},\n";
+
+    appendEvent(&events, "fetch", trackId, fetchStart, total);
+    appendEvent(&events, "dns", trackId, fetchStart, nameLookup);
+    appendEvent(&events, "connect", trackId, fetchStart + nameLookup, connect - nameLookup);
+    appendEvent(&events, "tls", trackId, fetchStart + connect, tls - connect);
+    appendEvent(&events, "request", trackId, fetchStart + tls, preTransfer - tls);
+    appendEvent(&events, "wait", trackId, fetchStart + preTransfer, startTransfer - preTransfer);
+    appendEvent(&events, "transfer", trackId, fetchStart + startTransfer, total - startTransfer);
+    appendEvent(&events, "queue wait", trackId, queued, dequeued - queued);
+    if(analysed) {
+        appendEvent(&events, "analysis", trackId, dequeued, analysisEnd - dequeued);
+        if(trace.matchEndedAt.time_since_epoch().count() != 0) {
+            const std::int64_t matchStart = std::max(dequeued, toTraceMicroseconds(trace.matchStartedAt));
+            appendEvent(&events, "match terms", trackId, matchStart, std::min(analysisEnd, toTraceMicroseconds(trace.matchEndedAt)) - matchStart);
+        }
+    }
+
+    // The writer adds the newline after the last event
+    events.pop_back();
+    output->write(events);
+}
\ No newline at end of file
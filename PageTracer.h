@@ -0,0 +1,100 @@
+#ifndef PAGETRACER_H
+#define PAGETRACER_H
+
+#include "Config.h"
+#include "CurlInteractionStructs.h"
+#include "OutputWriter.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * PageTracer samples pages as they are fetched, and writes the timeline of each sampled page through the pipeline
+ * in the Chrome trace event format, which Perfetto and chrome://tracing can open.
+ * 
+ * Each sampled page is given its own track, named after its stage and URL. The track holds a span for the page,
+ * with spans for each phase of the transfer (DNS, connect, TLS, request, and transfer), the time the page waited in
+ * its consumer's queue, and its analysis, including term matching.
+ * 
+ * Pages are sampled at a fixed rate per million, by a shared counter rather than at random, so the sampled pages
+ * are spread evenly. Pages which are not sampled carry no trace, and cost a single atomic add. Events are written
+ * through an OutputWriter, so recording a page never waits on the disk.
+ * 
+ * The file is a JSON array of events, which is terminated when the tracer is closed. Trace viewers also accept the
+ * file unterminated, so a trace survives a crash.
+ * 
+ * This class is thread-safe.
+ */
+class PageTracer {
+    public:
+
+        /**
+         * Constructor. Opens the trace file if tracing is enabled.
+         * 
+         * @param config a pointer to the object holding the program's configurations.
+         *      PageTracer Configs:
+         *          Trace_File the file trace events are written to.
+         *          Trace_SamplesPerMillion the number of pages traced per million fetched. 0 disables tracing.
+         */
+        PageTracer(Config* config);
+
+        // Closes the trace file, if it has not been closed.
+        ~PageTracer();
+
+        PageTracer(const PageTracer&) = delete;
+        PageTracer& operator=(const PageTracer&) = delete;
+
+        /**
+         * Decides whether the next page is traced.
+         * 
+         * @return true if the page should carry a trace, false otherwise.
+         */
+        bool sample();
+
+        /**
+         * Writes the trace of a page once its consumer has finished with it. Pages without a trace are ignored.
+         * 
+         * @param stage the name of the stage which consumed the page.
+         * @param page the page.
+         */
+        void record(const char* stage, const siteData& page);
+
+        /**
+         * Terminates and closes the trace file.
+         */
+        void close();
+
+    private:
+        OutputWriter* output = nullptr;
+
+        std::uint64_t samplesPerMillion;
+        std::atomic<std::uint64_t> sampleCounter;
+
+        // Gives each traced page its own track
+        std::atomic<std::uint64_t> nextTrackId;
+
+        // Event times are in microseconds since the tracer was created
+        std::chrono::steady_clock::time_point traceStart;
+
+        /**
+         * Gets the microseconds between the start of the trace and a time.
+         * 
+         * @param time the time.
+         * @return the microseconds since the start of the trace, or 0 if the time is earlier.
+         */
+        std::int64_t toTraceMicroseconds(std::chrono::steady_clock::time_point time);
+
+        /**
+         * Appends a complete event to a batch of events.
+         * 
+         * @param[out] events a pointer to the batch.
+         * @param name the name of the event.
+         * @param trackId the track the event is on.
+         * @param start the start of the event, in trace microseconds.
+         * @param duration the duration of the event, in microseconds.
+         */
+        static void appendEvent(std::string* events, const char* name, std::uint64_t trackId, std::int64_t start, std::int64_t duration);
+};
+
+#endif
\ No newline at end of file
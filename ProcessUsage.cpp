@@ -0,0 +1,62 @@
+#include "ProcessUsage.h"
+#include <cstdint>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+#ifdef _WIN32
+/**
+ * Converts a Windows processor time to seconds.
+ * 
+ * @param time the time, in 100 nanosecond units.
+ * @return the time in seconds.
+ */
+static double toSeconds(const FILETIME& time) {
+    const double fileTimeUnitsPerSecond = 10000000.0;
+    return (((std::uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime) / fileTimeUnitsPerSecond;
+}
+#else
+/**
+ * Converts a POSIX processor time to seconds.
+ * 
+ * @param time the time.
+ * @return the time in seconds.
+ */
+static double toSeconds(const timeval& time) {
+    const double microsecondsPerSecond = 1000000.0;
+    return time.tv_sec + time.tv_usec / microsecondsPerSecond;
+}
+#endif
+
+bool ProcessUsage::read(processUsage* usage) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS memory;
+    FILETIME creationTime;
+    FILETIME exitTime;
+    FILETIME kernelTime;
+    FILETIME userTime;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory))
+        || !GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+        return false;
+    usage->peakResidentBytes = memory.PeakWorkingSetSize;
+    usage->userCpuSeconds = toSeconds(userTime);
+    usage->systemCpuSeconds = toSeconds(kernelTime);
+#else
+    rusage resources;
+    if(getrusage(RUSAGE_SELF, &resources) != 0)
+        return false;
+#ifdef __APPLE__
+    // macOS reports the peak in bytes, where Linux reports it in kilobytes
+    usage->peakResidentBytes = (std::uint64_t)resources.ru_maxrss;
+#else
+    usage->peakResidentBytes = (std::uint64_t)resources.ru_maxrss * 1024;
+#endif
+    usage->userCpuSeconds = toSeconds(resources.ru_utime);
+    usage->systemCpuSeconds = toSeconds(resources.ru_stime);
+#endif
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef PROCESSUSAGE_H
+#define PROCESSUSAGE_H
+
+#include <cstdint>
+
+// A structure representing the resources the process has used since it started
+struct processUsage {
+    std::uint64_t peakResidentBytes = 0;
+    double userCpuSeconds = 0;
+    double systemCpuSeconds = 0;
+};
+
+/**
+ * Reads the resources used by the running process from the operating system.
+ */
+class ProcessUsage {
+    public:
+
+        /**
+         * Reads the peak resident memory and the processor time of the process, across all of its threads.
+         * 
+         * @param[out] usage a pointer to the structure the usage is written to.
+         * @return true if the usage was read, false otherwise.
+         */
+        static bool read(processUsage* usage);
+};
+
+#endif
\ No newline at end of file
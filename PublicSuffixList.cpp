@@ -0,0 +1,248 @@
+#include "PublicSuffixList.h"
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Lowercases an ASCII character.
+ * 
+ * @param c the character to lowercase.
+ * @return the lowercase character.
+ */
+static char toLowerAscii(char c) {
+    if(c >= 'A' && c <= 'Z')
+        return c - 'A' + 'a';
+    return c;
+}
+
+/**
+ * Compares a label to a lowercase label, lowercasing the first label as it is read.
+ * 
+ * @param label the label to compare.
+ * @param lowercase the lowercase label to compare against.
+ * @return a negative number, zero or a positive number if label sorts before, equal to, or after lowercase.
+ */
+static int compareIgnoreCase(std::string_view label, std::string_view lowercase) {
+    const std::size_t length = label.size() < lowercase.size() ? label.size() : lowercase.size();
+    for(std::size_t i = 0; i < length; i++) {
+        const unsigned char a = (unsigned char)toLowerAscii(label[i]);
+        const unsigned char b = (unsigned char)lowercase[i];
+        if(a != b)
+            return a < b ? -1 : 1;
+    }
+    if(label.size() == lowercase.size())
+        return 0;
+    return label.size() < lowercase.size() ? -1 : 1;
+}
+
+/**
+ * Finds where the rightmost labels of a domain start.
+ * 
+ * @param domain the domain, without a trailing dot.
+ * @param labelCount the number of rightmost labels.
+ * @return the index of the first character of the labels, or npos if the domain has fewer labels.
+ */
+static std::size_t findLastLabelsStart(std::string_view domain, std::size_t labelCount) {
+    std::size_t dot = domain.size();
+    for(std::size_t i = 0; i < labelCount; i++) {
+        if(dot == 0)
+            return std::string_view::npos;
+        const std::size_t previousDot = domain.rfind('.', dot - 1);
+        if(previousDot == std::string_view::npos)
+            return i + 1 == labelCount ? 0 : std::string_view::npos;
+        dot = previousDot;
+    }
+    return dot + 1;
+}
+
+PublicSuffixList::PublicSuffixList() {
+    nodes.push_back(suffixNode {0, 0, 0, 0, 0});
+    ruleCount = 0;
+}
+
+PublicSuffixList::PublicSuffixList(std::string fileToRead) {
+    const std::string commentPrefix = "//";
+    const std::string whitespace = " \t\r";
+    const char exceptionPrefix = '!';
+    const std::string wildcardLabel = "*";
+    const std::size_t maxLabelLength = 63;   // https://www.rfc-editor.org/rfc/rfc1035#section-2.3.4
+    const std::size_t maxChildCount = UINT16_MAX;
+
+    // The trie is built with maps first, then flattened once every rule has been read
+    struct buildNode {
+        std::map<std::string, std::size_t> children;
+        std::uint8_t flags = 0;
+    };
+    std::vector<buildNode> buildNodes(1);
+
+    ruleCount = 0;
+
+    std::ifstream listInputer = std::ifstream(fileToRead);
+    if(!listInputer.is_open())
+        std::cout << "ERROR: Public Suffix List Could Not Be Read: " << fileToRead << "\n";
+
+    std::string currentLine;
+    while(std::getline(listInputer, currentLine)) {
+        // Rules end at the first whitespace character
+        std::size_t ruleStart = currentLine.find_first_not_of(whitespace);
+        if(ruleStart == std::string::npos || currentLine.compare(ruleStart, commentPrefix.size(), commentPrefix) == 0)
+            continue;
+        std::size_t ruleEnd = currentLine.find_first_of(whitespace, ruleStart);
+        if(ruleEnd == std::string::npos)
+            ruleEnd = currentLine.size();
+        std::string rule = currentLine.substr(ruleStart, ruleEnd - ruleStart);
+
+        std::uint8_t ruleType = ruleFlag;
+        if(rule[0] == exceptionPrefix) {
+            ruleType = exceptionFlag;
+            rule.erase(0, 1);
+        }
+        for(char& c : rule)
+            c = toLowerAscii(c);
+
+        // Walk the rule's labels from right to left, creating nodes as needed
+        std::size_t node = 0;
+        std::size_t labelEnd = rule.size();
+        bool isValid = !rule.empty();
+        while(isValid) {
+            std::size_t labelStart = rule.rfind('.', labelEnd - 1);
+            labelStart = labelStart == std::string::npos ? 0 : labelStart + 1;
+            std::string label = rule.substr(labelStart, labelEnd - labelStart);
+
+            if(label.empty() || label.size() > maxLabelLength) {
+                isValid = false;
+                break;
+            }
+            // A wildcard may only be the leftmost label, and marks its parent
+            if(label == wildcardLabel) {
+                if(labelStart != 0 || ruleType != ruleFlag)
+                    isValid = false;
+                else
+                    buildNodes[node].flags |= wildcardFlag;
+                break;
+            }
+
+            std::map<std::string, std::size_t>::iterator it = buildNodes[node].children.find(label);
+            if(it == buildNodes[node].children.end()) {
+                buildNodes[node].children.insert(std::make_pair(label, buildNodes.size()));
+                node = buildNodes.size();
+                buildNodes.push_back(buildNode());
+            } else
+                node = it->second;
+
+            if(labelStart == 0) {
+                buildNodes[node].flags |= ruleType;
+                break;
+            }
+            labelEnd = labelStart - 1;
+        }
+
+        if(isValid)
+            ruleCount++;
+        else
+            std::cout << "ERROR: Invalid Public Suffix Rule: " << rule << "\n";
+    }
+
+    // Flatten the trie breadth first, so the children of every node are contiguous
+    std::vector<std::uint32_t> flatIndexes(buildNodes.size());
+    std::queue<std::size_t> nodesToFlatten;
+    nodes.reserve(buildNodes.size());
+    nodes.push_back(suffixNode {0, 0, 0, 0, buildNodes[0].flags});
+    nodesToFlatten.push(0);
+    while(!nodesToFlatten.empty()) {
+        const std::size_t node = nodesToFlatten.front();
+        nodesToFlatten.pop();
+
+        suffixNode* flatNode = &nodes[flatIndexes[node]];
+        if(buildNodes[node].children.size() > maxChildCount) {
+            std::cout << "ERROR: Public Suffix List Node Exceeds Max Children\n";
+            continue;
+        }
+        flatNode->firstChild = (std::uint32_t)nodes.size();
+        flatNode->childCount = (std::uint16_t)buildNodes[node].children.size();
+        for(const std::pair<const std::string, std::size_t>& child : buildNodes[node].children) {
+            flatIndexes[child.second] = (std::uint32_t)nodes.size();
+            nodes.push_back(suffixNode {(std::uint32_t)labels.size(), 0, 0, (std::uint8_t)child.first.size(), buildNodes[child.second].flags});
+            labels += child.first;
+            nodesToFlatten.push(child.second);
+        }
+    }
+    labels.shrink_to_fit();
+}
+
+std::uint32_t PublicSuffixList::findChild(std::uint32_t node, std::string_view label) const {
+    std::uint32_t low = nodes[node].firstChild;
+    std::uint32_t high = low + nodes[node].childCount;
+    while(low < high) {
+        const std::uint32_t middle = low + (high - low) / 2;
+        const int comparison = compareIgnoreCase(label, std::string_view(labels).substr(nodes[middle].labelOffset, nodes[middle].labelLength));
+        if(comparison == 0)
+            return middle;
+        if(comparison < 0)
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return 0;
+}
+
+std::size_t PublicSuffixList::countSuffixLabels(std::string_view domain) const {
+    // With no matching rule, the implicit "*" rule makes the rightmost label the public suffix
+    std::size_t suffixLabels = 1;
+    std::size_t depth = 0;
+    std::uint32_t node = 0;
+    std::size_t labelEnd = domain.size();
+
+    while(labelEnd > 0) {
+        std::size_t labelStart = domain.rfind('.', labelEnd - 1);
+        labelStart = labelStart == std::string_view::npos ? 0 : labelStart + 1;
+        const std::uint32_t child = findChild(node, domain.substr(labelStart, labelEnd - labelStart));
+
+        if(nodes[node].flags & wildcardFlag && depth + 1 > suffixLabels)
+            suffixLabels = depth + 1;
+        if(child != 0) {
+            // Exception rules always prevail, and their public suffix drops the exception's leftmost label
+            if(nodes[child].flags & exceptionFlag)
+                return depth;
+            if(nodes[child].flags & ruleFlag && depth + 1 > suffixLabels)
+                suffixLabels = depth + 1;
+        }
+
+        if(child == 0 || labelStart == 0)
+            break;
+        node = child;
+        depth++;
+        labelEnd = labelStart - 1;
+    }
+    return suffixLabels;
+}
+
+std::string_view PublicSuffixList::getPublicSuffix(std::string_view domain) const {
+    if(!domain.empty() && domain.back() == '.')
+        domain.remove_suffix(1);
+
+    const std::size_t suffixStart = findLastLabelsStart(domain, countSuffixLabels(domain));
+    if(suffixStart == std::string_view::npos)
+        return domain;
+    return domain.substr(suffixStart);
+}
+
+std::string_view PublicSuffixList::getRegistrableDomain(std::string_view domain) const {
+    if(!domain.empty() && domain.back() == '.')
+        domain.remove_suffix(1);
+
+    // The registrable domain is the public suffix plus one label
+    const std::size_t domainStart = findLastLabelsStart(domain, countSuffixLabels(domain) + 1);
+    if(domainStart == std::string_view::npos)
+        return domain;
+    return domain.substr(domainStart);
+}
+
+std::size_t PublicSuffixList::size() const {
+    return ruleCount;
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#ifndef PUBLICSUFFIXLIST_H
+#define PUBLICSUFFIXLIST_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * PublicSuffixList finds the public suffix and registrable domain of a domain using the rules of the Public Suffix List.
+ * 
+ * The rules are compiled into a trie of labels, read from the rightmost label. The trie is stored as a flat array of
+ * nodes whose children are contiguous and sorted, and all labels share one string, so a node costs 16 bytes.
+ * 
+ * See https://publicsuffix.org/list/ for the list format and matching algorithm.
+ */
+class PublicSuffixList {
+    public:
+
+        /**
+         * Default constructor.
+         * 
+         * The list is empty, so every domain falls back to the implicit "*" rule.
+         */
+        PublicSuffixList();
+
+        /**
+         * Constructor.
+         * 
+         * Reads the rules from a Public Suffix List file. Both the ICANN and private sections are used.
+         * 
+         * @param fileToRead the file to read.
+         */
+        PublicSuffixList(std::string fileToRead);
+
+        /**
+         * Gets the public suffix of a domain, e.g. "co.uk" for "pool.example.co.uk".
+         * 
+         * @param domain the domain. Case is ignored, and a trailing dot is ignored.
+         * @return a view into domain holding the public suffix.
+         */
+        std::string_view getPublicSuffix(std::string_view domain) const;
+
+        /**
+         * Gets the registrable domain of a domain, e.g. "example.co.uk" for "pool.example.co.uk".
+         * 
+         * @param domain the domain. Case is ignored, and a trailing dot is ignored.
+         * @return a view into domain holding the registrable domain, or the domain itself if it is a public suffix.
+         */
+        std::string_view getRegistrableDomain(std::string_view domain) const;
+
+        /**
+         * Gets the number of rules read from the list file.
+         * 
+         * @return the number of rules.
+         */
+        std::size_t size() const;
+
+    private:
+        enum nodeFlags : std::uint8_t {
+            ruleFlag = 1,
+            wildcardFlag = 2,
+            exceptionFlag = 4
+        };
+
+        struct suffixNode {
+            std::uint32_t labelOffset;
+            std::uint32_t firstChild;
+            std::uint16_t childCount;
+            std::uint8_t labelLength;
+            std::uint8_t flags;
+        };
+
+        // nodes[0] is the root. The children of a node are sorted by label
+        std::vector<suffixNode> nodes;
+        std::string labels;
+        std::size_t ruleCount;
+
+        /**
+         * Finds the child of a node whose label matches, ignoring case.
+         * 
+         * @param node the index of the parent node.
+         * @param label the label to search for.
+         * @return the index of the child, or 0 if there is none.
+         */
+        std::uint32_t findChild(std::uint32_t node, std::string_view label) const;
+
+        /**
+         * Counts the labels of a domain's public suffix.
+         * 
+         * @param domain the domain, without a trailing dot.
+         * @return the number of rightmost labels that make up the public suffix.
+         */
+        std::size_t countSuffixLabels(std::string_view domain) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "ResultRecord.h"
+#include "TermMatcher.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+std::string ResultRecord::toJsonLine(const resultRecord& record) {
+    std::string line = "{\"domain\":";
+    appendJsonString(&line, record.domain);
+    line += ",\"verified\":";
+    line += record.verified ? "true" : "false";
+    line += ",\"transferFailed\":";
+    line += record.transferFailed ? "true" : "false";
+    line += ",\"httpStatus\":" + std::to_string(record.httpStatus);
+    line += ",\"latencyMs\":" + std::to_string((long long)(record.fetchSeconds * 1000));
+    line += ",\"pageBytes\":" + std::to_string(record.pageBytes);
+    line += ",\"requiredTerms\":" + std::to_string(record.requiredTerms);
+    line += ",\"uniqueTerms\":" + std::to_string(record.matchedTerms.size());
+    line += ",\"terms\":{";
+    for(std::size_t i = 0; i < record.matchedTerms.size(); i++) {
+        if(i > 0)
+            line += ',';
+        appendJsonString(&line, record.matchedTerms[i].term);
+        line += ':' + std::to_string(record.matchedTerms[i].occurrences);
+    }
+    line += "},\"referrer\":";
+    if(record.referrer.empty())
+        line += "null";
+    else
+        appendJsonString(&line, record.referrer);
+    line += ",\"checkedAt\":" + std::to_string(record.checkedAt) + "}";
+    return line;
+}
+
+void ResultRecord::appendJsonString(std::string* buffer, std::string_view value) {
+    buffer->push_back('"');
+    for(char c : value) {
+        switch(c) {
+            case '"':
+                *buffer += "\\\"";
+                break;
+            case '\\':
+                *buffer += "\\\\";
+                break;
+            case '\n':
+                *buffer += "\\n";
+                break;
+            case '\r':
+                *buffer += "\\r";
+                break;
+            case '\t':
+                *buffer += "\\t";
+                break;
+            default:
+                // Other control characters are written as unicode escapes. Bytes above 0x7F are passed through
+                if((unsigned char)c < 0x20) {
+                    char escape[7];
+                    std::snprintf(escape, sizeof(escape), "\\u%04x", (unsigned char)c);
+                    *buffer += escape;
+                } else
+                    buffer->push_back(c);
+        }
+    }
+    buffer->push_back('"');
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef RESULTRECORD_H
+#define RESULTRECORD_H
+
+#include "TermMatcher.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * A structure representing the evidence gathered for one domain checked by the searcher.
+ */
+struct resultRecord {
+    std::string_view domain;
+    bool verified = false;
+    bool transferFailed = false;
+    long httpStatus = 0;
+    double fetchSeconds = 0;
+    std::size_t pageBytes = 0;
+    int requiredTerms = 0;
+    std::vector<termMatch> matchedTerms;
+    std::string_view referrer;
+    std::int64_t checkedAt = 0;
+};
+
+/**
+ * ResultRecord formats result records as JSON lines.
+ * 
+ * Each line is one JSON object with the fields "domain", "verified", "transferFailed", "httpStatus", "latencyMs",
+ * "pageBytes", "requiredTerms", "uniqueTerms", "terms" (an object mapping each matched term to its occurrences),
+ * "referrer" (null if unknown), and "checkedAt" (seconds since the epoch).
+ */
+class ResultRecord {
+    public:
+
+        /**
+         * Formats a result record as a line of JSON, without a trailing newline.
+         * 
+         * @param record the record to format.
+         * @return the JSON line.
+         */
+        static std::string toJsonLine(const resultRecord& record);
+
+        /**
+         * Appends a string to a buffer as a quoted, escaped JSON string.
+         * 
+         * @param[out] buffer a pointer to the buffer.
+         * @param value the string to append.
+         */
+        static void appendJsonString(std::string* buffer, std::string_view value);
+};
+
+#endif
\ No newline at end of file
@@ -1,45 +1,170 @@
 #include "SearcherThread.h"
+#include "Checkpoint.h"
 #include "Config.h"
+#include "DomainFilterSet.h"
+#include "DomainInternTable.h"
+#include "MetricsRegistry.h"
+#include "PageTracer.h"
+#include "OutputWriter.h"
+#include "ResultRecord.h"
 #include "CurlInteractionStructs.h"
+#include "TaskScheduler.h"
 #include "TermMatcher.h"
 #include "ThreadSafeQueue.h"
 #include "ThreadSafeSet.h"
+#include "VerdictCache.h"
 #include <atomic>
-#include <fstream>
+#include <cstdint>
+#include <chrono>
+#include <climits>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
+
+SearcherThread::SearcherThread(curlIO cIO, std::atomic<int>* killS, ThreadSafeQueue<extractedDomain>* dQueue, DomainFilterSet* cDomains, Config* config, DomainInternTable* dTable, VerdictCache* vCache, MetricsRegistry* metricsRegistry, PageTracer* pageTracer) {
+    const int defaultVerificationWorkers = 4;
+    const int maxVerificationWorkersLimit = 64;
+    const int defaultMaxPendingDomains = 100000;
+    const std::string defaultOutputFile = "output.txt";
+    const int defaultOutputAppend = 0;
+    const int defaultResultsEnabled = 0;
+    const std::string defaultResultsFile = "results.jsonl";
 
-SearcherThread::SearcherThread(curlIO cIO, std::atomic<int>* killS, ThreadSafeQueue<std::string>* dQueue, ThreadSafeSet<std::string>* cDomains, Config* config) {
     curlOutputQueue = cIO.output;
     curlUrls = cIO.urls;
     killSwitch = killS;
     domainQueue = dQueue;
     checkedDomains = cDomains;
-    sleepLockMilliseconds = std::chrono::milliseconds(20);
-    output = std::ofstream("output.txt", std::ofstream::out);
+    domainTable = dTable;
+    verdictCache = vCache;
+    metrics = metricsRegistry;
+    tracer = pageTracer;
+    verifiedDomainCount = 0;
+    maxVerificationWorkers = config->getIntConfig("Searcher_VerificationThreads", defaultVerificationWorkers, 1, maxVerificationWorkersLimit);
+    maxPendingDomains = config->getIntConfig("Searcher_MaxPendingDomains", defaultMaxPendingDomains, 1, INT_MAX);
+    outputConfig = config;
+    outputFile = config->getConfig("Output_File", defaultOutputFile);
+    alwaysAppend = config->getIntConfig("Output_Append", defaultOutputAppend, 0, 1) == 1;
+    resultsEnabled = config->getIntConfig("Results_Enabled", defaultResultsEnabled, 0, 1) == 1;
+    resultsFile = config->getConfig("Results_File", defaultResultsFile);
 }
 
-void SearcherThread::search(TermMatcher* validator) {
-    // While the killswitch hasnt been thrown
-    while(killSwitch->load() == 0) {
-        if(!pushToCurlQueue() && !consumeCurlQueue(validator))
-            std::this_thread::sleep_for(sleepLockMilliseconds);
-    }
+SearcherThread::~SearcherThread() {
+    delete output;
+    delete resultsOutput;
+}
+
+void SearcherThread::openOutput(bool appendOutput) {
+    output = new OutputWriter(outputFile, appendOutput || alwaysAppend, outputConfig);
+    if(resultsEnabled)
+        resultsOutput = new OutputWriter(resultsFile, appendOutput || alwaysAppend, outputConfig);
+}
+
+void SearcherThread::addStages(TaskScheduler* scheduler, TermMatcher* validator) {
+    // Dispatching is cheap and ordered, so a single worker runs it
+    scheduler->addStage([this]() { return pushToCurlQueue(); }, 1);
+    scheduler->addStage([this, validator]() { return consumeCurlQueue(validator); }, maxVerificationWorkers);
+}
+
+void SearcherThread::finish() {
+    // Verification has stopped, so any domain left in the writer's batch is written before the file is closed
+    output->close();
+    if(resultsOutput)
+        resultsOutput->close();
     std::cout << "Searcher Exiting\n";
-    output.close();
+}
+
+bool SearcherThread::syncOutput() {
+    // Both files are synced even if the first fails
+    const bool outputSynced = output->sync();
+    return (!resultsOutput || resultsOutput->sync()) && outputSynced;
+}
+
+void SearcherThread::saveState(CheckpointWriter* writer) {
+    writer->writeInt(verifiedDomainCount.load());
+
+    checkedDomains->saveState(writer);
+
+    writer->writeUint(domainQueue->size());
+    // Referring pages are not saved, so records of domains checked after a resume have no referrer
+    domainQueue->forEach([this, writer](const extractedDomain& domain) { writer->writeString(domainTable->lookup(domain.domainId)); });
+
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    writer->writeUint(pendingDomains.size());
+    for(const std::pair<const std::uint32_t, std::shared_ptr<const std::string>>& pending : pendingDomains)
+        writer->writeString(domainTable->lookup(pending.first));
+}
+
+bool SearcherThread::loadState(CheckpointReader* reader) {
+    std::string domain;
+    std::int64_t verifiedCount;
+    std::uint64_t count;
+
+    if(!reader->readInt(&verifiedCount))
+        return false;
+    verifiedDomainCount = verifiedCount;
+
+    if(!checkedDomains->loadState(reader))
+        return false;
+
+    if(!reader->readUint(&count))
+        return false;
+    for(std::uint64_t i = 0; i < count; i++) {
+        if(!reader->readString(&domain))
+            return false;
+        const std::uint32_t domainId = domainTable->intern(domain);
+        if(domainId != 0)
+            domainQueue->push(extractedDomain {domainId, nullptr});
+    }
+
+    // Pending domains are already in checkedDomains, so they are sent to curl directly
+    if(!reader->readUint(&count))
+        return false;
+    for(std::uint64_t i = 0; i < count; i++) {
+        if(!reader->readString(&domain))
+            return false;
+        const std::uint32_t domainId = domainTable->intern(domain);
+        if(domainId == 0)
+            continue;
+        addPendingDomain(domainId, nullptr);
+        curlUrls->push(domain);
+    }
+    return true;
+}
+
+long SearcherThread::getVerifiedDomainCount() {
+    return verifiedDomainCount.load();
 }
 
 bool SearcherThread::pushToCurlQueue() {
-    std::string domainToCheck;
+    extractedDomain extracted;
 
     if(domainQueue->empty())
         return false;
-    if(domainQueue->safePop(&domainToCheck)) {
+    if(domainQueue->safePop(&extracted)) {
+        const std::uint32_t domainToCheck = extracted.domainId;
         // If the domain has not been visited yet, push these elements to the curlUrls queue
-        if(checkedDomains->safeInsert(domainToCheck))
-            curlUrls->push(domainToCheck);
+        if(checkedDomains->safeInsert(domainToCheck)) {
+            VerdictCache::verdict cached;
+            if(verdictCache->lookup(domainToCheck, &cached)) {
+                // Crypto domains found on a previous run are still written to this run's output
+                if(cached == VerdictCache::cryptoVerdict) {
+                    output->write(domainTable->lookup(domainToCheck));
+                    verifiedDomainCount++;
+                    metrics->increment(MetricsRegistry::domainsVerifiedCounter);
+                }
+                metrics->increment(MetricsRegistry::cachedVerdictsCounter);
+                return true;
+            }
+            addPendingDomain(domainToCheck, std::move(extracted.referrer));
+            curlUrls->push(std::string(domainTable->lookup(domainToCheck)));
+        }
     }
     return true;
 }
@@ -48,16 +173,102 @@ bool SearcherThread::consumeCurlQueue(TermMatcher* validator) {
     const std::string htmlDoctypeTag  = "<!DOCTYPE";
 
     siteData curlOutput;
+    std::uint32_t domainId = 0;
 
     if(curlOutputQueue->empty())
         return false;
     if(curlOutputQueue->safePop(&curlOutput)) {
-        // Check for the DOCTYPE decleration then write the domain if the site contains enough terms
-        if(!curlOutput.siteContents.empty() && (curlOutput.siteContents.front().compare(0, htmlDoctypeTag.size(), htmlDoctypeTag)) == 0)
-            if(validator && validator->matchTerms(curlOutput.siteContents, false))
-                output << curlOutput.siteUrl << std::endl;
+        if(curlOutput.trace)
+            curlOutput.trace->dequeuedAt = std::chrono::steady_clock::now();
+        std::shared_ptr<const std::string> referrer;
+        // Curl reports the URL exactly as it was sent, which is the domain itself
+        if(domainTable->find(curlOutput.siteUrl, &domainId))
+            referrer = takePendingDomain(domainId);
+        if(domainId == 0)
+            domainId = domainTable->intern(curlOutput.siteUrl);
+        // A domain the intern table had no room for can't be recorded
+        if(domainId == 0)
+            return true;
+
+        std::uint64_t pageBytes = 0;
+        for(const std::string& chunk : curlOutput.siteContents)
+            pageBytes += chunk.size();
+        metrics->record(MetricsRegistry::searcherQueueWaitHistogram, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - curlOutput.queuedAt).count());
+        metrics->record(MetricsRegistry::searcherFetchLatencyHistogram, (std::uint64_t)(curlOutput.fetchSeconds * 1000000));
+
+        resultRecord record;
+        bool verified = false;
+        if(curlOutput.transferFailed) {
+            metrics->increment(MetricsRegistry::searcherFailuresCounter);
+            verdictCache->record(domainId, VerdictCache::unreachableVerdict);
+        } else {
+            metrics->increment(MetricsRegistry::searcherPagesCounter);
+            metrics->increment(MetricsRegistry::bytesFetchedCounter, pageBytes);
+            metrics->record(MetricsRegistry::pageBytesHistogram, pageBytes);
+            // Check for the DOCTYPE decleration then queue the domain for writing if the site contains enough terms
+            const bool isHtml = !curlOutput.siteContents.empty() && (curlOutput.siteContents.front().compare(0, htmlDoctypeTag.size(), htmlDoctypeTag)) == 0;
+            if(isHtml && validator) {
+                const std::chrono::steady_clock::time_point matchStart = std::chrono::steady_clock::now();
+                // The matched terms are only counted when a record will hold them, as counting reads the whole page
+                if(resultsOutput)
+                    verified = validator->matchTerms(curlOutput.siteContents, false, &record.matchedTerms);
+                else
+                    verified = validator->matchTerms(curlOutput.siteContents, false);
+                const std::chrono::steady_clock::time_point matchEnd = std::chrono::steady_clock::now();
+                metrics->record(MetricsRegistry::matchTimeHistogram, std::chrono::duration_cast<std::chrono::microseconds>(matchEnd - matchStart).count());
+                if(curlOutput.trace) {
+                    curlOutput.trace->matchStartedAt = matchStart;
+                    curlOutput.trace->matchEndedAt = matchEnd;
+                }
+            }
+            if(verified) {
+                output->write(domainTable->lookup(domainId));
+                verifiedDomainCount++;
+                metrics->increment(MetricsRegistry::domainsVerifiedCounter);
+                verdictCache->record(domainId, VerdictCache::cryptoVerdict);
+            } else
+                verdictCache->record(domainId, VerdictCache::nonCryptoVerdict);
+        }
+
+        if(resultsOutput) {
+            record.domain = domainTable->lookup(domainId);
+            record.verified = verified;
+            record.transferFailed = curlOutput.transferFailed;
+            record.httpStatus = curlOutput.httpStatus;
+            record.fetchSeconds = curlOutput.fetchSeconds;
+            record.pageBytes = pageBytes;
+            record.requiredTerms = validator ? validator->getNumRequiredTerms() : 0;
+            if(referrer)
+                record.referrer = *referrer;
+            record.checkedAt = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            resultsOutput->write(ResultRecord::toJsonLine(record));
+        }
+        if(curlOutput.trace) {
+            curlOutput.trace->analysisEndedAt = std::chrono::steady_clock::now();
+            tracer->record("searcher", curlOutput);
+        }
     }
     return true;
 }
 
-//For now maybe limit based on output queue size? << gonna do a cIO setting
\ No newline at end of file
+std::shared_ptr<const std::string> SearcherThread::takePendingDomain(std::uint32_t domainId) {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    std::unordered_map<std::uint32_t, std::shared_ptr<const std::string>>::iterator it = pendingDomains.find(domainId);
+    if(it == pendingDomains.end())
+        return nullptr;
+    std::shared_ptr<const std::string> referrer = std::move(it->second);
+    // The id stays in pendingDomainOrder, and is skipped when it reaches the front
+    pendingDomains.erase(it);
+    return referrer;
+}
+
+void SearcherThread::addPendingDomain(std::uint32_t domainId, std::shared_ptr<const std::string> referrer) {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    // Transfers which never complete are not reported back, so the oldest domains are forgotten once the limit is reached
+    if(pendingDomains.emplace(domainId, std::move(referrer)).second)
+        pendingDomainOrder.push(domainId);
+    while(pendingDomainOrder.size() > maxPendingDomains) {
+        pendingDomains.erase(pendingDomainOrder.front());
+        pendingDomainOrder.pop();
+    }
+}
\ No newline at end of file
@@ -1,17 +1,31 @@
 #ifndef SEARCHERTHREAD_H
 #define SEARCHERTHREAD_H
 
+#include "Checkpoint.h"
 #include "Config.h"
+#include "DomainFilterSet.h"
+#include "DomainInternTable.h"
+#include "MetricsRegistry.h"
+#include "PageTracer.h"
+#include "OutputWriter.h"
+#include "ResultRecord.h"
 #include "CurlInteractionStructs.h"
+#include "TaskScheduler.h"
 #include "TermMatcher.h"
 #include "ThreadSafeQueue.h"
 #include "ThreadSafeSet.h"
+#include "VerdictCache.h"
 #include <atomic>
-#include <fstream>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 class SearcherThread {
     public:
@@ -24,41 +38,128 @@ class SearcherThread {
          * 
          * @param cIO the struct holding the input and output queue pointers for curl.
          * @param killS a pointer to the kill switch semaphore.
-         * @param dQueue a pointer to a queue of domains to be searched.
+         * @param dQueue a pointer to a queue of domains to be searched, and the pages they were found on.
          * @param cDomains a pointer to domains already checked.
          * @param config a pointer to the object holding the program's configurations.
+         *      SearcherThread Configs:
+         *          Searcher_VerificationThreads the maximum number of workers checking fetched domains for terms at once.
+         *          Searcher_MaxPendingDomains the number of domains sent to curl which are remembered until they are verified.
+         *          Output_File the file verified domains are written to.
+         *          Output_Append 1 to always append to the output file, 0 to only append when resuming.
+         *          Results_Enabled 1 to write a JSON line of evidence for every fetched domain, 0 otherwise.
+         *          Results_File the file result records are written to.
+         * @param dTable a pointer to the table domains are interned in.
+         * @param vCache a pointer to the verdicts reached on previous runs. Domains with a verdict are not fetched again.
+         * @param metricsRegistry a pointer to the registry the searcher's metrics are updated in.
+         * @param pageTracer a pointer to the tracer the traces of sampled pages are written to.
          */
-        SearcherThread(curlIO cIO, std::atomic<int>* killS, ThreadSafeQueue<std::string>* dQueue, ThreadSafeSet<std::string>* cDomains, Config* config);
+        SearcherThread(curlIO cIO, std::atomic<int>* killS, ThreadSafeQueue<extractedDomain>* dQueue, DomainFilterSet* cDomains, Config* config, DomainInternTable* dTable, VerdictCache* vCache, MetricsRegistry* metricsRegistry, PageTracer* pageTracer);
+
+        // Closes the output file.
+        ~SearcherThread();
+
+        /**
+         * Opens the output file, and the results file if result records are enabled. Must be called before the
+         * searcher's stages start.
+         * 
+         * @param appendOutput whether verified domains are appended to the output file, as when resuming, rather than replacing it.
+         */
+        void openOutput(bool appendOutput);
 
         /**
-         * Uses curl to check subdomain homepages for terms.
+         * Adds the searcher's stages to a scheduler. The searcher uses curl to check subdomain homepages for terms.
          * 
-         * If the subdomain contains a specified number of terms, it is written to an output file.
+         * If the subdomain contains a specified number of terms, it is queued for the output file's writer thread.
          * 
+         * One stage dispatches domains to curl, and one checks the fetched pages. The stages run until the kill switch
+         * is thrown.
+         * 
+         * @param scheduler a pointer to the scheduler to add the stages to.
          * @param validator the TermMatcher object to use during domain validation.
          */
-        void search(TermMatcher* validator);
+        void addStages(TaskScheduler* scheduler, TermMatcher* validator);
+
+        /**
+         * Writes any remaining verified domains, then closes the output file. Called once the scheduler has been joined.
+         */
+        void finish();
+
+        /**
+         * Writes the searcher's state to a checkpoint: the checked domains, the domains waiting to be checked, and the
+         * domains sent to curl but not yet verified. The searcher's stages must be paused.
+         * 
+         * @param writer a pointer to the checkpoint writer.
+         */
+        void saveState(CheckpointWriter* writer);
+
+        /**
+         * Flushes the domains verified so far, and their result records, to disk. A checkpoint must not be committed
+         * before this returns, as the domains it holds as checked are not checked again on resume.
+         * 
+         * @return true if the files reached the disk, false otherwise.
+         */
+        bool syncOutput();
+
+        /**
+         * Merges the state saved to a checkpoint into the searcher's state. Domains which had been sent to curl are
+         * sent again. Must be called before the searcher's stages start.
+         * 
+         * @param reader a pointer to the checkpoint reader.
+         * @return true if the state was read, false if the checkpoint is corrupt.
+         */
+        bool loadState(CheckpointReader* reader);
+
+        /**
+         * Gets the number of domains verified since the searcher started.
+         * 
+         * @return the number of domains written to the output file, or waiting to be written.
+         */
+        long getVerifiedDomainCount();
 
     private:
         ThreadSafeQueue<siteData>* curlOutputQueue;
         ThreadSafeQueue<std::string>* curlUrls;
-        ThreadSafeQueue<std::string>* domainQueue;
+        ThreadSafeQueue<extractedDomain>* domainQueue;
 
-        ThreadSafeSet<std::string>* checkedDomains;
+        DomainFilterSet* checkedDomains;
+        DomainInternTable* domainTable;
+
+        VerdictCache* verdictCache;
+
+        MetricsRegistry* metrics;
+        PageTracer* tracer;
+
+        std::atomic<long> verifiedDomainCount;
+
+        // The ids of domains sent to curl which have not come back with their referring pages, and the order they were sent in
+        std::unordered_map<std::uint32_t, std::shared_ptr<const std::string>> pendingDomains;
+        std::queue<std::uint32_t> pendingDomainOrder;
+        std::mutex pendingMutex;
+        std::size_t maxPendingDomains;
 
         std::unordered_set<std::string> searchTerms;
 
         std::atomic<int>* killSwitch;
 
-        std::ofstream output;
-        
-        std::chrono::milliseconds sleepLockMilliseconds;
+        // Writes verified domains from its own thread. Allocated by openOutput, as the writer can't be copied
+        OutputWriter* output = nullptr;
+        // Writes result records from its own thread, if they are enabled
+        OutputWriter* resultsOutput = nullptr;
+
+        Config* outputConfig;
+        std::string outputFile;
+        std::string resultsFile;
+        bool resultsEnabled;
+        bool alwaysAppend;
+
+        int maxVerificationWorkers;
 
         /**
          * Checks against the domain at the front of the domainQueue against the list of checkedDomains.
          * 
-         * If the domain hasn't been scraped by SearcherThread before, the domain is pushed to the curl
-         * input queue and is added to the checkedDomains set.
+         * If the domain hasn't been scraped by SearcherThread before, the domain is added to the checkedDomains set.
+         * Domains with a cached verdict are answered from the verdict cache, and every other domain is pushed to the
+         * curl input queue.
          * 
          * @return true if the domain is pushed to the curl's input queue. Returns false otherwise.  
          */
@@ -67,12 +168,30 @@ class SearcherThread {
         /**
          * Passes a site contents as a vector of strings to TermMatcher to determine whether a domain meets certain criteria. 
          * 
-         * If it does, TermMatcher returns true, and the site's url is sent to the output file.
+         * If it does, TermMatcher returns true, and the site's url is queued for the output file's writer. The verdict
+         * is recorded in the verdict cache, as is the failure of a transfer. If result records are enabled, a record
+         * of the evidence is queued for the results file's writer.
          * 
          * @param validator the TermMatcher to use in the domain validation process.
          * @return false if the curlOutputQueue is empty, true otherwise.
          */
         bool consumeCurlQueue(TermMatcher* validator);
+
+        /**
+         * Remembers a domain sent to curl, so it can be sent again on resume if it is not verified before a checkpoint.
+         * 
+         * @param domainId the id of the domain sent to curl.
+         * @param referrer the URL of the page the domain was found on, or nullptr if it is unknown.
+         */
+        void addPendingDomain(std::uint32_t domainId, std::shared_ptr<const std::string> referrer);
+
+        /**
+         * Forgets a domain sent to curl once it has come back.
+         * 
+         * @param domainId the id of the domain.
+         * @return the URL of the page the domain was found on, or nullptr if it is unknown.
+         */
+        std::shared_ptr<const std::string> takePendingDomain(std::uint32_t domainId);
 };
 
 #endif
\ No newline at end of file
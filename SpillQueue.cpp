@@ -0,0 +1,263 @@
+#include "SpillQueue.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+SpillQueue::SpillQueue(std::string spillDirectory, std::uint64_t segmentBytes) {
+    directory = spillDirectory;
+    maxSegmentBytes = segmentBytes;
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if(error)
+        std::cout << "ERROR: Could Not Create Spill Directory: " << directory << "\n";
+}
+
+SpillQueue::~SpillQueue() {
+    if(writer.is_open())
+        writer.close();
+    if(reader.is_open())
+        reader.close();
+    // A queue which was never used holds no segments of its own
+    if(!staleSegmentsRemoved)
+        return;
+    // Segments a held snapshot refers to are kept, as a checkpoint may read them on the next run
+    for(long segment = readSegment; segment <= writeSegment; segment++) {
+        if(!isHeld(segment))
+            std::remove(segmentPath(segment).c_str());
+    }
+    for(long segment : retiredSegments) {
+        if(!isHeld(segment))
+            std::remove(segmentPath(segment).c_str());
+    }
+}
+
+bool SpillQueue::push(std::string_view record) {
+    removeStaleSegments(0, -1);
+    if(!writer.is_open()) {
+        writer.open(segmentPath(writeSegment), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+        if(!writer.is_open()) {
+            std::cout << "ERROR: Could Not Open Spill Segment: " << segmentPath(writeSegment) << "\n";
+            return false;
+        }
+    }
+
+    const std::uint32_t length = record.size();
+    const unsigned char lengthBytes[4] = {(unsigned char)length, (unsigned char)(length >> 8), (unsigned char)(length >> 16), (unsigned char)(length >> 24)};
+    writer.write((const char*)lengthBytes, sizeof(lengthBytes));
+    writer.write(record.data(), record.size());
+    if(!writer) {
+        std::cout << "ERROR: Could Not Write Spill Segment: " << segmentPath(writeSegment) << "\n";
+        return false;
+    }
+    writeSegmentBytes += sizeof(lengthBytes) + record.size();
+    records++;
+    segmentRecords.back()++;
+
+    if(writeSegmentBytes >= maxSegmentBytes)
+        closeWriteSegment();
+    return true;
+}
+
+bool SpillQueue::pop(std::string* record) {
+    while(records > 0) {
+        // Records are only read from closed segments, so the segment being written is closed once every older one is read
+        if(!reading && readSegment == writeSegment)
+            closeWriteSegment();
+        // The segment has been read, so move on to the next one
+        if(segmentRecords.front() == 0) {
+            finishReadSegment();
+            continue;
+        }
+        if(!reading) {
+            reader.open(segmentPath(readSegment), std::ifstream::in | std::ifstream::binary);
+            if(!reader.is_open()) {
+                std::cout << "ERROR: Could Not Open Spill Segment: " << segmentPath(readSegment) << "\n";
+                finishReadSegment();
+                continue;
+            }
+            reader.seekg(readOffset);
+            reading = true;
+        }
+
+        unsigned char lengthBytes[4];
+        std::uint32_t length = 0;
+        if(reader.read((char*)lengthBytes, sizeof(lengthBytes))) {
+            length = lengthBytes[0] | (lengthBytes[1] << 8) | (lengthBytes[2] << 16) | ((std::uint32_t)lengthBytes[3] << 24);
+            record->resize(length);
+        }
+        if(!reader || !reader.read(record->data(), length)) {
+            std::cout << "ERROR: Truncated Spill Segment: " << segmentPath(readSegment) << "\n";
+            finishReadSegment();
+            continue;
+        }
+        records--;
+        segmentRecords.front()--;
+        // Delete a fully read segment straight away, rather than on the next read
+        if(segmentRecords.front() == 0)
+            finishReadSegment();
+        return true;
+    }
+    return false;
+}
+
+void SpillQueue::takeSnapshot(spillSnapshot* snapshot) {
+    if(writer.is_open())
+        writer.flush();
+    snapshot->firstSegment = readSegment;
+    snapshot->firstOffset = reading ? (std::uint64_t)reader.tellg() : readOffset;
+    snapshot->segmentRecords.assign(segmentRecords.begin(), segmentRecords.end());
+    snapshot->records = records;
+    heldSnapshots.push_back(std::make_pair(readSegment, writeSegment));
+}
+
+bool SpillQueue::syncSnapshot(const spillSnapshot& snapshot) {
+    const long lastSegment = snapshot.firstSegment + (long)snapshot.segmentRecords.size() - 1;
+    bool synced = true;
+    for(long segment = std::max(snapshot.firstSegment, syncedSegments); segment <= lastSegment; segment++) {
+        // A segment without records in the snapshot may never have been created
+        if(snapshot.segmentRecords[segment - snapshot.firstSegment] == 0)
+            continue;
+        // Opening for append leaves the segment as it is, and allows the handle to be committed on Windows
+        std::FILE* file = std::fopen(segmentPath(segment).c_str(), "ab");
+        if(!file) {
+            synced = false;
+            continue;
+        }
+#ifdef _WIN32
+        synced = _commit(_fileno(file)) == 0 && synced;
+#else
+        synced = fsync(fileno(file)) == 0 && synced;
+#endif
+        synced = std::fclose(file) == 0 && synced;
+    }
+    if(!synced) {
+        std::cout << "ERROR: Could Not Sync Spill Segments: " << directory << "\n";
+        return false;
+    }
+    // The last segment may still be written to, so it is synced again with the next snapshot
+    syncedSegments = std::max(syncedSegments, lastSegment);
+    return true;
+}
+
+bool SpillQueue::adoptSnapshot(const spillSnapshot& snapshot) {
+    const long lastSegment = snapshot.firstSegment + (long)snapshot.segmentRecords.size() - 1;
+    long total = 0;
+    bool complete = snapshot.firstSegment >= 0 && !snapshot.segmentRecords.empty();
+    for(long segment = snapshot.firstSegment; complete && segment <= lastSegment; segment++) {
+        const long count = snapshot.segmentRecords[segment - snapshot.firstSegment];
+        std::error_code error;
+        complete = count >= 0 && (count == 0 || std::filesystem::exists(segmentPath(segment), error));
+        total += count;
+    }
+    if(!complete || total != snapshot.records) {
+        std::cout << "ERROR: Spilled URLs Are Missing From: " << directory << "\n";
+        return false;
+    }
+
+    removeStaleSegments(snapshot.firstSegment, lastSegment);
+    readSegment = snapshot.firstSegment;
+    readOffset = snapshot.firstOffset;
+    segmentRecords.assign(snapshot.segmentRecords.begin(), snapshot.segmentRecords.end());
+    records = snapshot.records;
+    // The last segment may hold records written after the snapshot was taken, so new records go to a new segment
+    writeSegment = lastSegment + 1;
+    writeSegmentBytes = 0;
+    segmentRecords.push_back(0);
+    // The run which took the snapshot synced its segments before committing the checkpoint holding it
+    syncedSegments = writeSegment;
+    heldSnapshots.push_back(std::make_pair(snapshot.firstSegment, lastSegment));
+    return true;
+}
+
+void SpillQueue::releaseSnapshot(const spillSnapshot& snapshot) {
+    const long lastSegment = snapshot.firstSegment + (long)snapshot.segmentRecords.size() - 1;
+    std::vector<std::pair<long, long>>::iterator it = std::find(heldSnapshots.begin(), heldSnapshots.end(), std::make_pair(snapshot.firstSegment, lastSegment));
+    if(it != heldSnapshots.end())
+        heldSnapshots.erase(it);
+
+    std::vector<long> keptSegments;
+    for(long segment : retiredSegments) {
+        if(isHeld(segment))
+            keptSegments.push_back(segment);
+        else
+            std::remove(segmentPath(segment).c_str());
+    }
+    retiredSegments.swap(keptSegments);
+}
+
+long SpillQueue::size() {
+    return records;
+}
+
+bool SpillQueue::empty() {
+    return records == 0;
+}
+
+std::string SpillQueue::segmentPath(long segment) const {
+    return (std::filesystem::path(directory) / ("segment_" + std::to_string(segment) + ".bin")).string();
+}
+
+bool SpillQueue::isHeld(long segment) const {
+    for(const std::pair<long, long>& held : heldSnapshots) {
+        if(segment >= held.first && segment <= held.second)
+            return true;
+    }
+    return false;
+}
+
+void SpillQueue::removeStaleSegments(long first, long last) {
+    const std::string segmentPrefix = "segment_";
+
+    if(staleSegmentsRemoved)
+        return;
+    staleSegmentsRemoved = true;
+    // Segments from a previous run are stale, unless a checkpoint's snapshot refers to them
+    std::error_code error;
+    for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error)) {
+        const std::string name = entry.path().filename().string();
+        if(name.compare(0, segmentPrefix.size(), segmentPrefix) != 0)
+            continue;
+        const long segment = std::strtol(name.c_str() + segmentPrefix.size(), nullptr, 10);
+        if(segment < first || segment > last || name != std::filesystem::path(segmentPath(segment)).filename().string())
+            std::filesystem::remove(entry.path(), error);
+    }
+}
+
+void SpillQueue::closeWriteSegment() {
+    if(writer.is_open())
+        writer.close();
+    writeSegment++;
+    writeSegmentBytes = 0;
+    segmentRecords.push_back(0);
+}
+
+void SpillQueue::finishReadSegment() {
+    if(reader.is_open())
+        reader.close();
+    reader.clear();
+    // A segment holding records of a snapshot is deleted once the snapshot is released
+    if(isHeld(readSegment))
+        retiredSegments.push_back(readSegment);
+    else
+        std::remove(segmentPath(readSegment).c_str());
+    records -= segmentRecords.front();
+    segmentRecords.pop_front();
+    readSegment++;
+    readOffset = 0;
+    reading = false;
+}
\ No newline at end of file
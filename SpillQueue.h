@@ -0,0 +1,189 @@
+#ifndef SPILLQUEUE_H
+#define SPILLQUEUE_H
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// A structure representing the records a spill queue held when a snapshot was taken, by their place in the segments
+struct spillSnapshot {
+    long firstSegment = 0;
+    // The offset of the first record in the first segment which had not been read
+    std::uint64_t firstOffset = 0;
+    // The number of records each segment held, from the first segment on
+    std::vector<long> segmentRecords;
+    long records = 0;
+};
+
+/**
+ * SpillQueue is a first in, first out queue of byte records stored in append-only segment files on disk.
+ * 
+ * Records are written to the newest segment, and read back from the oldest. Each record is a 32-bit little-endian
+ * length followed by the record's bytes. A segment is closed once it reaches the segment size, and deleted once
+ * every record in it has been read, so only the write and read buffers are held in memory.
+ * 
+ * A snapshot records where the queue's records are in the segments, so a checkpoint can refer to the segments rather
+ * than copy them. Segments are kept on disk until every snapshot which refers to them is released, even once they
+ * have been read or the queue is destroyed, and a later queue can adopt a snapshot and read its records in place.
+ * 
+ * This class is not thread-safe, other than syncSnapshot.
+ */
+class SpillQueue {
+    public:
+
+        // Default constructor
+        SpillQueue() = default;
+
+        /**
+         * Constructor. Segments left in the directory by a previous run are deleted when the queue is first written,
+         * unless a snapshot of them is adopted first.
+         * 
+         * @param spillDirectory the directory the segment files are written to. The directory is created if needed.
+         * @param segmentBytes the size at which a segment is closed and a new one is started.
+         */
+        SpillQueue(std::string spillDirectory, std::uint64_t segmentBytes);
+
+        // Closes every segment, and deletes those no held snapshot refers to.
+        ~SpillQueue();
+
+        SpillQueue(const SpillQueue&) = delete;
+        SpillQueue& operator=(const SpillQueue&) = delete;
+
+        /**
+         * Appends a record to the queue.
+         * 
+         * @param record the record to append.
+         * @return true if the record was written, false if the segment could not be written.
+         */
+        bool push(std::string_view record);
+
+        /**
+         * Reads the oldest record in the queue.
+         * 
+         * A segment which can't be opened, or which ends in a torn record, is skipped, and the records left in it are
+         * dropped from the queue.
+         * 
+         * @param[out] record the record read.
+         * @return true if a record was read, false if the queue is empty.
+         */
+        bool pop(std::string* record);
+
+        /**
+         * Takes a snapshot of the records in the queue. The segments holding them are kept until the snapshot is released.
+         * 
+         * @param[out] snapshot the snapshot taken.
+         */
+        void takeSnapshot(spillSnapshot* snapshot);
+
+        /**
+         * Flushes a snapshot's segments through to the storage device. Segments which were closed when an earlier
+         * snapshot was synced are not synced again.
+         * 
+         * This function only touches the snapshot's segment files, so it can be called while another thread uses the
+         * queue, but not from two threads at once.
+         * 
+         * @param snapshot a snapshot which has not been released.
+         * @return true if every segment reached the disk, false otherwise.
+         */
+        bool syncSnapshot(const spillSnapshot& snapshot);
+
+        /**
+         * Replaces the queue's records with the records of a snapshot taken by an earlier queue in the same directory.
+         * The snapshot is held, and every other segment in the directory is deleted. Must be called before the queue
+         * is used.
+         * 
+         * @param snapshot the snapshot to adopt.
+         * @return true if every segment of the snapshot exists, false otherwise, in which case the queue is left empty.
+         */
+        bool adoptSnapshot(const spillSnapshot& snapshot);
+
+        /**
+         * Releases a snapshot, deleting the segments which were read while it was held and no other snapshot refers to.
+         * 
+         * @param snapshot the snapshot to release.
+         */
+        void releaseSnapshot(const spillSnapshot& snapshot);
+
+        /**
+         * Gets the number of records in the queue.
+         * 
+         * @return the number of records written and not yet read.
+         */
+        long size();
+
+        /**
+         * Checks whether the queue is empty.
+         * 
+         * @return true if the queue is empty, false otherwise.
+         */
+        bool empty();
+
+    private:
+        std::string directory;
+        std::uint64_t maxSegmentBytes;
+
+        std::ofstream writer;
+        long writeSegment = 0;
+        std::uint64_t writeSegmentBytes = 0;
+
+        std::ifstream reader;
+        long readSegment = 0;
+        bool reading = false;
+
+        // The offset the segment being read is opened at, which is only past its start for an adopted snapshot
+        std::uint64_t readOffset = 0;
+
+        long records = 0;
+
+        // The first and last segment of each held snapshot, and the segments which have been read but are kept for one
+        std::vector<std::pair<long, long>> heldSnapshots;
+        std::vector<long> retiredSegments;
+        bool staleSegmentsRemoved = false;
+
+        // Every segment below this one was closed when it was last synced, so it doesn't need to be synced again
+        long syncedSegments = 0;
+
+        // The number of records not yet read in each segment, from the segment being read to the segment being written
+        std::deque<long> segmentRecords {0};
+
+        /**
+         * Gets the path of a segment file.
+         * 
+         * @param segment the index of the segment.
+         * @return the path of the segment file.
+         */
+        std::string segmentPath(long segment) const;
+
+        /**
+         * Checks whether a held snapshot refers to a segment.
+         * 
+         * @param segment the index of the segment.
+         * @return true if a held snapshot refers to the segment, false otherwise.
+         */
+        bool isHeld(long segment) const;
+
+        /**
+         * Deletes every segment file in the directory, other than the segments from first to last, on the queue's first
+         * use.
+         * 
+         * @param first the first segment to keep.
+         * @param last the last segment to keep, or a segment before first to keep none.
+         */
+        void removeStaleSegments(long first, long last);
+
+        /**
+         * Closes the segment being written, so it can be read, and moves writes to the next segment.
+         */
+        void closeWriteSegment();
+
+        /**
+         * Closes and deletes the segment being read, and drops any records left in it.
+         */
+        void finishReadSegment();
+};
+
+#endif
\ No newline at end of file
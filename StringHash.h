@@ -0,0 +1,56 @@
+#ifndef STRINGHASH_H
+#define STRINGHASH_H
+
+#include <cstdint>
+#include <string_view>
+
+/**
+ * StringHash is the string hash shared by BloomFilter and VisitedUrlStore.
+ * 
+ * Both classes save state derived from the hash to checkpoints, so changing it invalidates saved checkpoints.
+ * BlocklistReader keeps its own copy, as its hash is part of the blocklist file format.
+ */
+class StringHash {
+    public:
+
+        /**
+         * Hashes a string with 64-bit FNV-1a, then mixes the result.
+         * 
+         * @param str the string to hash.
+         * @return the hash.
+         */
+        static std::uint64_t hash(std::string_view str);
+
+        /**
+         * Mixes the bits of a 64-bit value.
+         * 
+         * @param value the value to mix.
+         * @return the mixed value.
+         */
+        static std::uint64_t mix(std::uint64_t value);
+};
+
+
+inline std::uint64_t StringHash::hash(std::string_view str) {
+    const std::uint64_t fnvOffsetBasis = 14695981039346656037ULL;
+    const std::uint64_t fnvPrime = 1099511628211ULL;
+
+    std::uint64_t result = fnvOffsetBasis;
+    for(char c : str) {
+        result ^= (unsigned char)c;
+        result *= fnvPrime;
+    }
+    return mix(result);
+}
+
+inline std::uint64_t StringHash::mix(std::uint64_t value) {
+    // The finalizer of MurmurHash3
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+#endif
\ No newline at end of file
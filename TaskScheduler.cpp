@@ -0,0 +1,136 @@
+#include "TaskScheduler.h"
+#include "Config.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+TaskScheduler::TaskScheduler(std::atomic<int>* killS, Config* config) {
+    const int defaultWorkerCount = 0;
+    const int maxWorkerCount = 256;
+    // Used if the number of hardware threads can't be determined
+    const int fallbackWorkerCount = 4;
+    const int defaultStageBatchSize = 64;
+
+    killSwitch = killS;
+    stageBatchSize = defaultStageBatchSize;
+    idleSleepMilliseconds = std::chrono::milliseconds(2);
+    stageBackoffMilliseconds = std::chrono::milliseconds(5);
+    pausing = false;
+
+    workerCount = config->getIntConfig("Scheduler_Threads", defaultWorkerCount, 0, maxWorkerCount);
+    if(workerCount == 0)
+        workerCount = std::thread::hardware_concurrency();
+    if(workerCount == 0)
+        workerCount = fallbackWorkerCount;
+
+    for(int i = 0; i < workerCount; i++)
+        workerQueues.emplace_back();
+}
+
+void TaskScheduler::addStage(std::function<bool()> step, int maxParallel) {
+    stages.emplace_back();
+    stages.back().step = step;
+    stages.back().maxParallel = maxParallel > 0 ? maxParallel : 1;
+    stages.back().running = 0;
+    stages.back().idleUntil = 0;
+}
+
+void TaskScheduler::start() {
+    for(int i = 0; i < workerCount; i++)
+        workers.push_back(std::thread(&TaskScheduler::work, this, i));
+}
+
+void TaskScheduler::join() {
+    for(std::thread& worker : workers)
+        worker.join();
+    workers.clear();
+}
+
+void TaskScheduler::pause() {
+    // Workers stop starting stage runs first, so the exclusive lock isn't starved by new runs
+    pausing.store(true);
+    stageMutex.lock();
+}
+
+void TaskScheduler::resume() {
+    stageMutex.unlock();
+    pausing.store(false);
+}
+
+void TaskScheduler::work(int index) {
+    while(killSwitch->load() == 0) {
+        std::function<void()> task;
+        if(findTask(index, &task))
+            task();
+        // If there is no work, the worker sleeps
+        else if(!scheduleStages(index))
+            std::this_thread::sleep_for(idleSleepMilliseconds);
+    }
+}
+
+bool TaskScheduler::findTask(int index, std::function<void()>* task) {
+    // The worker's own deque is used as a stack, as its newest tasks are the most likely to be cached
+    {
+        workerQueue& own = workerQueues[index];
+        std::lock_guard<std::mutex> lock(own.mu);
+        if(!own.tasks.empty()) {
+            *task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    // Steal the oldest task of another worker, starting with the next worker so victims are spread out
+    for(int i = 1; i < workerCount; i++) {
+        workerQueue& victim = workerQueues[(index + i) % workerCount];
+        std::unique_lock<std::mutex> lock(victim.mu, std::try_to_lock);
+        if(lock.owns_lock() && !victim.tasks.empty()) {
+            *task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TaskScheduler::scheduleStages(int index) {
+    const long long now = nowNanoseconds();
+    bool scheduled = false;
+    for(schedulerStage& stage : stages) {
+        if(stage.idleUntil.load() > now)
+            continue;
+        // Claim one of the stage's slots
+        int running = stage.running.load();
+        while(running < stage.maxParallel && !stage.running.compare_exchange_weak(running, running + 1)) {}
+        if(running >= stage.maxParallel)
+            continue;
+
+        schedulerStage* stagePointer = &stage;
+        workerQueue& own = workerQueues[index];
+        std::lock_guard<std::mutex> lock(own.mu);
+        own.tasks.push_back([this, stagePointer]() { runStage(stagePointer); });
+        scheduled = true;
+    }
+    return scheduled;
+}
+
+void TaskScheduler::runStage(schedulerStage* stage) {
+    int steps = 0;
+    if(!pausing.load()) {
+        std::shared_lock<std::shared_mutex> lock(stageMutex);
+        while(steps < stageBatchSize && killSwitch->load() == 0 && stage->step())
+            steps++;
+    }
+    // A stage which found no work, or was paused, is left alone for a while, rather than being rescheduled by every idle worker
+    if(steps == 0)
+        stage->idleUntil.store(nowNanoseconds() + std::chrono::duration_cast<std::chrono::nanoseconds>(stageBackoffMilliseconds).count());
+    stage->running--;
+}
+
+long long TaskScheduler::nowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
\ No newline at end of file
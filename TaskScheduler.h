@@ -0,0 +1,136 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include "Config.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * TaskScheduler is a work-stealing task runtime which runs the program's pipeline stages on a pool of worker threads.
+ * 
+ * Each worker owns a deque of tasks. A worker runs the newest task of its own deque first, then steals the oldest task
+ * of another worker's deque.
+ * 
+ * Stages are recurring pieces of work, such as page analysis or domain verification. A worker which finds no task
+ * submits a run of every stage with a free slot as a task, so idle workers move to whichever stage is backed up.
+ */
+class TaskScheduler {
+    public:
+
+        /**
+         * Constructor.
+         * 
+         * @param killS a pointer to the kill switch semaphore. Workers exit once it is thrown.
+         * @param config a pointer to the object holding the program's configurations.
+         *      TaskScheduler Configs:
+         *          Scheduler_Threads the number of worker threads. 0 uses one worker per hardware thread.
+         */
+        TaskScheduler(std::atomic<int>* killS, Config* config);
+
+        /**
+         * Adds a stage to the scheduler. Stages must be added before the scheduler is started.
+         * 
+         * @param step a function which does one unit of the stage's work, and returns false if there was no work to do.
+         * @param maxParallel the maximum number of workers which may run the stage at once.
+         */
+        void addStage(std::function<bool()> step, int maxParallel);
+
+        /**
+         * Starts the worker threads.
+         */
+        void start();
+
+        /**
+         * Waits for every worker thread to exit. Tasks which have not run by the time the kill switch is thrown are dropped.
+         */
+        void join();
+
+        /**
+         * Stops new stage runs, and waits for the runs in progress to finish. Used to snapshot the stages' state.
+         */
+        void pause();
+
+        /**
+         * Lets stage runs continue after a pause.
+         */
+        void resume();
+
+    private:
+        struct workerQueue {
+            std::deque<std::function<void()>> tasks;
+            std::mutex mu;
+        };
+
+        struct schedulerStage {
+            std::function<bool()> step;
+            int maxParallel;
+            std::atomic<int> running;
+            // The time before which the stage is not rescheduled, after a run that found no work
+            std::atomic<long long> idleUntil;
+        };
+
+        std::deque<workerQueue> workerQueues;
+
+        std::deque<schedulerStage> stages;
+
+        std::vector<std::thread> workers;
+
+        // Held shared by every stage run, and exclusively while paused
+        std::shared_mutex stageMutex;
+        std::atomic<bool> pausing;
+
+        std::atomic<int>* killSwitch;
+
+        int workerCount;
+        // The number of times a stage's step is run per task
+        int stageBatchSize;
+
+        std::chrono::milliseconds idleSleepMilliseconds;
+        std::chrono::milliseconds stageBackoffMilliseconds;
+
+        /**
+         * Runs tasks and stages until the kill switch is thrown. Run by each worker thread.
+         * 
+         * @param index the index of the worker.
+         */
+        void work(int index);
+
+        /**
+         * Takes the next task for a worker from its own deque, or another worker's deque.
+         * 
+         * @param index the index of the worker.
+         * @param[out] task the task to run.
+         * @return true if a task was found, false otherwise.
+         */
+        bool findTask(int index, std::function<void()>* task);
+
+        /**
+         * Submits a run of every stage which has a free slot, and which is not backing off, to a worker's deque.
+         * 
+         * @param index the index of the worker.
+         * @return true if any stage run was submitted, false otherwise.
+         */
+        bool scheduleStages(int index);
+
+        /**
+         * Runs a stage's step until it finds no work, or until the batch size is reached, then frees the stage's slot.
+         * 
+         * @param stage a pointer to the stage to run.
+         */
+        void runStage(schedulerStage* stage);
+
+        /**
+         * Gets the current time in nanoseconds, for stage backoff.
+         * 
+         * @return the time since the steady clock's epoch.
+         */
+        static long long nowNanoseconds();
+};
+
+#endif
\ No newline at end of file
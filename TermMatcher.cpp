@@ -23,7 +23,9 @@ void TermMatcher::setTerms() {
     std::string currentLine;
     std::ifstream exclusionInputer = std::ifstream(termsFile);
     while(std::getline(exclusionInputer, currentLine)) {
-        terms.insert(currentLine);
+        // Empty terms would match every page, so blank lines are skipped
+        if(!currentLine.empty())
+            terms.insert(currentLine);
     }
 }
 
@@ -31,47 +33,87 @@ void TermMatcher::setTerms() {
  * matchTerms enumerates the vector and uses the std::string.find() function to check whether a number of unique terms exists within the data.
  */
 bool TermMatcher::matchTerms(std::vector<std::string> data, bool caseSensitive) {
-    const int maxTermSize = 5000;
-    int uniqueTermsFound = 0;
+    //Handle empty term list
+    if(terms.size() == 0)
+        return true;
+    const int uniqueTermsFound = countTerms(data, caseSensitive, numRequiredTerms, nullptr);
+    return uniqueTermsFound > 0 && uniqueTermsFound >= numRequiredTerms;
+}
 
+bool TermMatcher::matchTerms(const std::vector<std::string>& data, bool caseSensitive, int* uniqueTermsFound) {
+    *uniqueTermsFound = 0;
     //Handle empty term list
     if(terms.size() == 0)
         return true;
+    *uniqueTermsFound = countTerms(data, caseSensitive, terms.size(), nullptr);
+    return *uniqueTermsFound > 0 && *uniqueTermsFound >= numRequiredTerms;
+}
+
+bool TermMatcher::matchTerms(const std::vector<std::string>& data, bool caseSensitive, std::vector<termMatch>* matches) {
+    //Handle empty term list
+    if(terms.size() == 0)
+        return true;
+    const int uniqueTermsFound = countTerms(data, caseSensitive, terms.size(), matches);
+    return uniqueTermsFound > 0 && uniqueTermsFound >= numRequiredTerms;
+}
+
+int TermMatcher::getNumRequiredTerms() {
+    return numRequiredTerms;
+}
+
+int TermMatcher::countTerms(const std::vector<std::string>& data, bool caseSensitive, int stopAt, std::vector<termMatch>* matches) {
+    const int maxTermSize = 5000;
+    int uniqueTermsFound = 0;
+
+    // If the search is case insensitive, the data is capitalized once rather than once per term
+    std::vector<std::string> capitalizedData;
+    if(!caseSensitive) {
+        capitalizedData.reserve(data.size());
+        for(const std::string& str : data) {
+            std::string capitalized = str;
+            for(char& c : capitalized)
+                c = (char)toupper(c);
+            capitalizedData.push_back(std::move(capitalized));
+        }
+    }
+    const std::vector<std::string>& searchedData = caseSensitive ? data : capitalizedData;
+
     // Enumerate through all terms
-    for(std::string term : terms) {
+    for(const std::string& originalTerm : terms) {
+        std::string term = originalTerm;
         /**
          * Check to see if the term exists within the data
-         * If it does, uniqueTermsFound is incremented by 1 and checked to see if it is greater than numRequiredTerms
+         * If it does, uniqueTermsFound is incremented by 1 and checked to see if it has reached stopAt
          */
         // Check for case sensitivity
         if(term.size() < maxTermSize) {
             if(!caseSensitive) {
-                std::string tempTerm = term;
-                term.clear();
-                for(char c : tempTerm) {
-                    // If the search is case insensitive, matchTerms capitalizes the data before the comparison
-                    term += (char)toupper(c);
+                for(char& c : term) {
+                    // If the search is case insensitive, the term is capitalized before the comparison
+                    c = (char)toupper(c);
                 }
             }
-            for(std::string str : data) {
-                // Check for case sensitivity
-                if(!caseSensitive) {
-                    std::string tempStr = str;
-                    str.clear();
-                    str.shrink_to_fit();
-                    for(char c : tempStr) {
-                        // If the search is case insensitive, matchTerms capitalizes the data before the comparison
-                        str += (char)toupper(c);
-                    }
+            if(matches) {
+                int occurrences = 0;
+                for(const std::string& str : searchedData) {
+                    for(std::size_t position = str.find(term); position != std::string::npos; position = str.find(term, position + term.size()))
+                        occurrences++;
                 }
+                if(occurrences > 0) {
+                    matches->push_back(termMatch {originalTerm, occurrences});
+                    uniqueTermsFound++;
+                }
+                continue;
+            }
+            for(const std::string& str : searchedData) {
                 if(str.find(term) != std::string::npos) {
                     uniqueTermsFound++;
-                    if(uniqueTermsFound >= numRequiredTerms)
-                        return true;
+                    if(uniqueTermsFound >= stopAt)
+                        return uniqueTermsFound;
                     break;
                 }
             }
         }
     }
-    return false;
+    return uniqueTermsFound;
 }
\ No newline at end of file
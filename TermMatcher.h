@@ -7,6 +7,14 @@
 #include <unordered_set>
 #include <vector>
 
+/**
+ * A structure representing a term found in a page, and the number of times it occurs.
+ */
+struct termMatch {
+    std::string term;
+    int occurrences;
+};
+
 /**
  * TermMatcher is used to determine if a certain number of unique terms exist within a vector of strings.
  */
@@ -43,10 +51,54 @@ class TermMatcher {
          */
         bool matchTerms(std::vector<std::string> data, bool caseSensitive);
 
+        /**
+         * Checks whether a number of unique terms exists within a vector of strings, and counts every unique term found.
+         * 
+         * Unlike the overload without a count, the search does not stop once the number of required terms is met.
+         * 
+         * @param[in] data the vector of strings to be checked.
+         * @param[in] caseSensitive whether case sensitivity applies.
+         * @param[out] uniqueTermsFound the number of unique terms found within the data.
+         * @returns true if the number of unique terms matched is greater than the number of required terms; returns false otherwise
+         * @returns true if terms list is empty
+         */
+        bool matchTerms(const std::vector<std::string>& data, bool caseSensitive, int* uniqueTermsFound);
+
+        /**
+         * Checks whether a number of unique terms exists within a vector of strings, and reports every term found
+         * with its number of occurrences, as evidence for the result.
+         * 
+         * @param[in] data the vector of strings to be checked.
+         * @param[in] caseSensitive whether case sensitivity applies.
+         * @param[out] matches a pointer to the vector every term found is appended to.
+         * @returns true if the number of unique terms matched is greater than the number of required terms; returns false otherwise
+         * @returns true if terms list is empty
+         */
+        bool matchTerms(const std::vector<std::string>& data, bool caseSensitive, std::vector<termMatch>* matches);
+
+        /**
+         * Gets the number of unique terms a page needs to be matched.
+         * 
+         * @return the number of required terms.
+         */
+        int getNumRequiredTerms();
+
     private:
 
         /**
-         * Extracts terms from "terms.txt".
+         * Counts the unique terms found within a vector of strings.
+         * 
+         * @param data the vector of strings to be checked.
+         * @param caseSensitive whether case sensitivity applies.
+         * @param[in] stopAt the count at which the search stops.
+         * @param[out] matches a pointer to the vector the terms found are appended to with their occurrences, or nullptr.
+         *      Counting occurrences reads past the first match of each term.
+         * @return the number of unique terms found, up to stopAt.
+         */
+        int countTerms(const std::vector<std::string>& data, bool caseSensitive, int stopAt, std::vector<termMatch>* matches);
+
+        /**
+         * Extracts terms from "terms.txt", one per line. Blank lines are skipped.
          * 
          * "terms.txt" must exist in the same directory as the executable.
          */
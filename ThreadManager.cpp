@@ -1,20 +1,40 @@
 #include "ThreadManager.h"
+#include "Checkpoint.h"
 #include "Crawler.h"
 #include "CurlThread.h"
+#include "DomainFilterSet.h"
+#include "DomainInternTable.h"
+#include "MetricsExporter.h"
+#include "MetricsRegistry.h"
+#include "PageTracer.h"
+#include "OutputFinalizer.h"
+#include "ProcessUsage.h"
 #include "SearcherThread.h"
+#include "TaskScheduler.h"
 #include "ThreadSafeQueue.h"
 #include "ThreadSafeSet.h"
+#include "VerdictCache.h"
+#include "WarcArchive.h"
 #include "CurlInteractionStructs.h"
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <queue>
 #include <string>
 #include <thread>
 #include <unordered_set>
+#include <vector>
 
 ThreadManager::ThreadManager(ThreadSafeQueue<std::string>* iQueue, std::unordered_set<std::string> eDomains) {
     const int defaultCrawlerMaxConnections = 500;
     const int defaultSearcherMaxConnections = 1000;
+    const std::string defaultCheckpointFile = "checkpoint.bin";
+    const int defaultCheckpointIntervalSeconds = 300;
+    const int defaultRunDurationSeconds = 0;
+    const std::string defaultRunReportFile = "run_report.json";
 
     config = Config();
 
@@ -35,69 +55,263 @@ ThreadManager::ThreadManager(ThreadSafeQueue<std::string>* iQueue, std::unordere
 
     killSwitch = 0;
 
-    // Create the crawler thread and crawler object
-    crawler = Crawler(crawlerCurlIO, iQueue, &killSwitch, &extractedDomains, excludedDomains, &config);
-    crawlerThread = std::thread(&Crawler::crawl, &crawler, &validator);
+    checkpointFile = config.getConfig("Checkpoint_File", defaultCheckpointFile);
+    checkpointInterval = std::chrono::seconds(config.getIntConfig("Checkpoint_IntervalSeconds", defaultCheckpointIntervalSeconds));
+    const std::chrono::seconds runDuration = std::chrono::seconds(config.getIntConfig("Run_DurationSeconds", defaultRunDurationSeconds));
 
-    // Create the searcher thread and searcher object
-    searcher = SearcherThread(searcherCurlIO, &killSwitch, &extractedDomains, &checkedDomains, &config);
-    searcherThread = std::thread(&SearcherThread::search, &searcher, &validator);    
+    // Create the crawler and searcher objects, and run their stages on the scheduler's workers
+    scheduler = new TaskScheduler(&killSwitch, &config);
+    domainTable = new DomainInternTable();
+    metrics = new MetricsRegistry();
+    metricsExporter = new MetricsExporter(&config, metrics);
+    tracer = new PageTracer(&config);
+    warcArchive = new WarcArchive(&config);
+    checkedDomains = new DomainFilterSet(&config, domainTable);
+    crawler = new Crawler(crawlerCurlIO, &killSwitch, &extractedDomains, checkedDomains, excludedDomains, &config, domainTable, metrics, tracer);
+    verdictCache = new VerdictCache(&config, domainTable);
+    searcher = new SearcherThread(searcherCurlIO, &killSwitch, &extractedDomains, checkedDomains, &config, domainTable, verdictCache, metrics, tracer);
+    bool stateRead = false;
+    const bool resumed = std::filesystem::exists(checkpointFile) && loadCheckpoint(&stateRead);
+    if(resumed)
+        std::cout << "Resumed From Checkpoint: " << checkpointFile << "\n";
+    // Domains read as checked are not checked again, so their output is kept even if the rest of the checkpoint is corrupt
+    searcher->openOutput(stateRead);
+    // A resumed frontier holds whatever is left of the initial sources, so they are only queued on a fresh crawl
+    if(!resumed)
+        crawler->queueInitialSources(iQueue);
+    crawler->addStages(scheduler, &validator);
+    searcher->addStages(scheduler, &validator);
+    scheduler->start();
+
+    // A checkpoint interval of 0 only checkpoints on exit
+    if(checkpointInterval.count() > 0)
+        checkpointThread = std::thread(&ThreadManager::checkpointLoop, this);
 
 
     // Create the crawler curl thread and curl object
-    crawlerCurl = CurlThread(crawlerCurlIO, &killSwitch, &config);
+    crawlerCurl = CurlThread(crawlerCurlIO, &killSwitch, &config, metrics, tracer, warcArchive);
     crawlerCurlThread = std::thread(&CurlThread::consumeUrls, &crawlerCurl);
 
 
     // Create the searcher curl thread and curl object
-    searcherCurl = CurlThread(searcherCurlIO, &killSwitch, &config);
+    searcherCurl = CurlThread(searcherCurlIO, &killSwitch, &config, metrics, tracer, warcArchive);
     searcherCurlThread = std::thread(&CurlThread::consumeUrls, &searcherCurl);
 
     std::thread verboseThread;
 
     std::atomic<bool> verbose;
 
-    // Wait for manual termination
-    char userInput;
-    do {
-        std::cout << "\n================== Silent Mode ===================\nEnter 'v' for verbose real-time updates.\nEnter 'e' to exit." << std::endl;
+    const std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+    metricsSnapshot runTotals;
+    processUsage runUsage;
+    double runSeconds = 0;
+
+    // A headless run stops once its duration has elapsed, rather than waiting for manual termination
+    if(runDuration.count() > 0) {
+        std::cout << "\n================== Headless Mode =================\nRunning for " << runDuration.count() << " seconds." << std::endl;
+        std::this_thread::sleep_for(runDuration);
+        // The totals are taken before shutting down, so the rates cover the run alone
+        metrics->collect(&runTotals);
+        ProcessUsage::read(&runUsage);
+        runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    } else {
+        // Wait for manual termination
+        char userInput;
+        do {
+            std::cout << "\n================== Silent Mode ===================\nEnter 'v' for verbose real-time updates.\nEnter 'e' to exit." << std::endl;
 
-        userInput = std::cin.get();
-        if(userInput == 'v') {
-            // Ignore the newline character from the 'v' submission
-            std::cin.get();
+            userInput = std::cin.get();
+            if(userInput == 'v') {
+                // Ignore the newline character from the 'v' submission
+                std::cin.get();
 
-            verbose.store(true);
-            verboseThread = std::thread(ThreadManager::verboseOutputThread, this, &verbose);
+                verbose.store(true);
+                verboseThread = std::thread(&ThreadManager::verboseOutputThread, this, &verbose);
 
-            do {} while(std::cin.get() != '\n');
+                do {} while(std::cin.get() != '\n');
             
-            verbose.store(false);
-            verboseThread.join();
-        }
-    } while(userInput != 'e');
+                verbose.store(false);
+                verboseThread.join();
+            }
+        } while(userInput != 'e');
+    }
 
     // Flip the killswitch
     killSwitch++;
 
     // Join all threads
-    crawlerThread.join();
+    scheduler->join();
+    if(checkpointThread.joinable())
+        checkpointThread.join();
+    // Transfers still in progress are saved as pending, so they are fetched again on resume
+    writeCheckpoint();
+    searcher->finish();
+    // The output file is complete, so the sorted list and the delta against the previous run can be written
+    OutputFinalizer(&config).finalize();
+    // The metrics file is written one last time, with the run's final totals
+    metricsExporter->close();
+    // The stages have stopped, so no page is traced after the trace file is terminated
+    tracer->close();
     crawlerCurlThread.join();
-
-    searcherThread.join();
     searcherCurlThread.join();
+    // The curl threads have stopped, so every response has been recorded
+    warcArchive->close();
+
+    if(runDuration.count() > 0) {
+        // Peak memory is read after shutdown, as finalizing the output can raise it
+        processUsage finalUsage;
+        if(ProcessUsage::read(&finalUsage))
+            runUsage.peakResidentBytes = finalUsage.peakResidentBytes;
+        writeRunReport(config.getConfig("Run_ReportFile", defaultRunReportFile), runTotals, runSeconds, runUsage);
+    }
+}
+
+void ThreadManager::writeRunReport(const std::string& reportFile, const metricsSnapshot& totals, double seconds, const processUsage& usage) {
+    const double bytesPerMebibyte = 1024.0 * 1024.0;
+
+    const std::uint64_t crawlerPages = totals.counters[MetricsRegistry::crawlerPagesCounter];
+    const std::uint64_t searcherPages = totals.counters[MetricsRegistry::searcherPagesCounter];
+    const std::uint64_t verifiedDomains = totals.counters[MetricsRegistry::domainsVerifiedCounter];
+    const double cpuSeconds = usage.userCpuSeconds + usage.systemCpuSeconds;
+
+    std::string report = "{\n";
+    report += "  \"durationSeconds\": " + std::to_string(seconds) + ",\n";
+    report += "  \"crawlerPages\": " + std::to_string(crawlerPages) + ",\n";
+    report += "  \"crawlerFailures\": " + std::to_string(totals.counters[MetricsRegistry::crawlerFailuresCounter]) + ",\n";
+    report += "  \"searcherPages\": " + std::to_string(searcherPages) + ",\n";
+    report += "  \"searcherFailures\": " + std::to_string(totals.counters[MetricsRegistry::searcherFailuresCounter]) + ",\n";
+    report += "  \"bytesFetched\": " + std::to_string(totals.counters[MetricsRegistry::bytesFetchedCounter]) + ",\n";
+    report += "  \"domainsExtracted\": " + std::to_string(totals.counters[MetricsRegistry::domainsExtractedCounter]) + ",\n";
+    report += "  \"domainsVerified\": " + std::to_string(verifiedDomains) + ",\n";
+    report += "  \"pagesPerSecond\": " + std::to_string((crawlerPages + searcherPages) / seconds) + ",\n";
+    report += "  \"crawlerPagesPerSecond\": " + std::to_string(crawlerPages / seconds) + ",\n";
+    report += "  \"searcherPagesPerSecond\": " + std::to_string(searcherPages / seconds) + ",\n";
+    report += "  \"domainsVerifiedPerSecond\": " + std::to_string(verifiedDomains / seconds) + ",\n";
+    report += "  \"peakResidentBytes\": " + std::to_string(usage.peakResidentBytes) + ",\n";
+    report += "  \"userCpuSeconds\": " + std::to_string(usage.userCpuSeconds) + ",\n";
+    report += "  \"systemCpuSeconds\": " + std::to_string(usage.systemCpuSeconds) + ",\n";
+    report += "  \"cpuUtilization\": " + std::to_string(cpuSeconds / seconds) + "\n";
+    report += "}\n";
+
+    std::cout << "\nPages: " << crawlerPages + searcherPages << " (" << (long)((crawlerPages + searcherPages) / seconds) << "/s)"
+              << " - Verified: " << verifiedDomains << " (" << verifiedDomains / seconds << "/s)"
+              << " - Peak RSS: " << (long)(usage.peakResidentBytes / bytesPerMebibyte) << " MiB"
+              << " - CPU: " << cpuSeconds << "s (" << (long)(cpuSeconds / seconds * 100) << "%)" << std::endl;
+
+    std::ofstream file(reportFile, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    if(!file.is_open() || !file.write(report.data(), report.size()))
+        std::cout << "ERROR: Could Not Write Run Report: " << reportFile << "\n";
 }
 
 void ThreadManager::verboseOutputThread(std::atomic<bool>* verbose) {
     std::cout << "\n================== Verbose Mode ==================\nHit 'Enter' to return to silent mode.\n\n";
-    // This prints about 30 frames per second
-    const std::chrono::milliseconds outputRefreshRate = std::chrono::milliseconds(50);
+    // The verbose flag is checked often, so returning to silent mode is not held up by the refresh rate
+    const std::chrono::milliseconds verbosePollRate = std::chrono::milliseconds(50);
+    // Rates and latencies are measured over one refresh
+    const std::chrono::seconds outputRefreshRate = std::chrono::seconds(1);
+    const std::uint64_t microsecondsPerMillisecond = 1000;
+
+    metricsSnapshot previous;
+    metricsSnapshot current;
+    metricsSnapshot window;
+    metrics->collect(&previous);
+    std::chrono::steady_clock::time_point windowStart = std::chrono::steady_clock::now();
     while(verbose->load() == true) {
-        std::cout << "\rCrawler - Queued Sites: " << crawlerCurlIO.urls->size() 
-                  << " - Processing: " << crawlerCurlIO.output->size()
-                  << " | Validator - Queued Sites: " << searcherCurlIO.urls->size()
-                  << " - Processing: " << searcherCurlIO.output->size()
-                  << "    ";
-        std::this_thread::sleep_for(outputRefreshRate);
+        std::this_thread::sleep_for(verbosePollRate);
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if(now - windowStart < outputRefreshRate)
+            continue;
+
+        metrics->collect(&current);
+        MetricsRegistry::difference(current, previous, &window);
+        const double elapsedSeconds = std::chrono::duration<double>(now - windowStart).count();
+        const long crawledPerSecond = (long)(window.counters[MetricsRegistry::crawlerPagesCounter] / elapsedSeconds);
+        const long checkedPerSecond = (long)((window.counters[MetricsRegistry::searcherPagesCounter] + window.counters[MetricsRegistry::searcherFailuresCounter]) / elapsedSeconds);
+        const long failedPerSecond = (long)(window.counters[MetricsRegistry::searcherFailuresCounter] / elapsedSeconds);
+        const long verifiedPerSecond = (long)(window.counters[MetricsRegistry::domainsVerifiedCounter] / elapsedSeconds);
+        std::cout << "\rCrawler - Pages: " << current.counters[MetricsRegistry::crawlerPagesCounter]
+                  << " (" << crawledPerSecond << "/s)"
+                  << " - Fetch p50/p99: " << MetricsRegistry::quantile(window, MetricsRegistry::crawlerFetchLatencyHistogram, 0.5) / microsecondsPerMillisecond
+                  << "/" << MetricsRegistry::quantile(window, MetricsRegistry::crawlerFetchLatencyHistogram, 0.99) / microsecondsPerMillisecond << "ms"
+                  << " | Validator - Checked: " << current.counters[MetricsRegistry::searcherPagesCounter] + current.counters[MetricsRegistry::searcherFailuresCounter]
+                  << " (" << checkedPerSecond << "/s, " << failedPerSecond << "/s failed)"
+                  << " - Fetch p50/p99: " << MetricsRegistry::quantile(window, MetricsRegistry::searcherFetchLatencyHistogram, 0.5) / microsecondsPerMillisecond
+                  << "/" << MetricsRegistry::quantile(window, MetricsRegistry::searcherFetchLatencyHistogram, 0.99) / microsecondsPerMillisecond << "ms"
+                  << " - Verified: " << searcher->getVerifiedDomainCount()
+                  << " (" << verifiedPerSecond << "/s)"
+                  << " - Cached: " << current.counters[MetricsRegistry::cachedVerdictsCounter]
+                  << "    " << std::flush;
+        // Every metric in the current snapshot is overwritten by the next collect
+        std::swap(previous, current);
+        windowStart = now;
+    }
+}
+
+void ThreadManager::checkpointLoop() {
+    // The kill switch is checked often, so exiting is not held up by the interval
+    const std::chrono::milliseconds killSwitchPollRate = std::chrono::milliseconds(100);
+
+    std::chrono::steady_clock::time_point lastCheckpoint = std::chrono::steady_clock::now();
+    while(killSwitch.load() == 0) {
+        std::this_thread::sleep_for(killSwitchPollRate);
+        if(std::chrono::steady_clock::now() - lastCheckpoint >= checkpointInterval) {
+            writeCheckpoint();
+            lastCheckpoint = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+bool ThreadManager::writeCheckpoint() {
+    const std::string checkpointMagic = "CRYPTOCENSUS-CHECKPOINT";
+    const std::uint64_t checkpointVersion = 5;
+
+    CheckpointWriter writer(checkpointFile);
+    writer.writeString(checkpointMagic);
+    writer.writeUint(checkpointVersion);
+
+    // The state is copied into memory while the stages are paused, then written to disk once they have resumed
+    writer.holdWrites();
+    scheduler->pause();
+    crawler->saveState(&writer);
+    searcher->saveState(&writer);
+    scheduler->resume();
+    writer.releaseWrites();
+
+    // The checkpoint refers to the spilled URLs where they are on disk, so they must reach the disk before it is committed
+    bool written = crawler->syncSpilledUrls();
+    if(!written)
+        std::cout << "ERROR: Could Not Sync Spilled URLs, Checkpoint Not Written: " << checkpointFile << "\n";
+
+    // Syncing after the resume flushes domains verified since the pause too, which is harmless
+    if(written && !searcher->syncOutput()) {
+        std::cout << "ERROR: Could Not Sync Output, Checkpoint Not Written: " << checkpointFile << "\n";
+        written = false;
+    }
+
+    // The verdict cache is written on its own, as it outlives the crawl
+    if(!verdictCache->save())
+        std::cout << "ERROR: Could Not Write Verdict Cache\n";
+    written = written && writer.commit();
+    // The spilled URLs of whichever checkpoint is now on disk are kept
+    crawler->finishCheckpoint(written);
+    return written;
+}
+
+bool ThreadManager::loadCheckpoint(bool* stateRead) {
+    const std::string checkpointMagic = "CRYPTOCENSUS-CHECKPOINT";
+    const std::uint64_t checkpointVersion = 5;
+
+    CheckpointReader reader(checkpointFile);
+    std::string magic;
+    std::uint64_t version;
+    if(!reader.isOpen() || !reader.readString(&magic) || magic != checkpointMagic || !reader.readUint(&version) || version != checkpointVersion) {
+        std::cout << "ERROR: Invalid Checkpoint: " << checkpointFile << "\n";
+        return false;
+    }
+    *stateRead = true;
+    if(!crawler->loadState(&reader) || !searcher->loadState(&reader)) {
+        std::cout << "ERROR: Checkpoint Is Corrupt, Resuming From The State Read Before The Error: " << checkpointFile << "\n";
+        return false;
     }
+    return true;
 }
\ No newline at end of file
@@ -1,18 +1,32 @@
 #ifndef THREADMANAGER_H
 #define THREADMANAGER_H
 
+#include "Checkpoint.h"
 #include "Crawler.h"
 #include "CurlThread.h"
+#include "DomainFilterSet.h"
+#include "DomainInternTable.h"
+#include "MetricsExporter.h"
+#include "MetricsRegistry.h"
+#include "PageTracer.h"
+#include "OutputFinalizer.h"
+#include "ProcessUsage.h"
 #include "SearcherThread.h"
+#include "TaskScheduler.h"
 #include "ThreadSafeQueue.h"
 #include "ThreadSafeSet.h"
+#include "VerdictCache.h"
+#include "WarcArchive.h"
 #include "CurlInteractionStructs.h"
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <queue>
 #include <string>
 #include <thread>
 #include <unordered_set>
+#include <vector>
 
 class ThreadManager {
     public:
@@ -23,6 +37,12 @@ class ThreadManager {
          * The construction of this object automatically initiates the crawling and searching process.
          * This process manages all threads and waits for the user to submit a '\n' input before exiting.
          * 
+         * If Run_DurationSeconds is set, the run is headless: no input is read, the run stops once the duration has elapsed,
+         * and a report of its throughput and resource usage is written to Run_ReportFile.
+         * 
+         * If a checkpoint exists, the crawl resumes from it, and the initial sources are not queued again. A checkpoint
+         * is written periodically, and on exit, along with the verdict cache. On exit, the output file is finalized into a sorted list and a delta file.
+         * 
          * @param iQueue the initial crawler queue.
          * @param eDomains the domains excluded from both the crawler and the searcher.
          */
@@ -38,33 +58,91 @@ class ThreadManager {
         std::thread crawlerCurlThread;
         ThreadSafeQueue<std::string> crawlerInitialQueue;
 
-        std::thread crawlerThread;
-        Crawler crawler;
+        Crawler* crawler;
 
         curlIO searcherCurlIO;
         CurlThread searcherCurl;
         std::thread searcherCurlThread;
 
-        SearcherThread searcher;
-        std::thread searcherThread;
-        ThreadSafeQueue<std::string> extractedDomains;
+        SearcherThread* searcher;
+        // The domains extracted by the crawler, waiting for the searcher
+        ThreadSafeQueue<extractedDomain> extractedDomains;
+
+        DomainFilterSet* checkedDomains;
 
-        ThreadSafeSet<std::string> checkedDomains;
+        // Interns the domains and hosts the crawler and searcher queue, so they pass ids rather than strings
+        DomainInternTable* domainTable;
+
+        // The searcher's verdicts, kept across runs
+        VerdictCache* verdictCache;
+
+        // The counters and histograms every stage updates
+        MetricsRegistry* metrics;
+        // Publishes the metrics for unattended runs
+        MetricsExporter* metricsExporter;
+        // Writes the timelines of sampled pages
+        PageTracer* tracer;
+        // Records fetched responses, or replays them in place of the network
+        WarcArchive* warcArchive;
 
         std::unordered_set<std::string> searchTerms;
         std::unordered_set<std::string> excludedDomains;
         
+        // Runs the crawler's and the searcher's stages. The curl threads stay dedicated, as they block on the network
+        TaskScheduler* scheduler;
+
         std::atomic<int> killSwitch;
 
+        std::string checkpointFile;
+        std::chrono::seconds checkpointInterval;
+        std::thread checkpointThread;
+
         /**
          * verboseOutputThread contains logic for verbose output.
          * 
-         * This output prints the input and output queues for the crawler's CURL thread and 
-         * the searcher's CURL thread. The output is written every 100ms until the kill switch is thrown. 
+         * This output prints the rates at which the crawler and the searcher fetch pages, their fetch latencies, and
+         * the number of verified domains and the rate they are verified at. Everything is read from the metrics
+         * registry, so no queue is locked. The output is written every second until the kill switch is thrown, and
+         * the rates and latencies cover the second since the previous output.
          * 
          * @param verbose the killswitch for verbose output 
          */
         void verboseOutputThread(std::atomic<bool>* verbose);
+
+        /**
+         * Writes the report of a headless run, and prints a summary of it.
+         * 
+         * @param reportFile the file the report is written to, as JSON.
+         * @param totals the metrics at the end of the run.
+         * @param seconds the duration of the run.
+         * @param usage the resources the process used during the run.
+         */
+        void writeRunReport(const std::string& reportFile, const metricsSnapshot& totals, double seconds, const processUsage& usage);
+
+        /**
+         * checkpointLoop writes a checkpoint every checkpoint interval until the kill switch is thrown.
+         */
+        void checkpointLoop();
+
+        /**
+         * Writes the crawler's and the searcher's state to the checkpoint file.
+         * 
+         * The scheduler's stages are paused while the state is copied into memory, so the checkpoint is consistent, and
+         * resumed before it is written to disk. URLs spilled by the crawl frontier are not copied: the checkpoint refers
+         * to where they are on disk, and their segment files and the output files are synced before the checkpoint is
+         * committed. If any of them can't be synced, the previous checkpoint is kept.
+         * 
+         * @return true if the checkpoint was written, false otherwise.
+         */
+        bool writeCheckpoint();
+
+        /**
+         * Loads the crawler's and the searcher's state from the checkpoint file.
+         * 
+         * @param[out] stateRead whether any state was read, which is the case even if the checkpoint turns out to be corrupt.
+         * @return true if the checkpoint was loaded whole, false otherwise.
+         */
+        bool loadCheckpoint(bool* stateRead);
 };
 
 #endif
\ No newline at end of file
@@ -1,12 +1,13 @@
 #ifndef THREADSAFEQUEUE_H
 #define THREADSAFEQUEUE_H
 
+#include <functional>
 #include <mutex>
-#include <queue>
+#include <deque>
 #include <thread>
 
 /**
- * ThreadSafeQueue is a warpper around the std::queue class. This wrapper adds a mutex to make it thread safe
+ * ThreadSafeQueue is a warpper around a std::deque used as a queue. This wrapper adds a mutex to make it thread safe
  * 
  * This class is functionally the same as std::queue, except the pop() function both removes the first element of the queue, and returns that element
  * 
@@ -79,6 +80,14 @@ class ThreadSafeQueue {
          */
         int size();
 
+        /**
+         * Calls a function on every element of the queue, front to back, while holding the queue's lock.
+         * 
+         * @tparam C the type of data the queue stores.
+         * @param visit the function to call. The function must not use the queue.
+         */
+        void forEach(const std::function<void(const C&)>& visit);
+
         /**
          * Thread safe wrapper around queue's copy constructor.
          * 
@@ -88,7 +97,7 @@ class ThreadSafeQueue {
         ThreadSafeQueue<C>& operator=(const ThreadSafeQueue<C>& copy);
         
     private:
-        std::queue<C> queue;
+        std::deque<C> queue;
         std::mutex mu;
         std::chrono::milliseconds sleepLockMilliseconds;
 };
@@ -116,7 +125,7 @@ inline C ThreadSafeQueue<C>::safePop() {
     C temp;
     if(!queue.empty()) {
         temp = queue.front();
-        queue.pop();
+        queue.pop_front();
     }
     return temp;
 }
@@ -130,7 +139,7 @@ inline bool ThreadSafeQueue<C>::safePop(C* output) {
     }
     if(!queue.empty()) {
         *output = queue.front();
-        queue.pop();
+        queue.pop_front();
         return true;
     }
     return false;
@@ -143,7 +152,7 @@ inline void ThreadSafeQueue<C>::push(C data) {
         std::this_thread::sleep_for(sleepLockMilliseconds);
         lock.try_lock();
     }
-    queue.push(data);
+    queue.push_back(data);
 }
 
 
@@ -169,21 +178,25 @@ inline int ThreadSafeQueue<C>::size() {
     return temp;
 }
 
-template<class C>
-inline ThreadSafeQueue<C>& ThreadSafeQueue<C>::operator=(const ThreadSafeQueue<C>& copy) {
+template <class C>
+inline void ThreadSafeQueue<C>::forEach(const std::function<void(const C&)>& visit) {
     std::unique_lock<std::mutex> lock(mu, std::try_to_lock);
     while(!lock.owns_lock()) {
         std::this_thread::sleep_for(sleepLockMilliseconds);
         lock.try_lock();
     }
-    std::queue<C> empty;
-    std::swap(queue, empty);
-    std::queue<C> temp = copy.queue;
+    for(const C& element : queue)
+        visit(element);
+}
 
-    while(temp.front) {
-        queue.insert(temp.front());
-        temp.pop();
+template<class C>
+inline ThreadSafeQueue<C>& ThreadSafeQueue<C>::operator=(const ThreadSafeQueue<C>& copy) {
+    std::unique_lock<std::mutex> lock(mu, std::try_to_lock);
+    while(!lock.owns_lock()) {
+        std::this_thread::sleep_for(sleepLockMilliseconds);
+        lock.try_lock();
     }
+    queue = copy.queue;
     return *this;
 }
 
@@ -1,6 +1,7 @@
 #ifndef THREADSAFESET_H
 #define THREADSAFESET_H
 
+#include <functional>
 #include <mutex>
 #include <thread>
 #include <unordered_set>
@@ -50,6 +51,22 @@ class ThreadSafeSet {
          */
         bool safeInsert(C data);
 
+        /**
+         * Thread safe wrapper around unordered_set.size().
+         * 
+         * @tparam C the type of data the set stores.
+         * @return the size of the set.
+         */
+        int size();
+
+        /**
+         * Calls a function on every element of the set while holding the set's lock.
+         * 
+         * @tparam C the type of data the set stores.
+         * @param visit the function to call. The function must not use the set.
+         */
+        void forEach(const std::function<void(const C&)>& visit);
+
         /**
          * Thread safe wrapper around set's copy constructor.
          * 
@@ -101,6 +118,28 @@ inline bool ThreadSafeSet<C>::safeInsert(C data) {
     return temp;
 }
 
+template<class C>
+inline int ThreadSafeSet<C>::size() {
+    std::unique_lock<std::mutex> lock(mu, std::try_to_lock);
+    while(!lock.owns_lock()) {
+        std::this_thread::sleep_for(sleepLockMilliseconds);
+        lock.try_lock();
+    }
+    int temp = set.size();
+    return temp;
+}
+
+template<class C>
+inline void ThreadSafeSet<C>::forEach(const std::function<void(const C&)>& visit) {
+    std::unique_lock<std::mutex> lock(mu, std::try_to_lock);
+    while(!lock.owns_lock()) {
+        std::this_thread::sleep_for(sleepLockMilliseconds);
+        lock.try_lock();
+    }
+    for(const C& element : set)
+        visit(element);
+}
+
 template<class C>
 inline ThreadSafeSet<C>& ThreadSafeSet<C>::operator=(const ThreadSafeSet<C>& copy) {
     std::unique_lock<std::mutex> lock(mu, std::try_to_lock);
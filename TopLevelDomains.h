@@ -0,0 +1,24 @@
+#ifndef TOPLEVELDOMAINS_H
+#define TOPLEVELDOMAINS_H
+
+#include <string_view>
+
+/**
+ * A lookup table of the IANA top level domains.
+ * 
+ * The table is a perfect hash built at compile time, so it costs nothing at startup and answers each
+ * lookup with a single hash and at most one string comparison.
+ */
+class TopLevelDomains {
+    public:
+
+        /**
+         * Checks whether a string is a top level domain, ignoring ASCII case.
+         * 
+         * @param topLevelDomain the string to check, without a leading dot.
+         * @return true if the string is a top level domain, false otherwise.
+         */
+        static bool contains(std::string_view topLevelDomain);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,320 @@
+#include "Url.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Checks whether a character is an unreserved URL character. See https://www.rfc-editor.org/rfc/rfc3986#section-2.3
+ * 
+ * @param c the character to check.
+ * @return true if the character is a letter, digit, `-`, `.`, `_` or `~`.
+ */
+static bool isUnreserved(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+/**
+ * Gets the value of a hex digit.
+ * 
+ * @param c the hex digit.
+ * @return the value of the digit, or -1 if the character is not a hex digit.
+ */
+static int hexValue(char c) {
+    if(c >= '0' && c <= '9')
+        return c - '0';
+    if(c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * Appends a byte to a string as a percent-encoding, using upper case hex digits.
+ * 
+ * @param c the byte to encode.
+ * @param[out] output the string to append to.
+ */
+static void appendPercentEncoded(unsigned char c, std::string* output) {
+    const char hexDigits[] = "0123456789ABCDEF";
+    *output += '%';
+    *output += hexDigits[c >> 4];
+    *output += hexDigits[c & 0xF];
+}
+
+/**
+ * Normalizes the percent-encoding of a path or query.
+ * 
+ * Encoded unreserved characters are decoded, other encodings are upper cased, and characters which may not
+ * appear in a path or query are encoded.
+ * 
+ * @param component the path or query to normalize.
+ * @param[out] output the string to append the normalized component to.
+ */
+static void appendNormalizedComponent(std::string_view component, std::string* output) {
+    const std::string_view allowedCharacters = "!$&'()*+,;=:@/?";
+    for(std::size_t i = 0; i < component.size(); i++) {
+        const unsigned char c = (unsigned char)component[i];
+        if(c == '%') {
+            const int high = i + 2 < component.size() ? hexValue(component[i + 1]) : -1;
+            const int low = i + 2 < component.size() ? hexValue(component[i + 2]) : -1;
+            if(high < 0 || low < 0) {
+                // A stray `%` is encoded itself
+                appendPercentEncoded(c, output);
+                continue;
+            }
+            const unsigned char decoded = (unsigned char)(high * 16 + low);
+            if(isUnreserved(decoded))
+                *output += (char)decoded;
+            else
+                appendPercentEncoded(decoded, output);
+            i += 2;
+        } else if(isUnreserved(c) || allowedCharacters.find((char)c) != std::string_view::npos)
+            *output += (char)c;
+        else
+            appendPercentEncoded(c, output);
+    }
+}
+
+/**
+ * Removes the whitespace browsers ignore in links: leading and trailing control characters and spaces, and
+ * every tab and line break.
+ * 
+ * @param text the text to clean.
+ * @return the cleaned text.
+ */
+static std::string stripIgnoredWhitespace(std::string_view text) {
+    std::size_t start = 0;
+    std::size_t end = text.size();
+    while(start < end && (unsigned char)text[start] <= ' ')
+        start++;
+    while(end > start && (unsigned char)text[end - 1] <= ' ')
+        end--;
+
+    std::string cleaned;
+    cleaned.reserve(end - start);
+    for(std::size_t i = start; i < end; i++) {
+        if(text[i] != '\t' && text[i] != '\n' && text[i] != '\r')
+            cleaned += text[i];
+    }
+    return cleaned;
+}
+
+/**
+ * Finds the scheme of a URL. See https://www.rfc-editor.org/rfc/rfc3986#section-3.1
+ * 
+ * @param text the URL.
+ * @return the index of the `:` ending the scheme, or npos if the URL has no scheme.
+ */
+static std::size_t findSchemeEnd(std::string_view text) {
+    if(text.empty() || !((text[0] >= 'a' && text[0] <= 'z') || (text[0] >= 'A' && text[0] <= 'Z')))
+        return std::string_view::npos;
+    for(std::size_t i = 1; i < text.size(); i++) {
+        const char c = text[i];
+        if(c == ':')
+            return i;
+        if(!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '+' || c == '-' || c == '.'))
+            return std::string_view::npos;
+    }
+    return std::string_view::npos;
+}
+
+bool Url::parse(std::string_view text) {
+    const std::string cleaned = stripIgnoredWhitespace(text);
+    const std::string_view url = cleaned;
+
+    const std::size_t schemeEnd = findSchemeEnd(url);
+    if(schemeEnd == std::string_view::npos)
+        return false;
+    scheme.clear();
+    for(char c : url.substr(0, schemeEnd))
+        scheme += (char)tolower(c);
+    if(scheme != "http" && scheme != "https")
+        return false;
+
+    // Browsers accept backslashes in place of slashes in http URLs
+    std::size_t authorityStart = schemeEnd + 1;
+    if(url.size() < authorityStart + 2 || (url[authorityStart] != '/' && url[authorityStart] != '\\') || (url[authorityStart + 1] != '/' && url[authorityStart + 1] != '\\'))
+        return false;
+    authorityStart += 2;
+
+    std::size_t authorityEnd = url.find_first_of("/\\?#", authorityStart);
+    if(authorityEnd == std::string_view::npos)
+        authorityEnd = url.size();
+    if(!setAuthority(url.substr(authorityStart, authorityEnd - authorityStart)))
+        return false;
+
+    std::string_view rest = url.substr(authorityEnd);
+    rest = rest.substr(0, rest.find('#'));
+    const std::size_t queryStart = rest.find('?');
+    setPath(rest.substr(0, queryStart));
+    hasQuery = queryStart != std::string_view::npos;
+    query.clear();
+    if(hasQuery)
+        setQuery(rest.substr(queryStart + 1));
+    return true;
+}
+
+bool Url::resolve(std::string_view reference, Url* output) const {
+    const std::string cleaned = stripIgnoredWhitespace(reference);
+    std::string_view ref = cleaned;
+
+    // References with a scheme are absolute
+    if(findSchemeEnd(ref) != std::string_view::npos)
+        return output->parse(ref);
+    // Network-path references keep only the scheme
+    if(ref.size() >= 2 && (ref[0] == '/' || ref[0] == '\\') && (ref[1] == '/' || ref[1] == '\\'))
+        return output->parse(scheme + ":" + cleaned);
+
+    ref = ref.substr(0, ref.find('#'));
+    const std::size_t queryStart = ref.find('?');
+    const std::string_view refPath = ref.substr(0, queryStart);
+
+    *output = *this;
+    if(refPath.empty()) {
+        output->path = path;
+    } else if(refPath[0] == '/' || refPath[0] == '\\')
+        output->setPath(refPath);
+    else {
+        // Merge the reference with everything up to the last segment of this URL's path
+        std::string merged = path.substr(0, path.rfind('/') + 1);
+        merged += refPath;
+        output->setPath(merged);
+    }
+
+    if(queryStart != std::string_view::npos) {
+        output->hasQuery = true;
+        output->query.clear();
+        output->setQuery(ref.substr(queryStart + 1));
+    } else if(!refPath.empty()) {
+        output->hasQuery = false;
+        output->query.clear();
+    }
+    return true;
+}
+
+std::string Url::toString() const {
+    std::string url = scheme + "://" + host;
+    if(!port.empty())
+        url += ":" + port;
+    url += path;
+    if(hasQuery)
+        url += "?" + query;
+    return url;
+}
+
+std::string Url::getDedupKey() const {
+    std::string key = host;
+    if(!port.empty())
+        key += ":" + port;
+    if(path.size() > 1 && path.back() == '/')
+        key.append(path, 0, path.size() - 1);
+    else if(path != "/")
+        key += path;
+    if(hasQuery)
+        key += "?" + query;
+    return key;
+}
+
+const std::string& Url::getHost() const {
+    return host;
+}
+
+bool Url::setAuthority(std::string_view authority) {
+    const int maxPort = 65535;
+
+    // User information is dropped
+    const std::size_t userInfoEnd = authority.rfind('@');
+    if(userInfoEnd != std::string_view::npos)
+        authority = authority.substr(userInfoEnd + 1);
+
+    std::size_t hostEnd;
+    if(!authority.empty() && authority[0] == '[') {
+        hostEnd = authority.find(']');
+        if(hostEnd == std::string_view::npos)
+            return false;
+        hostEnd++;
+    } else
+        hostEnd = authority.find(':');
+    if(hostEnd == std::string_view::npos)
+        hostEnd = authority.size();
+
+    host.clear();
+    for(char c : authority.substr(0, hostEnd)) {
+        const unsigned char u = (unsigned char)c;
+        // Hosts may only hold labels, dots, and IPv6 literals. Non-ASCII bytes are left for curl to handle
+        if(!(isUnreserved(u) || u >= 0x80 || c == '[' || c == ']' || (c == ':' && authority[0] == '[')))
+            return false;
+        host += (char)tolower(c);
+    }
+    while(!host.empty() && host.back() == '.')
+        host.pop_back();
+    if(host.empty())
+        return false;
+
+    port.clear();
+    if(hostEnd < authority.size()) {
+        if(authority[hostEnd] != ':')
+            return false;
+        std::string_view portText = authority.substr(hostEnd + 1);
+        int portValue = 0;
+        for(char c : portText) {
+            if(c < '0' || c > '9')
+                return false;
+            portValue = portValue * 10 + (c - '0');
+            if(portValue > maxPort)
+                return false;
+        }
+        // An empty or default port is dropped
+        if(!portText.empty() && !((scheme == "http" && portValue == 80) || (scheme == "https" && portValue == 443)))
+            port = std::to_string(portValue);
+    }
+    return true;
+}
+
+void Url::setPath(std::string_view rawPath) {
+    // Backslashes are replaced before normalizing, which would otherwise encode them
+    std::string slashed(rawPath);
+    for(char& c : slashed) {
+        if(c == '\\')
+            c = '/';
+    }
+    std::string normalized;
+    appendNormalizedComponent(slashed, &normalized);
+
+    // Remove dot segments. See https://www.rfc-editor.org/rfc/rfc3986#section-5.2.4
+    std::vector<std::string_view> segments;
+    std::string_view remaining = normalized;
+    if(!remaining.empty() && remaining[0] == '/')
+        remaining.remove_prefix(1);
+    bool endsWithDirectory = false;
+    while(true) {
+        const std::size_t segmentEnd = remaining.find('/');
+        const std::string_view segment = remaining.substr(0, segmentEnd);
+        endsWithDirectory = false;
+        if(segment == "..") {
+            if(!segments.empty())
+                segments.pop_back();
+            endsWithDirectory = true;
+        } else if(segment == ".")
+            endsWithDirectory = true;
+        else
+            segments.push_back(segment);
+        if(segmentEnd == std::string_view::npos)
+            break;
+        remaining.remove_prefix(segmentEnd + 1);
+    }
+
+    path = "/";
+    for(std::size_t i = 0; i < segments.size(); i++) {
+        if(i > 0)
+            path += '/';
+        path += segments[i];
+    }
+    if(endsWithDirectory && path.back() != '/')
+        path += '/';
+}
+
+void Url::setQuery(std::string_view rawQuery) {
+    appendNormalizedComponent(rawQuery, &query);
+}
\ No newline at end of file
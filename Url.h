@@ -0,0 +1,95 @@
+#ifndef URL_H
+#define URL_H
+
+#include <string>
+#include <string_view>
+
+/**
+ * Url is a parsed and normalized http or https URL.
+ * 
+ * Parsing normalizes the URL so that equivalent URLs compare equal:
+ *      The scheme and host are lowercased, and a trailing dot is removed from the host.
+ *      Default ports (80 for http, 443 for https) are removed.
+ *      Dot segments are removed from the path, and an empty path becomes "/".
+ *      Percent-encodings use upper case hex digits, encoded unreserved characters are decoded, and characters
+ *      which may not appear in a URL are encoded.
+ *      User information and fragments are removed.
+ */
+class Url {
+    public:
+
+        // Default constructor.
+        Url() = default;
+
+        /**
+         * Parses an absolute URL.
+         * 
+         * @param text the URL to parse.
+         * @return true if the URL is a valid http or https URL, false otherwise.
+         */
+        bool parse(std::string_view text);
+
+        /**
+         * Resolves a reference, such as an A HREF link, against this URL. See https://www.rfc-editor.org/rfc/rfc3986#section-5.2
+         * 
+         * @param[in] reference the absolute or relative reference to resolve.
+         * @param[out] output the resolved URL.
+         * @return true if the reference resolves to a valid http or https URL, false otherwise.
+         */
+        bool resolve(std::string_view reference, Url* output) const;
+
+        /**
+         * Gets the normalized URL.
+         * 
+         * @return the URL as a string.
+         */
+        std::string toString() const;
+
+        /**
+         * Gets the key used to deduplicate URLs.
+         * 
+         * The key leaves out the scheme, as http pages redirect to https, and leaves out a trailing slash.
+         * 
+         * @return the host, non-default port, path and query of the URL.
+         */
+        std::string getDedupKey() const;
+
+        /**
+         * Gets the URL's host.
+         * 
+         * @return the lowercase host.
+         */
+        const std::string& getHost() const;
+
+    private:
+        std::string scheme;
+        std::string host;
+        std::string port;
+        std::string path;
+        std::string query;
+        bool hasQuery = false;
+
+        /**
+         * Parses and normalizes an authority, the user information, host and port of a URL.
+         * 
+         * @param authority the authority to parse.
+         * @return true if the authority holds a valid host and port, false otherwise.
+         */
+        bool setAuthority(std::string_view authority);
+
+        /**
+         * Normalizes and sets the path, removing dot segments.
+         * 
+         * @param rawPath the path to set.
+         */
+        void setPath(std::string_view rawPath);
+
+        /**
+         * Normalizes and sets the query.
+         * 
+         * @param rawQuery the query to set, without the leading `?`.
+         */
+        void setQuery(std::string_view rawQuery);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "VerdictCache.h"
+#include "Checkpoint.h"
+#include "Config.h"
+#include "DomainInternTable.h"
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+VerdictCache::VerdictCache(Config* config, DomainInternTable* dTable) {
+    const std::string defaultCacheFile = "verdicts.bin";
+    const int defaultCryptoTtlHours = 720;
+    const int defaultNonCryptoTtlHours = 168;
+    const int defaultUnreachableTtlHours = 24;
+    const std::int64_t secondsPerHour = 3600;
+    // Keeps a verdict's time to live in range of the packed time
+    const int maxTtlHours = 1000000;
+
+    domainTable = dTable;
+    cacheFile = config->getConfig("VerdictCache_File", defaultCacheFile);
+    ttlSeconds[cryptoVerdict] = config->getIntConfig("VerdictCache_CryptoTtlHours", defaultCryptoTtlHours, 0, maxTtlHours) * secondsPerHour;
+    ttlSeconds[nonCryptoVerdict] = config->getIntConfig("VerdictCache_NonCryptoTtlHours", defaultNonCryptoTtlHours, 0, maxTtlHours) * secondsPerHour;
+    ttlSeconds[unreachableVerdict] = config->getIntConfig("VerdictCache_UnreachableTtlHours", defaultUnreachableTtlHours, 0, maxTtlHours) * secondsPerHour;
+
+    if(std::filesystem::exists(cacheFile))
+        load();
+}
+
+bool VerdictCache::lookup(std::uint32_t domainId, verdict* cached) {
+    std::lock_guard<std::mutex> lock(mu);
+    std::unordered_map<std::uint32_t, std::uint64_t>::iterator it = verdicts.find(domainId);
+    if(it == verdicts.end() || isExpired(it->second, currentTime()))
+        return false;
+    *cached = (verdict)(it->second & ((1 << VERDICT_BITS) - 1));
+    return true;
+}
+
+void VerdictCache::record(std::uint32_t domainId, verdict reached) {
+    // Verdicts which are not cached are not stored, so they are fetched again on the next run
+    if(domainId == 0 || ttlSeconds[reached] == 0)
+        return;
+    std::lock_guard<std::mutex> lock(mu);
+    verdicts[domainId] = ((std::uint64_t)currentTime() << VERDICT_BITS) | reached;
+}
+
+bool VerdictCache::save() {
+    const std::string cacheMagic = "CRYPTOCENSUS-VERDICTS";
+    const std::uint64_t cacheVersion = 1;
+
+    // The verdicts are copied under the lock and written after it is released, so the searcher isn't held up by disk I/O
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> entries;
+    std::unique_lock<std::mutex> lock(mu);
+    const std::int64_t now = currentTime();
+    for(std::unordered_map<std::uint32_t, std::uint64_t>::iterator it = verdicts.begin(); it != verdicts.end();) {
+        if(isExpired(it->second, now))
+            it = verdicts.erase(it);
+        else
+            it++;
+    }
+    entries.assign(verdicts.begin(), verdicts.end());
+    lock.unlock();
+
+    CheckpointWriter writer(cacheFile);
+    writer.writeString(cacheMagic);
+    writer.writeUint(cacheVersion);
+    writer.writeUint(entries.size());
+    for(const std::pair<std::uint32_t, std::uint64_t>& entry : entries) {
+        writer.writeString(domainTable->lookup(entry.first));
+        writer.writeUint(entry.second);
+    }
+    return writer.commit();
+}
+
+std::size_t VerdictCache::size() {
+    std::lock_guard<std::mutex> lock(mu);
+    return verdicts.size();
+}
+
+void VerdictCache::load() {
+    const std::string cacheMagic = "CRYPTOCENSUS-VERDICTS";
+    const std::uint64_t cacheVersion = 1;
+
+    CheckpointReader reader(cacheFile);
+    std::string magic;
+    std::uint64_t version;
+    std::uint64_t count;
+    if(!reader.isOpen() || !reader.readString(&magic) || magic != cacheMagic || !reader.readUint(&version) || version != cacheVersion || !reader.readUint(&count)) {
+        std::cout << "ERROR: Invalid Verdict Cache: " << cacheFile << "\n";
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mu);
+    const std::int64_t now = currentTime();
+    std::string domain;
+    std::uint64_t packed;
+    for(std::uint64_t i = 0; i < count; i++) {
+        if(!reader.readString(&domain) || !reader.readUint(&packed)) {
+            std::cout << "ERROR: Verdict Cache Is Corrupt, Keeping The Verdicts Read Before The Error: " << cacheFile << "\n";
+            return;
+        }
+        if(isExpired(packed, now))
+            continue;
+        const std::uint32_t domainId = domainTable->intern(domain);
+        if(domainId != 0)
+            verdicts[domainId] = packed;
+    }
+}
+
+bool VerdictCache::isExpired(std::uint64_t packed, std::int64_t now) const {
+    const std::uint64_t reached = packed & ((1 << VERDICT_BITS) - 1);
+    if(reached >= VERDICT_TYPES)
+        return true;
+    return now - (std::int64_t)(packed >> VERDICT_BITS) >= ttlSeconds[reached];
+}
+
+std::int64_t VerdictCache::currentTime() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#ifndef VERDICTCACHE_H
+#define VERDICTCACHE_H
+
+#include "Checkpoint.h"
+#include "Config.h"
+#include "DomainInternTable.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * VerdictCache remembers the searcher's verdict on each domain across runs, so a domain is only fetched again once
+ * its verdict has expired.
+ * 
+ * Each verdict is stored with the time it was reached, packed into one 64-bit value: the time in seconds in the high
+ * bits, and the verdict in the low two bits. Each type of verdict has its own time to live, so unreachable domains
+ * can be retried sooner than domains which were fetched.
+ * 
+ * The cache is loaded from its file by the constructor, and written back by save. Expired verdicts are dropped on
+ * both.
+ * 
+ * This class is thread-safe, except that save must not be called from two threads at once, as both would write the
+ * same file.
+ */
+class VerdictCache {
+    public:
+
+        // The verdicts the searcher can reach on a domain
+        enum verdict : std::uint8_t {
+            cryptoVerdict,
+            nonCryptoVerdict,
+            unreachableVerdict
+        };
+
+        /**
+         * Constructor. Loads the cache file if it exists.
+         * 
+         * @param config a pointer to the object holding the program's configurations.
+         *      VerdictCache Configs:
+         *          VerdictCache_File the file the cache is stored in.
+         *          VerdictCache_CryptoTtlHours the hours a crypto verdict is kept. 0 disables caching it.
+         *          VerdictCache_NonCryptoTtlHours the hours a non-crypto verdict is kept. 0 disables caching it.
+         *          VerdictCache_UnreachableTtlHours the hours an unreachable verdict is kept. 0 disables caching it.
+         * @param dTable a pointer to the table domains are interned in.
+         */
+        VerdictCache(Config* config, DomainInternTable* dTable);
+
+        /**
+         * Looks up the verdict on a domain.
+         * 
+         * @param[in] domainId the id of the domain.
+         * @param[out] cached the verdict on the domain.
+         * @return true if the domain has a verdict which has not expired, false otherwise.
+         */
+        bool lookup(std::uint32_t domainId, verdict* cached);
+
+        /**
+         * Records a verdict on a domain, reached now.
+         * 
+         * @param domainId the id of the domain.
+         * @param reached the verdict.
+         */
+        void record(std::uint32_t domainId, verdict reached);
+
+        /**
+         * Writes the verdicts which have not expired to the cache file.
+         * 
+         * @return true if the file was written, false otherwise.
+         */
+        bool save();
+
+        /**
+         * Gets the number of verdicts in the cache, including expired verdicts not yet dropped.
+         * 
+         * @return the number of verdicts.
+         */
+        std::size_t size();
+
+    private:
+        static constexpr int VERDICT_BITS = 2;
+        static constexpr int VERDICT_TYPES = 3;
+
+        std::unordered_map<std::uint32_t, std::uint64_t> verdicts;
+        std::mutex mu;
+
+        DomainInternTable* domainTable;
+        std::string cacheFile;
+        std::int64_t ttlSeconds[VERDICT_TYPES];
+
+        /**
+         * Loads the cache file, keeping the verdicts which have not expired.
+         */
+        void load();
+
+        /**
+         * Checks whether a packed verdict has expired.
+         * 
+         * @param packed the packed time and verdict.
+         * @param now the current time, in seconds.
+         * @return true if the verdict has expired or is malformed, false otherwise.
+         */
+        bool isExpired(std::uint64_t packed, std::int64_t now) const;
+
+        /**
+         * Gets the current time.
+         * 
+         * @return the seconds since the epoch.
+         */
+        static std::int64_t currentTime();
+};
+
+#endif
\ No newline at end of file
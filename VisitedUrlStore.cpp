@@ -0,0 +1,150 @@
+#include "VisitedUrlStore.h"
+#include "Checkpoint.h"
+#include "DomainInternTable.h"
+#include "StringHash.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+VisitedUrlStore::VisitedUrlStore(DomainInternTable* dTable) {
+    const std::uint64_t initialCapacity = 1024;
+
+    domainTable = dTable;
+    urlCounts.push_back(RETIRED);
+    slots.assign(initialCapacity, 0);
+    usedSlots = 0;
+    retiredSlots = 0;
+}
+
+bool VisitedUrlStore::insert(std::uint32_t domainId, std::string_view urlKey) {
+    if(domainId == 0)
+        return false;
+    // Counters are added as ids are first seen, as ids are shared with every other user of the intern table
+    if(domainId >= urlCounts.size())
+        urlCounts.resize(domainId + 1, 0);
+    if(urlCounts[domainId] == RETIRED)
+        return false;
+    const std::uint64_t entry = ((std::uint64_t)domainId << 32) | (std::uint32_t)StringHash::hash(urlKey);
+    if(!insertEntry(entry))
+        return false;
+    urlCounts[domainId]++;
+    return true;
+}
+
+std::uint32_t VisitedUrlStore::count(std::uint32_t domainId) {
+    if(domainId >= urlCounts.size() || urlCounts[domainId] == RETIRED)
+        return 0;
+    return urlCounts[domainId];
+}
+
+void VisitedUrlStore::retireDomain(std::uint32_t domainId) {
+    if(domainId == 0)
+        return;
+    if(domainId >= urlCounts.size())
+        urlCounts.resize(domainId + 1, 0);
+    if(urlCounts[domainId] == RETIRED)
+        return;
+    retiredSlots += urlCounts[domainId];
+    urlCounts[domainId] = RETIRED;
+}
+
+std::uint64_t VisitedUrlStore::size() {
+    return usedSlots - retiredSlots;
+}
+
+void VisitedUrlStore::saveState(CheckpointWriter* writer) {
+    // Ids are saved with their domains, as they are reassigned when the checkpoint is loaded
+    std::uint64_t liveDomains = 0;
+    for(std::uint32_t domainId = 1; domainId < urlCounts.size(); domainId++) {
+        if(urlCounts[domainId] != RETIRED && urlCounts[domainId] > 0)
+            liveDomains++;
+    }
+    writer->writeUint(liveDomains);
+    for(std::uint32_t domainId = 1; domainId < urlCounts.size(); domainId++) {
+        if(urlCounts[domainId] != RETIRED && urlCounts[domainId] > 0) {
+            writer->writeString(domainTable->lookup(domainId));
+            writer->writeUint(domainId);
+        }
+    }
+
+    writer->writeUint(size());
+    for(std::uint64_t entry : slots) {
+        if(entry != 0 && urlCounts[entry >> 32] != RETIRED)
+            writer->writeUint(entry);
+    }
+}
+
+bool VisitedUrlStore::loadState(CheckpointReader* reader) {
+    std::unordered_map<std::uint64_t, std::uint32_t> savedIds;
+    std::string domain;
+    std::uint64_t savedId;
+    std::uint64_t count;
+
+    if(!reader->readUint(&count))
+        return false;
+    for(std::uint64_t i = 0; i < count; i++) {
+        if(!reader->readString(&domain) || !reader->readUint(&savedId))
+            return false;
+        const std::uint32_t domainId = domainTable->intern(domain);
+        if(domainId >= urlCounts.size())
+            urlCounts.resize(domainId + 1, 0);
+        savedIds[savedId] = domainId;
+    }
+
+    if(!reader->readUint(&count))
+        return false;
+    for(std::uint64_t i = 0; i < count; i++) {
+        std::uint64_t entry;
+        if(!reader->readUint(&entry))
+            return false;
+        std::unordered_map<std::uint64_t, std::uint32_t>::iterator it = savedIds.find(entry >> 32);
+        if(it == savedIds.end())
+            return false;
+        const std::uint32_t domainId = it->second;
+        if(domainId != 0 && urlCounts[domainId] != RETIRED && insertEntry(((std::uint64_t)domainId << 32) | (std::uint32_t)entry))
+            urlCounts[domainId]++;
+    }
+    return true;
+}
+
+bool VisitedUrlStore::insertEntry(std::uint64_t entry) {
+    // The table is kept at most 70% full, so probe sequences stay short
+    if((usedSlots + 1) * 10 > slots.size() * 7) {
+        // If most of the table is retired entries, rebuild it at the same size instead of growing it
+        if(retiredSlots * 2 > usedSlots)
+            rebuild(slots.size());
+        else
+            rebuild(slots.size() * 2);
+    }
+
+    const std::uint64_t mask = slots.size() - 1;
+    for(std::uint64_t i = StringHash::mix(entry) & mask; ; i = (i + 1) & mask) {
+        if(slots[i] == entry)
+            return false;
+        if(slots[i] == 0) {
+            slots[i] = entry;
+            usedSlots++;
+            return true;
+        }
+    }
+}
+
+void VisitedUrlStore::rebuild(std::uint64_t capacity) {
+    std::vector<std::uint64_t> oldSlots(capacity, 0);
+    oldSlots.swap(slots);
+    usedSlots = 0;
+    retiredSlots = 0;
+
+    const std::uint64_t mask = slots.size() - 1;
+    for(std::uint64_t entry : oldSlots) {
+        if(entry == 0 || urlCounts[entry >> 32] == RETIRED)
+            continue;
+        std::uint64_t i = StringHash::mix(entry) & mask;
+        while(slots[i] != 0)
+            i = (i + 1) & mask;
+        slots[i] = entry;
+        usedSlots++;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#ifndef VISITEDURLSTORE_H
+#define VISITEDURLSTORE_H
+
+#include "Checkpoint.h"
+#include "DomainInternTable.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * VisitedUrlStore records which URLs have been queued for each domain, in about 8 to 16 bytes per URL.
+ * 
+ * Domains are identified by their ids in the shared DomainInternTable, and each has a counter of the URLs queued
+ * for it. URLs are stored as 64-bit
+ * entries in one flat open-addressing table: the domain id in the high half, and a 32-bit fingerprint of the URL in
+ * the low half. Two URLs of the same domain share an entry only if their fingerprints collide, which for a domain's
+ * few hundred URLs is about one chance in ten million.
+ * 
+ * Retired domains are forgotten, and their entries are dropped the next time the table is rebuilt.
+ * 
+ * This class is not thread-safe.
+ */
+class VisitedUrlStore {
+    public:
+
+        /**
+         * Constructor.
+         * 
+         * @param dTable a pointer to the table domain ids are interned in.
+         */
+        VisitedUrlStore(DomainInternTable* dTable);
+
+        /**
+         * Records a URL for a domain.
+         * 
+         * @param domainId the id of the domain the URL is counted against.
+         * @param urlKey the normalized URL.
+         * @return true if the URL had not been recorded for the domain before, false otherwise.
+         */
+        bool insert(std::uint32_t domainId, std::string_view urlKey);
+
+        /**
+         * Gets the number of URLs recorded for a domain.
+         * 
+         * @param domainId the id of the domain.
+         * @return the number of URLs recorded for the domain, or 0 if the domain is unknown or retired.
+         */
+        std::uint32_t count(std::uint32_t domainId);
+
+        /**
+         * Forgets the URLs of a domain which will not be crawled again.
+         * 
+         * @param domainId the id of the domain to retire.
+         */
+        void retireDomain(std::uint32_t domainId);
+
+        /**
+         * Gets the number of URLs recorded for domains which are not retired.
+         * 
+         * @return the number of URLs recorded.
+         */
+        std::uint64_t size();
+
+        /**
+         * Writes the recorded URLs of every domain which is not retired to a checkpoint.
+         * 
+         * @param writer a pointer to the checkpoint writer.
+         */
+        void saveState(CheckpointWriter* writer);
+
+        /**
+         * Merges the URLs saved to a checkpoint into the store.
+         * 
+         * @param reader a pointer to the checkpoint reader.
+         * @return true if the state was read, false if the checkpoint is corrupt.
+         */
+        bool loadState(CheckpointReader* reader);
+
+    private:
+        // Marks a retired domain's counter
+        static constexpr std::uint32_t RETIRED = UINT32_MAX;
+
+        DomainInternTable* domainTable;
+        // The URL counter of each domain id. Id 0 is never assigned, so no entry is 0, the empty slot
+        std::vector<std::uint32_t> urlCounts;
+
+        std::vector<std::uint64_t> slots;
+        std::uint64_t usedSlots;
+        // The number of slots holding entries of retired domains
+        std::uint64_t retiredSlots;
+
+        /**
+         * Inserts an entry in the table, growing or rebuilding the table first if it is too full.
+         * 
+         * @param entry the entry to insert.
+         * @return true if the entry was inserted, false if it was already in the table.
+         */
+        bool insertEntry(std::uint64_t entry);
+
+        /**
+         * Rebuilds the table with a new capacity, dropping the entries of retired domains.
+         * 
+         * @param capacity the new number of slots. Must be a power of two.
+         */
+        void rebuild(std::uint64_t capacity);
+};
+
+#endif
\ No newline at end of file
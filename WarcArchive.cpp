@@ -0,0 +1,332 @@
+#include "WarcArchive.h"
+#include "Config.h"
+#include "OutputWriter.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Checks whether a header or field line starts with a name, ignoring ASCII case.
+ * 
+ * @param line the line.
+ * @param name the name, in lowercase, including its colon.
+ * @return true if the line starts with the name, false otherwise.
+ */
+static bool startsWithName(const std::string& line, const std::string& name) {
+    if(line.size() < name.size())
+        return false;
+    for(std::size_t i = 0; i < name.size(); i++) {
+        if(std::tolower((unsigned char)line[i]) != name[i])
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Gets the value of a header or field line, without the whitespace around it.
+ * 
+ * @param line the line.
+ * @param name the name the line starts with, including its colon.
+ * @return the value.
+ */
+static std::string fieldValue(const std::string& line, const std::string& name) {
+    const std::size_t valueStart = line.find_first_not_of(" \t", name.size());
+    if(valueStart == std::string::npos)
+        return "";
+    return line.substr(valueStart, line.find_last_not_of(" \t\r") + 1 - valueStart);
+}
+
+WarcArchive::WarcArchive(Config* config) {
+    const std::string defaultMode = "off";
+    const std::string defaultFilePrefix = "crawl";
+    const int defaultMaxFileMegabytes = 1024;
+    const int defaultReplayLatencyPercent = 100;
+    const int defaultReplayFixedLatencyMilliseconds = 0;
+    const int maxLatencyPercent = 10000;
+    const std::uint64_t bytesPerMegabyte = 1024 * 1024;
+    const double percent = 100;
+    const double millisecondsPerSecond = 1000;
+
+    const std::string mode = config->getConfig("Warc_Mode", defaultMode);
+    filePrefix = config->getConfig("Warc_FilePrefix", defaultFilePrefix);
+    recording = mode == "record";
+    replaying = mode == "replay";
+    if(!recording && !replaying && mode != defaultMode)
+        std::cout << "ERROR: Invalid Configuration: Warc_Mode\n";
+
+    if(recording) {
+        maxFileBytes = config->getIntConfig("Warc_MaxFileMegabytes", defaultMaxFileMegabytes, 1, INT_MAX) * bytesPerMegabyte;
+        outputConfig = config;
+        recordIdSeed = ((std::uint64_t)std::random_device()() << 32) ^ std::random_device()() ^ (std::uint64_t)std::time(nullptr);
+        // Earlier recordings are kept, so the archive starts at the first unused file
+        while(std::filesystem::exists(fileName(fileNumber)))
+            fileNumber++;
+        output = new OutputWriter(fileName(fileNumber), false, outputConfig);
+    }
+
+    if(replaying) {
+        latencyFraction = config->getIntConfig("Warc_ReplayLatencyPercent", defaultReplayLatencyPercent, 0, maxLatencyPercent) / percent;
+        fixedLatencySeconds = config->getIntConfig("Warc_ReplayFixedLatencyMilliseconds", defaultReplayFixedLatencyMilliseconds) / millisecondsPerSecond;
+
+        const std::filesystem::path prefixPath(filePrefix);
+        const std::filesystem::path directory = prefixPath.has_parent_path() ? prefixPath.parent_path() : std::filesystem::path(".");
+        const std::string namePrefix = prefixPath.filename().string() + "-";
+        const std::string extension = ".warc";
+        std::error_code error;
+        for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error)) {
+            const std::string name = entry.path().filename().string();
+            if(name.size() > namePrefix.size() + extension.size() && name.compare(0, namePrefix.size(), namePrefix) == 0
+                && name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+                replayFiles.push_back(entry.path().string());
+        }
+        std::sort(replayFiles.begin(), replayFiles.end());
+
+        for(std::uint32_t file = 0; file < replayFiles.size(); file++) {
+            replayStreams.push_back(std::make_unique<std::ifstream>(replayFiles[file], std::ifstream::binary));
+            replayMutexes.push_back(std::make_unique<std::mutex>());
+            if(!indexFile(file))
+                std::cout << "ERROR: Malformed WARC Record, Replaying The Records Before It: " << replayFiles[file] << "\n";
+        }
+        if(replayIndex.empty())
+            std::cout << "ERROR: No Responses Found To Replay: " << filePrefix << "-*" << extension << "\n";
+        else
+            std::cout << "Replaying " << replayIndex.size() << " Responses From " << replayFiles.size() << " WARC Files\n";
+    }
+}
+
+WarcArchive::~WarcArchive() {
+    close();
+}
+
+bool WarcArchive::isRecording() {
+    return recording;
+}
+
+bool WarcArchive::isReplaying() {
+    return replaying;
+}
+
+std::string WarcArchive::fileName(std::uint32_t number) {
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "-%05u.warc", (unsigned)number);
+    return filePrefix + suffix;
+}
+
+void WarcArchive::close() {
+    std::lock_guard<std::mutex> lock(recordMutex);
+    if(!output)
+        return;
+    output->close();
+    delete output;
+    output = nullptr;
+}
+
+void WarcArchive::writeRecord(const char* type, const std::string& fields, const std::string& block) {
+    if(!output)
+        return;
+
+    // Record ids are version 4 UUIDs. The random seed fills the first half, and the record's number the second
+    const std::uint64_t high = recordIdSeed;
+    const std::uint64_t low = recordCount++;
+    char recordId[64];
+    std::snprintf(recordId, sizeof(recordId), "<urn:uuid:%08x-%04x-4%03x-%04x-%012llx>", (unsigned)(high >> 32), (unsigned)((high >> 16) & 0xffff),
+        (unsigned)(high & 0xfff), (unsigned)(0x8000 | ((low >> 48) & 0x3fff)), (unsigned long long)(low & 0xffffffffffffULL));
+
+    char date[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    std::string record = "WARC/1.1\r\nWARC-Type: ";
+    record += type;
+    record += "\r\nWARC-Record-ID: ";
+    record += recordId;
+    record += "\r\nWARC-Date: ";
+    record += date;
+    record += "\r\n" + fields + "Content-Length: " + std::to_string(block.size()) + "\r\n\r\n";
+    record += block;
+    record += "\r\n\r\n";
+
+    if(fileBytes > 0 && fileBytes + record.size() > maxFileBytes) {
+        output->close();
+        delete output;
+        fileNumber++;
+        fileBytes = 0;
+        output = new OutputWriter(fileName(fileNumber), false, outputConfig);
+    }
+    fileBytes += record.size();
+    // The writer adds the record's final newline
+    record.pop_back();
+    output->write(record);
+}
+
+void WarcArchive::recordResponse(const std::string& requestedUrl, const std::string& targetUrl, const std::string& headers, const std::vector<std::string>& body, double fetchSeconds) {
+    // A URL holding a line break would end the field early
+    if(requestedUrl.find_first_of("\r\n") != std::string::npos || targetUrl.find_first_of("\r\n") != std::string::npos)
+        return;
+
+    std::size_t bodyBytes = 0;
+    for(const std::string& chunk : body)
+        bodyBytes += chunk.size();
+
+    // The body is stored decoded, so the headers describing its encoding on the wire are replaced
+    std::string block;
+    std::size_t lineStart = 0;
+    while(lineStart < headers.size()) {
+        std::size_t lineEnd = headers.find('\n', lineStart);
+        if(lineEnd == std::string::npos)
+            lineEnd = headers.size();
+        std::string line = headers.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+        if(!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if(line.empty() || startsWithName(line, "content-encoding:") || startsWithName(line, "transfer-encoding:") || startsWithName(line, "content-length:"))
+            continue;
+        block += line + "\r\n";
+    }
+    if(block.empty())
+        block = "HTTP/1.1 200 OK\r\n";
+    block += "Content-Length: " + std::to_string(bodyBytes) + "\r\n\r\n";
+    block.reserve(block.size() + bodyBytes);
+    for(const std::string& chunk : body)
+        block += chunk;
+
+    const std::string fields = "WARC-Target-URI: " + targetUrl + "\r\nContent-Type: application/http;msgtype=response\r\nCryptoCensus-Requested-URL: "
+        + requestedUrl + "\r\nCryptoCensus-Fetch-Seconds: " + std::to_string(fetchSeconds) + "\r\n";
+    std::lock_guard<std::mutex> lock(recordMutex);
+    writeRecord("response", fields, block);
+}
+
+void WarcArchive::recordFailure(const std::string& requestedUrl, const std::string& targetUrl, int curlCode, long httpStatus, double fetchSeconds) {
+    if(requestedUrl.find_first_of("\r\n") != std::string::npos || targetUrl.find_first_of("\r\n") != std::string::npos)
+        return;
+
+    const std::string block = "curl-error: " + std::to_string(curlCode) + "\r\nhttp-status: " + std::to_string(httpStatus) + "\r\n";
+    const std::string fields = "WARC-Target-URI: " + targetUrl + "\r\nContent-Type: application/warc-fields\r\nCryptoCensus-Requested-URL: "
+        + requestedUrl + "\r\nCryptoCensus-Fetch-Seconds: " + std::to_string(fetchSeconds) + "\r\n";
+    std::lock_guard<std::mutex> lock(recordMutex);
+    writeRecord("metadata", fields, block);
+}
+
+bool WarcArchive::indexFile(std::uint32_t file) {
+    std::ifstream& stream = *replayStreams[file];
+    std::string line;
+    while(std::getline(stream, line)) {
+        if(!line.empty() && line.back() == '\r')
+            line.pop_back();
+        // Records are separated by blank lines
+        if(line.empty())
+            continue;
+        if(line.compare(0, 5, "WARC/") != 0)
+            return false;
+
+        std::string type;
+        std::string targetUrl;
+        std::string requestedUrl;
+        std::uint64_t length = 0;
+        bool hasLength = false;
+        double fetchSeconds = 0;
+        while(std::getline(stream, line)) {
+            if(!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if(line.empty())
+                break;
+            if(startsWithName(line, "warc-type:")) {
+                type = fieldValue(line, "warc-type:");
+            } else if(startsWithName(line, "warc-target-uri:")) {
+                targetUrl = fieldValue(line, "warc-target-uri:");
+            } else if(startsWithName(line, "cryptocensus-requested-url:")) {
+                requestedUrl = fieldValue(line, "cryptocensus-requested-url:");
+            } else if(startsWithName(line, "cryptocensus-fetch-seconds:")) {
+                fetchSeconds = std::strtod(fieldValue(line, "cryptocensus-fetch-seconds:").c_str(), nullptr);
+            } else if(startsWithName(line, "content-length:")) {
+                length = std::strtoull(fieldValue(line, "content-length:").c_str(), nullptr, 10);
+                hasLength = true;
+            }
+        }
+        if(!hasLength)
+            return false;
+
+        const std::uint64_t offset = (std::uint64_t)stream.tellg();
+        stream.seekg(offset + length);
+        if(!stream)
+            return false;
+
+        // Failures are only replayed from this program's own metadata records
+        const bool failure = type == "metadata";
+        if(type == "response" || (failure && !requestedUrl.empty())) {
+            const std::string key = requestedUrl.empty() ? targetUrl : requestedUrl;
+            // Files are indexed oldest first, so a URL recorded again is replayed from its newest record
+            replayIndex.insert_or_assign(key, recordLocation {file, offset, length, failure, fetchSeconds});
+        }
+    }
+    // The stream is left at its end, so it is cleared before the first replay seeks it
+    stream.clear();
+    return true;
+}
+
+bool WarcArchive::replay(const std::string& requestedUrl, warcResponse* response) {
+    std::unordered_map<std::string, recordLocation>::iterator it = replayIndex.find(requestedUrl);
+    if(it == replayIndex.end())
+        return false;
+    const recordLocation& location = it->second;
+
+    std::string block(location.length, '\0');
+    {
+        std::lock_guard<std::mutex> lock(*replayMutexes[location.file]);
+        std::ifstream& stream = *replayStreams[location.file];
+        stream.clear();
+        stream.seekg(location.offset);
+        if(!stream.read(&block[0], block.size()))
+            return false;
+    }
+
+    response->fetchSeconds = location.fetchSeconds;
+    response->body.clear();
+    response->httpStatus = 0;
+    response->curlCode = 0;
+    if(location.failure) {
+        std::size_t lineStart = 0;
+        while(lineStart < block.size()) {
+            std::size_t lineEnd = block.find('\n', lineStart);
+            if(lineEnd == std::string::npos)
+                lineEnd = block.size();
+            const std::string line = block.substr(lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 1;
+            if(startsWithName(line, "curl-error:"))
+                response->curlCode = (int)std::strtol(fieldValue(line, "curl-error:").c_str(), nullptr, 10);
+            else if(startsWithName(line, "http-status:"))
+                response->httpStatus = std::strtol(fieldValue(line, "http-status:").c_str(), nullptr, 10);
+        }
+        return true;
+    }
+
+    // The status line is "HTTP/<version> <status> <reason>", and the body follows the first blank line
+    const std::size_t statusStart = block.find(' ');
+    if(statusStart != std::string::npos)
+        response->httpStatus = std::strtol(block.c_str() + statusStart + 1, nullptr, 10);
+    std::size_t headerEnd = block.find("\r\n\r\n");
+    std::size_t bodyStart = headerEnd == std::string::npos ? std::string::npos : headerEnd + 4;
+    if(headerEnd == std::string::npos) {
+        headerEnd = block.find("\n\n");
+        bodyStart = headerEnd == std::string::npos ? block.size() : headerEnd + 2;
+    }
+    response->body = block.substr(bodyStart);
+    return true;
+}
+
+double WarcArchive::replayLatencySeconds(const warcResponse& response) {
+    return response.fetchSeconds * latencyFraction + fixedLatencySeconds;
+}
\ No newline at end of file
@@ -0,0 +1,175 @@
+#ifndef WARCARCHIVE_H
+#define WARCARCHIVE_H
+
+#include "Config.h"
+#include "OutputWriter.h"
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A structure representing a response read back from an archive
+struct warcResponse {
+    std::string body;
+    long httpStatus = 0;
+    // The total time of the recorded transfer, or 0 if the archive did not record it
+    double fetchSeconds = 0;
+    // The curl error of a recorded failed transfer, or 0 if the transfer succeeded
+    int curlCode = 0;
+};
+
+/**
+ * WarcArchive records the responses curl fetches to WARC files, and replays them in place of the network.
+ * 
+ * When recording, every completed transfer is written as a WARC/1.1 record. Successful transfers are written as
+ * response records, holding the final response's headers and the body curl delivered, and failed transfers are
+ * written as metadata records holding the curl error. Bodies are stored as curl decoded them, so the
+ * Content-Encoding and Transfer-Encoding headers are dropped, and Content-Length is set to the stored body's size.
+ * Each record also carries the URL the pipeline requested, which differs from the WARC-Target-URI after a redirect
+ * or for the searcher's domains, and the total time of the transfer. Records are written through OutputWriter, so
+ * recording never waits on the disk, and the archive moves on to a new file once a file reaches its size limit.
+ * 
+ * When replaying, the archive's files are indexed by requested URL on startup, falling back to WARC-Target-URI for
+ * archives recorded elsewhere, and each response's block is read from disk when it is replayed. Responses are held
+ * back by a latency model: a percentage of the recorded transfer time, plus a fixed delay.
+ * 
+ * Files are named <prefix>-<number>.warc, numbered from 00000. A recording starts at the first unused number, so
+ * earlier recordings are kept, and replay reads every file with the prefix. A URL recorded more than once is replayed
+ * from its newest record, so re-recording a crawl replaces its responses.
+ * 
+ * This class is thread-safe.
+ */
+class WarcArchive {
+    public:
+
+        /**
+         * Constructor. Opens the first file when recording, and indexes every file when replaying.
+         * 
+         * @param config a pointer to the object holding the program's configurations.
+         *      WarcArchive Configs:
+         *          Warc_Mode "record" to record responses, "replay" to replay them, or "off". Defaults to "off".
+         *          Warc_FilePrefix the path and name the archive's files start with.
+         *          Warc_MaxFileMegabytes the size a file reaches before the archive moves on to the next file.
+         *          Warc_ReplayLatencyPercent the percentage of a response's recorded transfer time it is held back for.
+         *          Warc_ReplayFixedLatencyMilliseconds the delay added to every replayed response.
+         */
+        WarcArchive(Config* config);
+
+        // Closes the current file, if it has not been closed.
+        ~WarcArchive();
+
+        WarcArchive(const WarcArchive&) = delete;
+        WarcArchive& operator=(const WarcArchive&) = delete;
+
+        // Whether responses are recorded
+        bool isRecording();
+
+        // Whether responses are replayed in place of the network
+        bool isReplaying();
+
+        /**
+         * Records a successful transfer as a response record.
+         * 
+         * @param requestedUrl the URL the pipeline requested.
+         * @param targetUrl the URL of the final response, after redirects.
+         * @param headers the final response's status line and headers, as curl received them.
+         * @param body the body curl delivered.
+         * @param fetchSeconds the total time of the transfer.
+         */
+        void recordResponse(const std::string& requestedUrl, const std::string& targetUrl, const std::string& headers, const std::vector<std::string>& body, double fetchSeconds);
+
+        /**
+         * Records a failed transfer as a metadata record.
+         * 
+         * @param requestedUrl the URL the pipeline requested.
+         * @param targetUrl the URL of the last request curl made.
+         * @param curlCode the curl error the transfer failed with.
+         * @param httpStatus the HTTP status of the last response, or 0 if there was none.
+         * @param fetchSeconds the total time of the transfer.
+         */
+        void recordFailure(const std::string& requestedUrl, const std::string& targetUrl, int curlCode, long httpStatus, double fetchSeconds);
+
+        /**
+         * Reads the recorded response to a URL.
+         * 
+         * @param requestedUrl the URL the pipeline requested.
+         * @param[out] response a pointer to the structure the response is written to.
+         * @return true if the archive holds a response to the URL, false otherwise.
+         */
+        bool replay(const std::string& requestedUrl, warcResponse* response);
+
+        /**
+         * Gets the time a replayed response is held back for.
+         * 
+         * @param response the response.
+         * @return the simulated latency of the response, in seconds.
+         */
+        double replayLatencySeconds(const warcResponse& response);
+
+        /**
+         * Writes any records still queued, then closes the current file.
+         */
+        void close();
+
+    private:
+        // The location of a record's block in the archive's files
+        struct recordLocation {
+            std::uint32_t file;
+            std::uint64_t offset;
+            std::uint64_t length;
+            bool failure;
+            double fetchSeconds;
+        };
+
+        bool recording = false;
+        bool replaying = false;
+        std::string filePrefix;
+
+        // Recording state
+        std::mutex recordMutex;
+        OutputWriter* output = nullptr;
+        std::uint32_t fileNumber = 0;
+        std::uint64_t fileBytes = 0;
+        std::uint64_t maxFileBytes = 0;
+        Config* outputConfig = nullptr;
+        std::uint64_t recordIdSeed = 0;
+        std::uint64_t recordCount = 0;
+
+        // Replay state. Each file has its own stream and lock, so replays from different files don't wait on each other
+        std::vector<std::string> replayFiles;
+        std::vector<std::unique_ptr<std::ifstream>> replayStreams;
+        std::vector<std::unique_ptr<std::mutex>> replayMutexes;
+        std::unordered_map<std::string, recordLocation> replayIndex;
+        double latencyFraction = 1;
+        double fixedLatencySeconds = 0;
+
+        /**
+         * Gets the name of one of the archive's files.
+         * 
+         * @param number the file's number.
+         * @return the file's path.
+         */
+        std::string fileName(std::uint32_t number);
+
+        /**
+         * Writes a record, moving on to the next file first if the current file is full. Must hold recordMutex.
+         * 
+         * @param type the WARC-Type of the record.
+         * @param fields the record's fields, other than its type, id, date and length, each ending in CRLF.
+         * @param block the record's block.
+         */
+        void writeRecord(const char* type, const std::string& fields, const std::string& block);
+
+        /**
+         * Indexes the records of one of the archive's files.
+         * 
+         * @param file the index of the file in replayFiles.
+         * @return true if the file was read to its end, false if it held a malformed record.
+         */
+        bool indexFile(std::uint32_t file);
+};
+
+#endif
\ No newline at end of file
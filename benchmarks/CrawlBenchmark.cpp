@@ -0,0 +1,726 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+/**
+ * CrawlBenchmark measures the throughput of the whole pipeline without the internet.
+ * 
+ * It serves a synthetic web graph from a local multi-threaded HTTP server, prepares a working directory whose
+ * config.txt sends every connection to that server, then runs CryptoCensus headlessly for a fixed number of seconds.
+ * CryptoCensus writes a report of the pages fetched and domains verified per second, its peak resident memory and its
+ * processor time, which is combined with the server's counters and the graph's parameters into one JSON file.
+ * 
+ * The graph is generated from a seed, so every run serves the same pages. Each page lives on one of a number of
+ * domains, and links to a number of other pages. A share of the domains are crypto related, and their pages carry
+ * terms from terms.txt. Page sizes and response latencies follow log-normal distributions.
+ * 
+ * Usage: CrawlBenchmark [--exe <CryptoCensus executable>] [--workdir <directory>] [--out <file>] [--seconds <seconds>]
+ *                       [--port <port>] [--seed <seed>] [--pages <count>] [--domains <count>] [--sources <count>]
+ *                       [--fan-out <links>] [--crypto-percent <percent>] [--terms-per-page <count>]
+ *                       [--page-kb <median>] [--size-sigma <sigma>] [--latency-ms <median>] [--latency-sigma <sigma>]
+ *                       [--crawler-connections <count>] [--searcher-connections <count>]
+ * 
+ * The benchmark must be run from the project's directory, as it copies config.txt, terms.txt and
+ * public_suffix_list.dat into the working directory.
+ */
+
+// A structure representing the parameters of the synthetic web graph
+struct graphOptions {
+    int pages = 20000;
+    int domains = 500;
+    int sources = 10;
+    int fanOut = 12;
+    int cryptoPercent = 40;
+    int termsPerPage = 6;
+    double pageKilobytes = 40;
+    double sizeSigma = 0.6;
+    double latencyMilliseconds = 40;
+    double latencySigma = 0.5;
+    std::uint64_t seed = 1;
+};
+
+/**
+ * Mixes a value into a well distributed hash. This is the finalizer of SplitMix64.
+ * 
+ * @param value the value to mix.
+ * @return the hash.
+ */
+static std::uint64_t mix(std::uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+/**
+ * A small random number generator. The standard library's distributions differ between implementations, so the
+ * distributions are implemented here, and a seed gives the same graph on every platform.
+ */
+class GraphRandom {
+    public:
+
+        /**
+         * Constructor.
+         * 
+         * @param seed the graph's seed.
+         * @param stream the stream of numbers within the seed, such as a page's id.
+         */
+        GraphRandom(std::uint64_t seed, std::uint64_t stream) {
+            state = mix(seed) ^ mix(stream + 0x9e3779b97f4a7c15ULL);
+        }
+
+        std::uint64_t next() {
+            state += 0x9e3779b97f4a7c15ULL;
+            return mix(state);
+        }
+
+        // Returns a number in [0, bound)
+        std::uint64_t below(std::uint64_t bound) {
+            return bound == 0 ? 0 : next() % bound;
+        }
+
+        // Returns a number in (0, 1)
+        double uniform() {
+            const double twoToTheMinus53 = 1.0 / 9007199254740992.0;
+            return ((next() >> 11) + 0.5) * twoToTheMinus53;
+        }
+
+        // Returns a log-normally distributed number, by the Box-Muller transform
+        double logNormal(double median, double sigma) {
+            const double twoPi = 6.283185307179586;
+            const double normal = std::sqrt(-2.0 * std::log(uniform())) * std::cos(twoPi * uniform());
+            return median * std::exp(sigma * normal);
+        }
+
+    private:
+        std::uint64_t state;
+};
+
+/**
+ * Closes a socket.
+ * 
+ * @param socketToClose the socket.
+ */
+static void closeSocket(std::intptr_t socketToClose) {
+#ifdef _WIN32
+    closesocket((SOCKET)socketToClose);
+#else
+    ::close((int)socketToClose);
+#endif
+}
+
+/**
+ * StandInServer serves the synthetic web graph over HTTP/1.1, on a thread per connection.
+ * 
+ * Pages are generated on request rather than stored. Page p lives on domain p % domains, at /p<p>.html, and the
+ * first page of each domain is also its home page at /. Every response is held back by its page's latency first.
+ */
+class StandInServer {
+    public:
+
+        /**
+         * Constructor.
+         * 
+         * @param options the parameters of the graph.
+         * @param crawlTerms the terms crypto related pages carry.
+         */
+        StandInServer(const graphOptions& options, const std::vector<std::string>& crawlTerms) {
+            graph = options;
+            terms = crawlTerms;
+            listenSocket = -1;
+            stopping = false;
+            requests = 0;
+            notFound = 0;
+            bytesSent = 0;
+            connections = 0;
+        }
+
+        ~StandInServer() {
+            stop();
+        }
+
+        StandInServer(const StandInServer&) = delete;
+        StandInServer& operator=(const StandInServer&) = delete;
+
+        /**
+         * Opens the listener on a loopback port, and starts accepting connections.
+         * 
+         * @param port the port to listen on.
+         * @return true if the server is listening, false otherwise.
+         */
+        bool start(int port) {
+            const int connectionBacklog = 1024;
+            const int enableReuseAddress = 1;
+
+#ifdef _WIN32
+            WSADATA wsaData;
+            if(WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+                return false;
+            const SOCKET created = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            if(created == INVALID_SOCKET)
+                return false;
+#else
+            const int created = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            if(created < 0)
+                return false;
+#endif
+            setsockopt(created, SOL_SOCKET, SO_REUSEADDR, (const char*)&enableReuseAddress, sizeof(enableReuseAddress));
+
+            sockaddr_in address {};
+            address.sin_family = AF_INET;
+            address.sin_port = htons((unsigned short)port);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if(bind(created, (const sockaddr*)&address, sizeof(address)) != 0 || listen(created, connectionBacklog) != 0) {
+                closeSocket((std::intptr_t)created);
+                return false;
+            }
+            listenSocket = (std::intptr_t)created;
+            acceptThread = std::thread(&StandInServer::acceptLoop, this);
+            return true;
+        }
+
+        /**
+         * Stops accepting connections, and waits for every open connection to close.
+         */
+        void stop() {
+            if(stopping.exchange(true))
+                return;
+            if(acceptThread.joinable())
+                acceptThread.join();
+            std::lock_guard<std::mutex> lock(connectionThreadsMutex);
+            for(std::thread& connectionThread : connectionThreads)
+                connectionThread.join();
+            connectionThreads.clear();
+            if(listenSocket != -1) {
+                closeSocket(listenSocket);
+                listenSocket = -1;
+#ifdef _WIN32
+                WSACleanup();
+#endif
+            }
+        }
+
+        /**
+         * Gets the name of a domain of the graph.
+         * 
+         * @param domain the domain's index.
+         * @return the domain's name.
+         */
+        static std::string domainName(int domain) {
+            return "crawlbench" + std::to_string(domain) + ".com";
+        }
+
+        /**
+         * Checks whether a domain's pages are crypto related. The source domains always are, so the crawl can start.
+         * 
+         * @param domain the domain's index.
+         * @return true if the domain's pages carry terms, false otherwise.
+         */
+        bool isCryptoDomain(int domain) const {
+            const std::uint64_t domainStream = 0x100000000ULL;
+            const std::uint64_t percent = 100;
+            return domain < graph.sources || GraphRandom(graph.seed, domainStream + domain).below(percent) < (std::uint64_t)graph.cryptoPercent;
+        }
+
+        /**
+         * Generates a page of the graph.
+         * 
+         * @param page the page's id.
+         * @return the page's HTML.
+         */
+        std::string renderPage(int page) const {
+            const double minimumPageBytes = 512;
+            const double maximumPageBytes = 8 * 1024 * 1024;
+            static const char* const fillerWords[] = {
+                "garden", "weather", "recipe", "travel", "history", "museum", "river", "mountain", "library", "concert",
+                "football", "painting", "village", "harbour", "festival", "bicycle", "orchard", "theatre", "journey",
+                "market", "island", "forest", "kitchen", "chapter", "lecture", "season", "morning", "window", "station",
+                "letter", "story", "picture", "school", "street", "bridge", "meadow", "summer", "winter", "autumn", "spring"
+            };
+            const std::size_t fillerWordCount = sizeof(fillerWords) / sizeof(fillerWords[0]);
+            const int wordsPerParagraph = 60;
+
+            GraphRandom random(graph.seed, (std::uint64_t)page);
+            const int domain = page % graph.domains;
+            const std::size_t targetBytes = (std::size_t)std::min(maximumPageBytes, std::max(minimumPageBytes,
+                random.logNormal(graph.pageKilobytes * 1024, graph.sizeSigma)));
+
+            std::string html = "<!DOCTYPE html>\n<html><head><title>" + domainName(domain) + " page " + std::to_string(page)
+                + "</title></head>\n<body>\n<h1>Page " + std::to_string(page) + "</h1>\n<ul>\n";
+            for(int i = 0; i < graph.fanOut; i++) {
+                const int target = (int)random.below(graph.pages);
+                html += "<li><a href=\"http://" + domainName(target % graph.domains) + "/p" + std::to_string(target) + ".html\">Page "
+                    + std::to_string(target) + "</a></li>\n";
+            }
+            html += "</ul>\n";
+
+            // Terms are spread through the filler, rather than gathered at the top of the page
+            std::vector<std::string> pageTerms;
+            if(isCryptoDomain(domain) && !terms.empty()) {
+                for(int i = 0; i < graph.termsPerPage && i < (int)terms.size(); i++)
+                    pageTerms.push_back(terms[random.below(terms.size())]);
+            }
+            std::size_t nextTerm = 0;
+            while(html.size() < targetBytes || nextTerm < pageTerms.size()) {
+                html += "<p>";
+                for(int i = 0; i < wordsPerParagraph; i++) {
+                    html += fillerWords[random.below(fillerWordCount)];
+                    html += ' ';
+                }
+                if(nextTerm < pageTerms.size())
+                    html += pageTerms[nextTerm++];
+                html += "</p>\n";
+            }
+            html += "</body></html>\n";
+            return html;
+        }
+
+        std::uint64_t getRequests() const { return requests.load(); }
+        std::uint64_t getNotFound() const { return notFound.load(); }
+        std::uint64_t getBytesSent() const { return bytesSent.load(); }
+        std::uint64_t getConnections() const { return connections.load(); }
+
+    private:
+        graphOptions graph;
+        std::vector<std::string> terms;
+
+        std::intptr_t listenSocket;
+        std::atomic<bool> stopping;
+        std::thread acceptThread;
+        std::mutex connectionThreadsMutex;
+        std::vector<std::thread> connectionThreads;
+
+        std::atomic<std::uint64_t> requests;
+        std::atomic<std::uint64_t> notFound;
+        std::atomic<std::uint64_t> bytesSent;
+        std::atomic<std::uint64_t> connections;
+
+        /**
+         * Accepts connections until the server is stopped, and serves each on its own thread.
+         */
+        void acceptLoop() {
+            // The stop flag is checked between waits, so stopping is not held up by an idle listener
+            const long acceptPollMicroseconds = 100000;
+
+            while(!stopping.load()) {
+                fd_set readable;
+                FD_ZERO(&readable);
+#ifdef _WIN32
+                FD_SET((SOCKET)listenSocket, &readable);
+#else
+                FD_SET((int)listenSocket, &readable);
+#endif
+                timeval timeout;
+                timeout.tv_sec = 0;
+                timeout.tv_usec = acceptPollMicroseconds;
+                if(select((int)listenSocket + 1, &readable, NULL, NULL, &timeout) <= 0)
+                    continue;
+#ifdef _WIN32
+                const SOCKET connection = accept((SOCKET)listenSocket, NULL, NULL);
+                if(connection == INVALID_SOCKET)
+                    continue;
+#else
+                const int connection = accept((int)listenSocket, NULL, NULL);
+                if(connection < 0)
+                    continue;
+#endif
+                connections++;
+                std::lock_guard<std::mutex> lock(connectionThreadsMutex);
+                connectionThreads.push_back(std::thread(&StandInServer::serveConnection, this, (std::intptr_t)connection));
+            }
+        }
+
+        /**
+         * Checks whether the last receive on a socket failed because its timeout expired.
+         * 
+         * @return true if the receive timed out, false otherwise.
+         */
+        static bool receiveTimedOut() {
+#ifdef _WIN32
+            return WSAGetLastError() == WSAETIMEDOUT;
+#else
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+        }
+
+        /**
+         * Answers the requests on a connection until the client closes it, it is idle for too long, or the server
+         * is stopped.
+         * 
+         * @param connection the connection's socket.
+         */
+        void serveConnection(std::intptr_t connection) {
+            const int receiveTimeoutMilliseconds = 250;
+            const int maxIdleTimeouts = 60;
+            const std::size_t maxRequestSize = 65536;
+#ifdef MSG_NOSIGNAL
+            const int sendFlags = MSG_NOSIGNAL;
+#else
+            const int sendFlags = 0;
+#endif
+
+#ifdef _WIN32
+            const DWORD receiveTimeout = receiveTimeoutMilliseconds;
+            setsockopt((SOCKET)connection, SOL_SOCKET, SO_RCVTIMEO, (const char*)&receiveTimeout, sizeof(receiveTimeout));
+#else
+            timeval receiveTimeout;
+            receiveTimeout.tv_sec = 0;
+            receiveTimeout.tv_usec = receiveTimeoutMilliseconds * 1000;
+            setsockopt((int)connection, SOL_SOCKET, SO_RCVTIMEO, (const char*)&receiveTimeout, sizeof(receiveTimeout));
+#endif
+
+            std::string buffered;
+            char buffer[4096];
+            int idleTimeouts = 0;
+            bool open = true;
+            while(open && !stopping.load()) {
+                const std::size_t headerEnd = buffered.find("\r\n\r\n");
+                if(headerEnd == std::string::npos) {
+                    if(buffered.size() > maxRequestSize)
+                        break;
+                    const int received = (int)recv(connection, buffer, sizeof(buffer), 0);
+                    if(received > 0) {
+                        buffered.append(buffer, received);
+                        idleTimeouts = 0;
+                    } else if(received < 0 && receiveTimedOut() && ++idleTimeouts < maxIdleTimeouts) {
+                        continue;
+                    } else {
+                        break;
+                    }
+                    continue;
+                }
+
+                const std::string request = buffered.substr(0, headerEnd);
+                buffered.erase(0, headerEnd + 4);
+                bool keepAlive = true;
+                const std::string response = respond(request, &keepAlive);
+                std::size_t sent = 0;
+                while(sent < response.size()) {
+                    const int written = (int)send(connection, response.data() + sent, (int)(response.size() - sent), sendFlags);
+                    if(written <= 0)
+                        break;
+                    sent += written;
+                }
+                bytesSent += sent;
+                open = keepAlive && sent == response.size();
+            }
+            closeSocket(connection);
+        }
+
+        /**
+         * Builds the response to a request, after waiting out the page's latency.
+         * 
+         * @param request the request line and headers.
+         * @param[out] keepAlive a pointer to whether the connection stays open after the response.
+         * @return the response.
+         */
+        std::string respond(const std::string& request, bool* keepAlive) {
+            const std::uint64_t latencyStream = 0x200000000ULL;
+
+            requests++;
+            std::string lowered = request;
+            std::transform(lowered.begin(), lowered.end(), lowered.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+            *keepAlive = lowered.find("\r\nconnection: close") == std::string::npos;
+
+            // The request line is "GET <path> HTTP/1.1"
+            const std::size_t pathStart = request.find(' ');
+            const std::size_t pathEnd = pathStart == std::string::npos ? std::string::npos : request.find(' ', pathStart + 1);
+            std::string path = pathEnd == std::string::npos ? "" : request.substr(pathStart + 1, pathEnd - pathStart - 1);
+            const std::size_t query = path.find_first_of("?#");
+            if(query != std::string::npos)
+                path.erase(query);
+
+            std::string host;
+            const std::size_t hostHeader = lowered.find("\r\nhost:");
+            if(hostHeader != std::string::npos) {
+                const std::size_t hostEnd = lowered.find("\r\n", hostHeader + 2);
+                host = lowered.substr(hostHeader + 7, hostEnd == std::string::npos ? std::string::npos : hostEnd - hostHeader - 7);
+                host.erase(0, host.find_first_not_of(" \t"));
+                host.erase(std::min(host.find(':'), host.find_last_not_of(" \t") + 1));
+            }
+
+            const int page = findPage(host, path);
+            if(page < 0) {
+                notFound++;
+                const std::string body = "Not Found\n";
+                return "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: " + std::to_string(body.size())
+                    + "\r\n" + (*keepAlive ? "" : "Connection: close\r\n") + "\r\n" + body;
+            }
+
+            GraphRandom random(graph.seed, latencyStream + page);
+            const double latency = random.logNormal(graph.latencyMilliseconds, graph.latencySigma);
+            std::this_thread::sleep_for(std::chrono::microseconds((std::int64_t)(latency * 1000)));
+
+            const std::string body = renderPage(page);
+            return "HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\nContent-Length: " + std::to_string(body.size())
+                + "\r\n" + (*keepAlive ? "" : "Connection: close\r\n") + "\r\n" + body;
+        }
+
+        /**
+         * Finds the page a host and path refer to.
+         * 
+         * @param host the lowercase host, without a port.
+         * @param path the path.
+         * @return the page's id, or -1 if there is no such page.
+         */
+        int findPage(std::string host, const std::string& path) const {
+            const std::string prefix = "crawlbench";
+            const std::string suffix = ".com";
+            const std::string wwwPrefix = "www.";
+
+            if(host.compare(0, wwwPrefix.size(), wwwPrefix) == 0)
+                host.erase(0, wwwPrefix.size());
+            if(host.size() <= prefix.size() + suffix.size() || host.compare(0, prefix.size(), prefix) != 0
+                || host.compare(host.size() - suffix.size(), suffix.size(), suffix) != 0)
+                return -1;
+            const std::string digits = host.substr(prefix.size(), host.size() - prefix.size() - suffix.size());
+            if(digits.size() > 9 || digits.find_first_not_of("0123456789") != std::string::npos)
+                return -1;
+            const int domain = std::stoi(digits);
+            if(domain >= graph.domains)
+                return -1;
+
+            if(path == "/" || path == "/index.html")
+                return domain;
+            if(path.size() < 8 || path.compare(0, 2, "/p") != 0 || path.compare(path.size() - 5, 5, ".html") != 0)
+                return -1;
+            const std::string pageDigits = path.substr(2, path.size() - 7);
+            if(pageDigits.empty() || pageDigits.size() > 9 || pageDigits.find_first_not_of("0123456789") != std::string::npos)
+                return -1;
+            const int page = std::stoi(pageDigits);
+            return page < graph.pages && page % graph.domains == domain ? page : -1;
+        }
+};
+
+/**
+ * Reads the non-empty lines of a file.
+ * 
+ * @param file the file.
+ * @return the lines, without line endings.
+ */
+static std::vector<std::string> readLines(const std::string& file) {
+    std::vector<std::string> lines;
+    std::ifstream input(file);
+    std::string line;
+    while(std::getline(input, line)) {
+        if(!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if(!line.empty())
+            lines.push_back(line);
+    }
+    return lines;
+}
+
+/**
+ * Writes a file.
+ * 
+ * @param file the file.
+ * @param contents the contents.
+ * @return true if the file was written, false otherwise.
+ */
+static bool writeFile(const std::filesystem::path& file, const std::string& contents) {
+    std::ofstream output(file, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    return output.is_open() && output.write(contents.data(), contents.size());
+}
+
+/**
+ * Prepares the working directory of the run: copies the project's data files, writes the sources, and writes a
+ * config.txt which keeps the project's configuration but sends every connection to the stand-in server. State left
+ * by an earlier run is removed, so every run starts cold.
+ * 
+ * @param workDirectory the working directory.
+ * @param options the parameters of the graph.
+ * @param overrides the configurations which replace the project's.
+ * @return true if the directory was prepared, false otherwise.
+ */
+static bool prepareWorkDirectory(const std::filesystem::path& workDirectory, const graphOptions& options, const std::vector<std::pair<std::string, std::string>>& overrides) {
+    const char* const copiedFiles[] = {"terms.txt", "public_suffix_list.dat"};
+    const char* const stateFiles[] = {"checkpoint.bin", "checkpoint.bin.tmp", "verdicts.bin", "output.txt", "output_sorted.txt",
+        "output_delta.txt", "run_report.json"};
+    const std::string spillDirectory = "frontier_spill";
+
+    std::error_code error;
+    std::filesystem::create_directories(workDirectory, error);
+    for(const char* file : copiedFiles) {
+        std::filesystem::copy_file(file, workDirectory / file, std::filesystem::copy_options::overwrite_existing, error);
+        if(error) {
+            std::cout << "ERROR: Could Not Copy " << file << " To: " << workDirectory.string() << "\n";
+            return false;
+        }
+    }
+    for(const char* file : stateFiles)
+        std::filesystem::remove(workDirectory / file, error);
+    std::filesystem::remove_all(workDirectory / spillDirectory, error);
+
+    std::string config;
+    for(const std::string& line : readLines("config.txt")) {
+        const std::string key = line.substr(0, line.find('='));
+        const bool overridden = std::any_of(overrides.begin(), overrides.end(), [&key](const std::pair<std::string, std::string>& entry) {
+            return entry.first == key;
+        });
+        if(!overridden)
+            config += line + "\n";
+    }
+    for(const std::pair<std::string, std::string>& entry : overrides)
+        config += entry.first + "=" + entry.second + "\n";
+
+    std::string sources;
+    for(int domain = 0; domain < options.sources; domain++)
+        sources += "http://" + StandInServer::domainName(domain) + "/\n";
+
+    return writeFile(workDirectory / "config.txt", config) && writeFile(workDirectory / "sources.txt", sources)
+        && writeFile(workDirectory / "exclusions.txt", "");
+}
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    std::string executable = "CryptoCensus.exe";
+#else
+    std::string executable = "./CryptoCensus";
+#endif
+    std::string workDirectory = "crawl_benchmark";
+    std::string outputFile = "crawl_benchmark.json";
+    int seconds = 60;
+    int port = 18080;
+    int crawlerConnections = 200;
+    int searcherConnections = 400;
+    graphOptions options;
+
+    for(int i = 1; i + 1 < argc; i += 2) {
+        const std::string option = argv[i];
+        const std::string value = argv[i + 1];
+        if(option == "--exe")
+            executable = value;
+        else if(option == "--workdir")
+            workDirectory = value;
+        else if(option == "--out")
+            outputFile = value;
+        else if(option == "--seconds")
+            seconds = std::max(1, std::atoi(value.c_str()));
+        else if(option == "--port")
+            port = std::atoi(value.c_str());
+        else if(option == "--seed")
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if(option == "--pages")
+            options.pages = std::max(1, std::atoi(value.c_str()));
+        else if(option == "--domains")
+            options.domains = std::max(1, std::atoi(value.c_str()));
+        else if(option == "--sources")
+            options.sources = std::max(1, std::atoi(value.c_str()));
+        else if(option == "--fan-out")
+            options.fanOut = std::max(0, std::atoi(value.c_str()));
+        else if(option == "--crypto-percent")
+            options.cryptoPercent = std::min(100, std::max(0, std::atoi(value.c_str())));
+        else if(option == "--terms-per-page")
+            options.termsPerPage = std::max(0, std::atoi(value.c_str()));
+        else if(option == "--page-kb")
+            options.pageKilobytes = std::max(0.0, std::atof(value.c_str()));
+        else if(option == "--size-sigma")
+            options.sizeSigma = std::max(0.0, std::atof(value.c_str()));
+        else if(option == "--latency-ms")
+            options.latencyMilliseconds = std::max(0.0, std::atof(value.c_str()));
+        else if(option == "--latency-sigma")
+            options.latencySigma = std::max(0.0, std::atof(value.c_str()));
+        else if(option == "--crawler-connections")
+            crawlerConnections = std::max(1, std::atoi(value.c_str()));
+        else if(option == "--searcher-connections")
+            searcherConnections = std::max(1, std::atoi(value.c_str()));
+        else
+            std::cout << "ERROR: Unknown Option: " << option << "\n";
+    }
+    // Every domain holds at least its home page, and the sources are the first domains
+    options.domains = std::min(options.domains, options.pages);
+    options.sources = std::min(options.sources, options.domains);
+
+    const std::vector<std::string> terms = readLines("terms.txt");
+    if(terms.empty())
+        std::cout << "ERROR: No Terms Found In terms.txt, No Page Will Be Crypto Related\n";
+
+    const std::vector<std::pair<std::string, std::string>> overrides = {
+        {"Run_DurationSeconds", std::to_string(seconds)},
+        {"Run_ReportFile", "run_report.json"},
+        {"Curl_ConnectTo", "::127.0.0.1:" + std::to_string(port)},
+        {"Curl_DefaultProtocol", "http"},
+        {"Crawler_MaxConnections", std::to_string(crawlerConnections)},
+        {"Searcher_MaxConnections", std::to_string(searcherConnections)},
+        {"Checkpoint_File", "checkpoint.bin"},
+        {"Checkpoint_IntervalSeconds", "0"},
+        {"VerdictCache_File", "verdicts.bin"},
+        {"Output_File", "output.txt"},
+        {"Output_Append", "0"},
+        {"Finalizer_SortedFile", "output_sorted.txt"},
+        {"Finalizer_DeltaFile", "output_delta.txt"},
+        {"Frontier_SpillDirectory", "frontier_spill"},
+        {"Metrics_HttpPort", "0"}
+    };
+    const std::filesystem::path executablePath = std::filesystem::absolute(executable);
+    const std::filesystem::path workPath = std::filesystem::absolute(workDirectory);
+    const std::filesystem::path outputPath = std::filesystem::absolute(outputFile);
+    if(!prepareWorkDirectory(workPath, options, overrides))
+        return 1;
+
+    StandInServer server(options, terms);
+    if(!server.start(port)) {
+        std::cout << "ERROR: Could Not Listen On Port: " << port << "\n";
+        return 1;
+    }
+
+    // CryptoCensus reads its files from its working directory
+    std::cout << "Running " << executablePath.string() << " for " << seconds << " seconds in " << workPath.string() << std::endl;
+    std::filesystem::current_path(workPath);
+    const int exitCode = std::system(("\"" + executablePath.string() + "\"").c_str());
+    server.stop();
+
+    std::stringstream runReport;
+    runReport << std::ifstream(workPath / "run_report.json").rdbuf();
+    std::string run = runReport.str();
+    while(!run.empty() && (run.back() == '\n' || run.back() == '\r'))
+        run.pop_back();
+    if(run.empty()) {
+        std::cout << "ERROR: CryptoCensus Wrote No Run Report, Exit Code: " << exitCode << "\n";
+        return 1;
+    }
+
+    std::string json = "{\n\"graph\": {";
+    json += "\"pages\": " + std::to_string(options.pages) + ", \"domains\": " + std::to_string(options.domains);
+    json += ", \"sources\": " + std::to_string(options.sources) + ", \"fanOut\": " + std::to_string(options.fanOut);
+    json += ", \"cryptoPercent\": " + std::to_string(options.cryptoPercent) + ", \"termsPerPage\": " + std::to_string(options.termsPerPage);
+    json += ", \"pageKilobytes\": " + std::to_string(options.pageKilobytes) + ", \"sizeSigma\": " + std::to_string(options.sizeSigma);
+    json += ", \"latencyMilliseconds\": " + std::to_string(options.latencyMilliseconds) + ", \"latencySigma\": " + std::to_string(options.latencySigma);
+    json += ", \"seed\": " + std::to_string(options.seed) + "},\n";
+    json += "\"connections\": {\"crawler\": " + std::to_string(crawlerConnections) + ", \"searcher\": " + std::to_string(searcherConnections) + "},\n";
+    json += "\"server\": {\"requests\": " + std::to_string(server.getRequests()) + ", \"notFound\": " + std::to_string(server.getNotFound());
+    json += ", \"bytesSent\": " + std::to_string(server.getBytesSent()) + ", \"connections\": " + std::to_string(server.getConnections()) + "},\n";
+    json += "\"run\": " + run + "\n}\n";
+    if(!writeFile(outputPath, json)) {
+        std::cout << "ERROR: Could Not Write Benchmark Results: " << outputPath.string() << "\n";
+        return 1;
+    }
+    std::cout << "Server - Requests: " << server.getRequests() << " - Not Found: " << server.getNotFound()
+              << " - Connections: " << server.getConnections() << "\nResults written to " << outputPath.string() << "\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,388 @@
+#include "../DomainExtractor.h"
+#include "../LinkTokenizer.h"
+#include "../ProcessUsage.h"
+#include "../TermMatcher.h"
+#include "../ThreadSafeQueue.h"
+#include "../ThreadSafeSet.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * MicroBenchmarks measures the hot paths of the crawler and the searcher in isolation, against a corpus of
+ * representative pages checked in under benchmarks/corpus.
+ * 
+ * Each benchmark is calibrated until one run takes at least the minimum time, then run several times, and the
+ * median run is reported. Results are printed as a table, and written as JSON in the layout Google Benchmark uses,
+ * so runs of two versions can be compared with Google Benchmark's compare.py.
+ * 
+ * Usage: MicroBenchmarks [--corpus <directory>] [--filter <substring>] [--min-time <seconds>]
+ *                        [--repetitions <count>] [--out <file>]
+ * 
+ * The benchmarks must be run from the directory holding terms.txt, as TermMatcher reads its terms from there.
+ */
+
+// A benchmark body runs the measured operation a number of times
+typedef std::function<void(std::int64_t iterations)> benchmarkBody;
+
+// A structure representing a benchmark to run
+struct benchmarkCase {
+    std::string name;
+    benchmarkBody body;
+    // The bytes and items processed by one iteration, or 0 if the benchmark does not report them
+    double bytesPerIteration;
+    double itemsPerIteration;
+};
+
+// A structure representing the median run of a benchmark
+struct benchmarkResult {
+    std::string name;
+    std::int64_t iterations;
+    double realNanoseconds;
+    double cpuNanoseconds;
+    double bytesPerSecond;
+    double itemsPerSecond;
+};
+
+// A structure representing a page of the corpus, split into chunks the way curl delivers it
+struct corpusPage {
+    std::string name;
+    std::vector<std::string> chunks;
+    std::size_t bytes;
+};
+
+// Results are accumulated here so the compiler cannot discard the measured work
+static volatile std::size_t benchmarkSink;
+
+/**
+ * Loads every HTML page in a directory, in name order.
+ * 
+ * @param directory the corpus directory.
+ * @param chunkSize the size of the chunks the pages are split into.
+ * @return the pages.
+ */
+static std::vector<corpusPage> loadCorpus(const std::string& directory, std::size_t chunkSize) {
+    std::vector<std::filesystem::path> paths;
+    std::error_code error;
+    for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error)) {
+        if(entry.path().extension() == ".html")
+            paths.push_back(entry.path());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<corpusPage> pages;
+    for(const std::filesystem::path& path : paths) {
+        std::ifstream file(path, std::ifstream::binary);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        const std::string page = contents.str();
+
+        corpusPage loaded;
+        loaded.name = path.stem().string();
+        loaded.bytes = page.size();
+        for(std::size_t i = 0; i < page.size(); i += chunkSize)
+            loaded.chunks.push_back(page.substr(i, chunkSize));
+        pages.push_back(loaded);
+    }
+    return pages;
+}
+
+/**
+ * Runs a benchmark body once, and measures it.
+ * 
+ * @param body the benchmark body.
+ * @param iterations the number of iterations to run.
+ * @param[out] realSeconds the wall-clock time the run took.
+ * @param[out] cpuSeconds the processor time the run took, across every thread of the process.
+ */
+static void timeRun(const benchmarkBody& body, std::int64_t iterations, double* realSeconds, double* cpuSeconds) {
+    // std::clock is wall time on Windows, so processor time is read from the operating system
+    processUsage cpuStart;
+    processUsage cpuEnd;
+    ProcessUsage::read(&cpuStart);
+    const std::chrono::steady_clock::time_point realStart = std::chrono::steady_clock::now();
+    body(iterations);
+    *realSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - realStart).count();
+    ProcessUsage::read(&cpuEnd);
+    *cpuSeconds = (cpuEnd.userCpuSeconds + cpuEnd.systemCpuSeconds) - (cpuStart.userCpuSeconds + cpuStart.systemCpuSeconds);
+}
+
+/**
+ * Calibrates and runs a benchmark.
+ * 
+ * @param benchmark the benchmark to run.
+ * @param minSeconds the minimum time of one run.
+ * @param repetitions the number of measured runs.
+ * @return the median run.
+ */
+static benchmarkResult runBenchmark(const benchmarkCase& benchmark, double minSeconds, int repetitions) {
+    const std::int64_t maxIterations = 1000000000;
+    const double growthMargin = 1.4;
+
+    // Grow the iteration count until a run is long enough to measure
+    std::int64_t iterations = 1;
+    double realSeconds = 0;
+    double cpuSeconds = 0;
+    while(true) {
+        timeRun(benchmark.body, iterations, &realSeconds, &cpuSeconds);
+        if(realSeconds >= minSeconds || iterations >= maxIterations)
+            break;
+        const double scale = realSeconds > 0 ? minSeconds * growthMargin / realSeconds : 10;
+        iterations = std::min(maxIterations, std::max(iterations + 1, (std::int64_t)(iterations * std::min(scale, 10.0))));
+    }
+
+    std::vector<std::pair<double, double>> runs;
+    for(int i = 0; i < repetitions; i++) {
+        timeRun(benchmark.body, iterations, &realSeconds, &cpuSeconds);
+        runs.push_back(std::make_pair(realSeconds, cpuSeconds));
+    }
+    std::sort(runs.begin(), runs.end());
+    const std::pair<double, double>& median = runs[runs.size() / 2];
+
+    benchmarkResult result;
+    result.name = benchmark.name;
+    result.iterations = iterations;
+    result.realNanoseconds = median.first * 1e9 / iterations;
+    result.cpuNanoseconds = median.second * 1e9 / iterations;
+    result.bytesPerSecond = benchmark.bytesPerIteration * iterations / median.first;
+    result.itemsPerSecond = benchmark.itemsPerIteration * iterations / median.first;
+    return result;
+}
+
+/**
+ * Appends a string to a buffer as a quoted JSON string. Benchmark names hold no characters which need escaping
+ * beyond quotes and backslashes.
+ * 
+ * @param[out] buffer a pointer to the buffer.
+ * @param value the string to append.
+ */
+static void appendJsonString(std::string* buffer, const std::string& value) {
+    buffer->push_back('"');
+    for(char c : value) {
+        if(c == '"' || c == '\\')
+            buffer->push_back('\\');
+        buffer->push_back(c);
+    }
+    buffer->push_back('"');
+}
+
+/**
+ * Formats the results in Google Benchmark's JSON layout.
+ * 
+ * @param results the results.
+ * @param executable the name of the benchmark executable.
+ * @return the JSON document.
+ */
+static std::string toJson(const std::vector<benchmarkResult>& results, const std::string& executable) {
+    char date[64];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    std::string json = "{\n  \"context\": {\n    \"date\": ";
+    appendJsonString(&json, date);
+    json += ",\n    \"executable\": ";
+    appendJsonString(&json, executable);
+    json += ",\n    \"num_cpus\": " + std::to_string(std::thread::hardware_concurrency());
+#ifdef NDEBUG
+    json += ",\n    \"library_build_type\": \"release\"";
+#else
+    json += ",\n    \"library_build_type\": \"debug\"";
+#endif
+    json += "\n  },\n  \"benchmarks\": [";
+    for(std::size_t i = 0; i < results.size(); i++) {
+        const benchmarkResult& result = results[i];
+        json += i == 0 ? "\n" : ",\n";
+        json += "    {\"name\": ";
+        appendJsonString(&json, result.name);
+        json += ", \"run_name\": ";
+        appendJsonString(&json, result.name);
+        json += ", \"run_type\": \"iteration\", \"iterations\": " + std::to_string(result.iterations);
+        json += ", \"real_time\": " + std::to_string(result.realNanoseconds);
+        json += ", \"cpu_time\": " + std::to_string(result.cpuNanoseconds);
+        json += ", \"time_unit\": \"ns\"";
+        if(result.bytesPerSecond > 0)
+            json += ", \"bytes_per_second\": " + std::to_string(result.bytesPerSecond);
+        if(result.itemsPerSecond > 0)
+            json += ", \"items_per_second\": " + std::to_string(result.itemsPerSecond);
+        json += "}";
+    }
+    json += "\n  ]\n}\n";
+    return json;
+}
+
+/**
+ * Runs a body on a number of threads, splitting the iterations between them.
+ * 
+ * @param threads the number of threads.
+ * @param iterations the total number of iterations.
+ * @param body the work of one thread, given the thread's index and its share of the iterations.
+ */
+static void runOnThreads(int threads, std::int64_t iterations, const std::function<void(int thread, std::int64_t share)>& body) {
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; t++) {
+        const std::int64_t share = iterations / threads + (t < iterations % threads ? 1 : 0);
+        workers.push_back(std::thread(body, t, share));
+    }
+    for(std::thread& worker : workers)
+        worker.join();
+}
+
+/**
+ * Adds the benchmarks which run once per page of the corpus.
+ * 
+ * @param pages the corpus.
+ * @param matcher the term matcher, loaded with terms.txt.
+ * @param[out] benchmarks a pointer to the list of benchmarks.
+ */
+static void addPageBenchmarks(const std::vector<corpusPage>& pages, TermMatcher* matcher, std::vector<benchmarkCase>* benchmarks) {
+    for(const corpusPage& page : pages) {
+        const corpusPage* p = &page;
+
+        // Runs the crawler's extraction, copies and queue included, and counts the domains found as items
+        const auto extractDomains = [p]() {
+            std::queue<std::string> extractedDomains;
+            DomainExtractor::extractDomains(p->chunks, &extractedDomains);
+            return extractedDomains.size();
+        };
+        benchmarks->push_back(benchmarkCase {"DomainExtractor/" + page.name, [extractDomains](std::int64_t iterations) {
+            for(std::int64_t i = 0; i < iterations; i++)
+                benchmarkSink = benchmarkSink + extractDomains();
+        }, (double)page.bytes, (double)extractDomains()});
+
+        const auto tokenizeLinks = [p]() {
+            LinkTokenizer tokenizer(false);
+            std::queue<htmlLink> links;
+            std::size_t found = 0;
+            for(const std::string& chunk : p->chunks) {
+                tokenizer.tokenize(chunk, &links);
+                found += links.size();
+                std::queue<htmlLink>().swap(links);
+            }
+            return found;
+        };
+        benchmarks->push_back(benchmarkCase {"LinkTokenizer/" + page.name, [tokenizeLinks](std::int64_t iterations) {
+            for(std::int64_t i = 0; i < iterations; i++)
+                benchmarkSink = benchmarkSink + tokenizeLinks();
+        }, (double)page.bytes, (double)tokenizeLinks()});
+
+        // The searcher stops at the required number of terms, while the crawler counts every term to score links
+        benchmarks->push_back(benchmarkCase {"TermMatcher/UntilRequired/" + page.name, [p, matcher](std::int64_t iterations) {
+            for(std::int64_t i = 0; i < iterations; i++)
+                benchmarkSink = benchmarkSink + matcher->matchTerms(p->chunks, false);
+        }, (double)page.bytes, 0});
+        benchmarks->push_back(benchmarkCase {"TermMatcher/AllTerms/" + page.name, [p, matcher](std::int64_t iterations) {
+            int termsFound = 0;
+            for(std::int64_t i = 0; i < iterations; i++) {
+                matcher->matchTerms(p->chunks, false, &termsFound);
+                benchmarkSink = benchmarkSink + termsFound;
+            }
+        }, (double)page.bytes, 0});
+    }
+}
+
+/**
+ * Adds the benchmarks of the thread-safe containers, at increasing thread counts.
+ * 
+ * @param[out] benchmarks a pointer to the list of benchmarks.
+ */
+static void addContainerBenchmarks(std::vector<benchmarkCase>* benchmarks) {
+    const int threadCounts[] = {1, 2, 4, 8};
+
+    for(int threads : threadCounts) {
+        // Every thread pushes then pops, so the queue stays short and the threads contend for its lock
+        benchmarks->push_back(benchmarkCase {"ThreadSafeQueue/PushPop/threads:" + std::to_string(threads), [threads](std::int64_t iterations) {
+            ThreadSafeQueue<std::string> queue;
+            runOnThreads(threads, iterations, [&queue](int thread, std::int64_t share) {
+                const std::string url = "https://pool.example.com/blocks/" + std::to_string(thread);
+                std::string popped;
+                std::size_t poppedBytes = 0;
+                for(std::int64_t i = 0; i < share; i++) {
+                    queue.push(url);
+                    if(queue.safePop(&popped))
+                        poppedBytes += popped.size();
+                }
+                benchmarkSink = benchmarkSink + poppedBytes;
+            });
+        }, 0, 1});
+
+        // Every key is new, so each insert grows the set
+        benchmarks->push_back(benchmarkCase {"ThreadSafeSet/SafeInsert/threads:" + std::to_string(threads), [threads](std::int64_t iterations) {
+            ThreadSafeSet<std::uint32_t> set;
+            runOnThreads(threads, iterations, [&set, threads](int thread, std::int64_t share) {
+                std::size_t inserted = 0;
+                for(std::int64_t i = 0; i < share; i++)
+                    inserted += set.safeInsert((std::uint32_t)(i * threads + thread));
+                benchmarkSink = benchmarkSink + inserted;
+            });
+        }, 0, 1});
+    }
+}
+
+int main(int argc, char** argv) {
+    // Curl hands the write callback at most 16 KB at a time, so pages are analysed in chunks of that size
+    const std::size_t curlChunkSize = 16384;
+    const int matcherRequiredTerms = 4;
+
+    std::string corpusDirectory = "benchmarks/corpus";
+    std::string filter;
+    std::string outputFile = "benchmark_results.json";
+    double minSeconds = 0.5;
+    int repetitions = 5;
+
+    for(int i = 1; i + 1 < argc; i += 2) {
+        const std::string option = argv[i];
+        if(option == "--corpus")
+            corpusDirectory = argv[i + 1];
+        else if(option == "--filter")
+            filter = argv[i + 1];
+        else if(option == "--min-time")
+            minSeconds = std::max(0.001, std::atof(argv[i + 1]));
+        else if(option == "--repetitions")
+            repetitions = std::max(1, std::atoi(argv[i + 1]));
+        else if(option == "--out")
+            outputFile = argv[i + 1];
+        else
+            std::cout << "ERROR: Unknown Option: " << option << "\n";
+    }
+
+    const std::vector<corpusPage> pages = loadCorpus(corpusDirectory, curlChunkSize);
+    if(pages.empty())
+        std::cout << "ERROR: No Corpus Pages Found In: " << corpusDirectory << "\n";
+    TermMatcher matcher(matcherRequiredTerms);
+
+    std::vector<benchmarkCase> benchmarks;
+    addPageBenchmarks(pages, &matcher, &benchmarks);
+    addContainerBenchmarks(&benchmarks);
+
+    std::vector<benchmarkResult> results;
+    std::printf("%-48s %14s %14s %12s %14s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations", "Throughput");
+    for(const benchmarkCase& benchmark : benchmarks) {
+        if(!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+            continue;
+        const benchmarkResult result = runBenchmark(benchmark, minSeconds, repetitions);
+        std::string throughput;
+        if(result.bytesPerSecond > 0)
+            throughput = std::to_string((long long)(result.bytesPerSecond / (1024 * 1024))) + " MiB/s";
+        else if(result.itemsPerSecond > 0)
+            throughput = std::to_string((long long)result.itemsPerSecond) + " ops/s";
+        std::printf("%-48s %14.0f %14.0f %12lld %14s\n", result.name.c_str(), result.realNanoseconds, result.cpuNanoseconds, (long long)result.iterations, throughput.c_str());
+        results.push_back(result);
+    }
+
+    std::ofstream output(outputFile, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    const std::string json = toJson(results, argv[0]);
+    if(!output.is_open() || !output.write(json.data(), json.size()))
+        std::cout << "ERROR: Could Not Write Benchmark Results: " << outputFile << "\n";
+    return 0;
+}
\ No newline at end of file
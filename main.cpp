@@ -9,6 +9,8 @@
 /**
  * getInitCrawlerQueue gets the initial crawler queue from a text file.
  * 
+ * Sources without a scheme are fetched over HTTPS.
+ * 
  * @param fileToRead the file to read.
  * @return the crawler queue built from the source file.
  */
@@ -17,7 +19,10 @@ void populateInitCrawlerQueue(std::string fileToRead, ThreadSafeQueue<std::strin
     std::string currentLine;
     std::ifstream crawlerInputer = std::ifstream(fileToRead);
     while(std::getline(crawlerInputer, currentLine)) {
-        initialCrawlerQueue->push(defaultProtocol + currentLine);
+        if(currentLine.find("://") == std::string::npos)
+            initialCrawlerQueue->push(defaultProtocol + currentLine);
+        else
+            initialCrawlerQueue->push(currentLine);
     }
 }
 
@@ -54,6 +59,7 @@ std::unordered_set<std::string> getStringSetFromFile(std::string fileToRead) {
  * terms.txt - the terms to search for
  * exclusions.txt - the exclusions
  * cacert.pem - the CA CERT
+ * public_suffix_list.dat - the Public Suffix List
  * libcurl-x64.dll - the libcurl library
  */
 int main(int argc, char** argv) {
@@ -0,0 +1,178 @@
+#include "../DomainExtractor.h"
+#include <algorithm>
+#include <boost/regex.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * DomainExtractorDifferential checks DomainExtractor against the regular expression it replaced.
+ * 
+ * Both are run over the same inputs, and the domains and top level domains they find must be identical. Inputs are
+ * random strings over the characters the expression distinguishes, and the pages of the benchmark corpus, split into
+ * chunks the way curl delivers them. The expression is run as Crawler ran it, except that the `(` check reads the
+ * character right after the match, which is what the scanner does and what the original comment intended.
+ * 
+ * Usage: DomainExtractorDifferential [--corpus <directory>] [--inputs <count>] [--seed <seed>]
+ * 
+ * Exits with 0 if every input matched, and 1 otherwise.
+ */
+
+// A domain and its top level domain, as found in an input
+typedef std::pair<std::string, std::string> candidate;
+
+/**
+ * Finds the candidates of an input with the expression Crawler used before DomainExtractor.
+ * 
+ * @param data the input.
+ * @return the candidates, in order.
+ */
+static std::vector<candidate> regexCandidates(const std::string& data) {
+    static const boost::regex expression(R"([^\w\.\-]([\w-]+?\.(([\w-]+?\.)+)?([a-zA-Z]+|XN--[A-Za-z0-9]+)))");
+
+    std::vector<candidate> candidates;
+    boost::sregex_iterator end;
+    for(boost::sregex_iterator i(data.begin(), data.end(), expression); i != end; i++) {
+        const boost::smatch& match = *i;
+        const std::string suffix = match.suffix();
+        if(!suffix.empty() && suffix[0] == '(')
+            continue;
+        candidates.push_back(candidate(match.str(1), match.str(4)));
+    }
+    return candidates;
+}
+
+/**
+ * Finds the candidates of an input with DomainExtractor.
+ * 
+ * @param data the input.
+ * @return the candidates, in order.
+ */
+static std::vector<candidate> scannerCandidates(const std::string& data) {
+    std::vector<candidate> candidates;
+    DomainExtractor extractor(data);
+    std::string_view domain;
+    std::string_view topLevelDomain;
+    while(extractor.nextCandidate(&domain, &topLevelDomain))
+        candidates.push_back(candidate(std::string(domain), std::string(topLevelDomain)));
+    return candidates;
+}
+
+/**
+ * Formats candidates for a mismatch report.
+ * 
+ * @param candidates the candidates.
+ * @return the candidates, one "domain (top level domain)" per entry, separated by spaces.
+ */
+static std::string describe(const std::vector<candidate>& candidates) {
+    std::string description;
+    for(const candidate& it : candidates)
+        description += " " + it.first + " (" + it.second + ")";
+    return description.empty() ? " none" : description;
+}
+
+/**
+ * Generates a random input. The alphabet holds letters, other label characters, dots and delimiters, with a bias
+ * towards dots so that chains of labels are common.
+ * 
+ * @param generator the random generator.
+ * @return the input.
+ */
+static std::string randomInput(std::mt19937_64* generator) {
+    static const std::string alphabet = "abcxyzXNQ019_-....  /:\"'(<>=\n";
+    const std::size_t maxLength = 64;
+
+    std::uniform_int_distribution<std::size_t> length(0, maxLength);
+    std::uniform_int_distribution<std::size_t> character(0, alphabet.size() - 1);
+    std::string input(length(*generator), ' ');
+    for(char& c : input)
+        c = alphabet[character(*generator)];
+    return input;
+}
+
+/**
+ * Loads every HTML page in a directory, split into chunks.
+ * 
+ * @param directory the corpus directory.
+ * @param chunkSize the size of the chunks the pages are split into.
+ * @return the chunks of every page.
+ */
+static std::vector<std::string> loadCorpus(const std::string& directory, std::size_t chunkSize) {
+    std::vector<std::filesystem::path> paths;
+    std::error_code error;
+    for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error)) {
+        if(entry.path().extension() == ".html")
+            paths.push_back(entry.path());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<std::string> chunks;
+    for(const std::filesystem::path& path : paths) {
+        std::ifstream file(path, std::ifstream::binary);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        const std::string page = contents.str();
+        for(std::size_t i = 0; i < page.size(); i += chunkSize)
+            chunks.push_back(page.substr(i, chunkSize));
+    }
+    return chunks;
+}
+
+int main(int argc, char** argv) {
+    // Curl hands the write callback at most 16 KB at a time, so pages are checked in chunks of that size
+    const std::size_t curlChunkSize = 16384;
+    const int maxReportedMismatches = 10;
+
+    std::string corpusDirectory = "benchmarks/corpus";
+    long long inputCount = 300000;
+    std::uint64_t seed = 1;
+
+    for(int i = 1; i + 1 < argc; i += 2) {
+        const std::string option = argv[i];
+        if(option == "--corpus")
+            corpusDirectory = argv[i + 1];
+        else if(option == "--inputs")
+            inputCount = std::max(0LL, std::atoll(argv[i + 1]));
+        else if(option == "--seed")
+            seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else
+            std::cout << "ERROR: Unknown Option: " << option << "\n";
+    }
+
+    std::vector<std::string> inputs = loadCorpus(corpusDirectory, curlChunkSize);
+    if(inputs.empty())
+        std::cout << "ERROR: No Corpus Pages Found In: " << corpusDirectory << "\n";
+    const std::size_t corpusChunks = inputs.size();
+
+    std::mt19937_64 generator(seed);
+    for(long long i = 0; i < inputCount; i++)
+        inputs.push_back(randomInput(&generator));
+
+    int mismatches = 0;
+    std::size_t candidates = 0;
+    for(const std::string& input : inputs) {
+        const std::vector<candidate> expected = regexCandidates(input);
+        const std::vector<candidate> found = scannerCandidates(input);
+        candidates += expected.size();
+        if(expected == found)
+            continue;
+
+        if(mismatches < maxReportedMismatches) {
+            std::cout << "MISMATCH: Input: \"" << input.substr(0, 200) << "\"\n";
+            std::cout << "    Expression:" << describe(expected) << "\n";
+            std::cout << "    Scanner:" << describe(found) << "\n";
+        }
+        mismatches++;
+    }
+
+    std::cout << "Checked " << corpusChunks << " corpus chunks and " << inputCount << " random inputs (seed " << seed << "), " << candidates << " candidates, " << mismatches << " mismatches\n";
+    return mismatches == 0 ? 0 : 1;
+}
\ No newline at end of file